@@ -0,0 +1,826 @@
+﻿// observer.cpp : 이 파일에는 'main' 함수가 포함됩니다. 거기서 프로그램 실행이 시작되고 종료됩니다.
+//
+
+#include <iostream>
+#include <memory>
+#include <random>
+#include <ctime>
+#include <functional>
+#include <list>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <stdexcept>
+
+using namespace std;
+
+struct SensorData {
+	float temp;
+	float humidity;
+	float pressure;
+	float temp_top;
+	float temp_bottom;
+};
+
+class IObserver {
+public:
+	//여러 생산자 스레드에서 동시에 호출될 수 있다
+	virtual void update(const SensorData& sensorData) = 0;
+};
+
+//등록된 옵저버를 가리키는 핸들 (슬롯 번호 + 세대)
+//제거된 뒤 같은 슬롯이 재사용되면 세대가 달라지므로 예전 핸들은 무효가 된다
+struct ObserverHandle {
+	uint32_t index = UINT32_MAX;
+	uint32_t generation = 0;
+};
+
+//핸들 -> 옵저버 배열 위치 표
+//배열에서 옵저버를 지우거나 옮기면 setDenseIndex() 로 위치를 고친다
+class SlotTable {
+private:
+	static const uint32_t INVALID_INDEX = UINT32_MAX;
+
+	struct Slot {
+		uint32_t denseIndex; //옵저버 배열 안의 위치 (INVALID_INDEX 이면 빈 슬롯)
+		uint32_t generation; //슬롯 재사용 횟수
+	};
+
+	vector<Slot> _slots;
+	vector<uint32_t> _freeSlots; //재사용할 빈 슬롯 번호
+
+public:
+	ObserverHandle allocate(uint32_t denseIndex) {
+		uint32_t slotIndex;
+		if (_freeSlots.empty()) {
+			slotIndex = static_cast<uint32_t>(_slots.size());
+			_slots.push_back(Slot{ INVALID_INDEX, 0 });
+		}
+		else {
+			slotIndex = _freeSlots.back();
+			_freeSlots.pop_back();
+		}
+		_slots[slotIndex].denseIndex = denseIndex;
+		return ObserverHandle{ slotIndex, _slots[slotIndex].generation };
+	}
+
+	bool contains(ObserverHandle handle) const {
+		return handle.index < _slots.size()
+			&& _slots[handle.index].denseIndex != INVALID_INDEX
+			&& _slots[handle.index].generation == handle.generation;
+	}
+
+	uint32_t getDenseIndex(ObserverHandle handle) const {
+		return _slots[handle.index].denseIndex;
+	}
+
+	void setDenseIndex(uint32_t slotIndex, uint32_t denseIndex) {
+		_slots[slotIndex].denseIndex = denseIndex;
+	}
+
+	void free(ObserverHandle handle) {
+		Slot& slot = _slots[handle.index];
+		slot.denseIndex = INVALID_INDEX;
+		slot.generation++;
+		_freeSlots.push_back(handle.index);
+	}
+};
+
+//구독 토큰이 가리키는 옵저버 저장소
+class IRegistry {
+public:
+	virtual ~IRegistry() = default;
+	virtual bool contains(ObserverHandle handle) const = 0;
+	virtual bool erase(ObserverHandle handle) = 0;
+};
+
+//registerObserver() 가 돌려주는 구독 토큰
+//토큰이 소멸되거나 release() 를 호출하면 구독이 해제된다
+//주제 객체가 먼저 사라져도 안전하도록 저장소는 weak_ptr 로 가리킨다
+class Subscription {
+private:
+	weak_ptr<IRegistry> _registry;
+	ObserverHandle _handle;
+
+public:
+	Subscription() = default;
+
+	Subscription(weak_ptr<IRegistry> registry, ObserverHandle handle)
+		: _registry(move(registry)), _handle(handle) {
+	}
+
+	Subscription(const Subscription&) = delete;
+	Subscription& operator=(const Subscription&) = delete;
+
+	Subscription(Subscription&& r) noexcept
+		: _registry(move(r._registry)), _handle(r._handle) {
+		r._registry.reset();
+	}
+
+	Subscription& operator=(Subscription&& r) noexcept {
+		if (this != &r) {
+			release();
+			_registry = move(r._registry);
+			_handle = r._handle;
+			r._registry.reset();
+		}
+		return *this;
+	}
+
+	~Subscription() {
+		release();
+	}
+
+	//구독 해제
+	void release() {
+		if (shared_ptr<IRegistry> pRegistry = _registry.lock()) {
+			pRegistry->erase(_handle);
+		}
+		_registry.reset();
+	}
+
+	//토큰과의 연결만 끊고 구독은 주제 객체가 사라질 때까지 유지한다
+	void detach() {
+		_registry.reset();
+	}
+
+	bool isActive() const {
+		shared_ptr<IRegistry> pRegistry = _registry.lock();
+		return pRegistry && pRegistry->contains(_handle);
+	}
+};
+
+class ISubject {
+
+public:
+	//옵저버 등록 : 반환된 토큰이 살아있는 동안만 구독이 유지된다
+	[[nodiscard]] virtual Subscription registerObserver(shared_ptr<IObserver> pObserver) = 0;
+
+	//옵저버 제거
+	virtual void removeObserver(Subscription& subscription) = 0;
+
+	//변경 사실을 알린다
+	//생산자 스레드끼리 공유하는 값이 없도록 측정값을 인자로 넘긴다
+	virtual void notifyObserver(const SensorData& sensorData) = 0;
+};
+
+//읽기 구역(epoch) 기반 메모리 회수
+//읽는 쪽은 자기 슬롯에 현재 epoch 를 적고, 빠져나올 때 0 으로 지운다 (잠금 없음)
+//쓰는 쪽은 교체된 객체를 epoch 와 함께 보관해 두었다가
+//그 epoch 이전부터 읽고 있던 스레드가 모두 빠져나간 뒤에 해제한다
+//읽는 스레드가 MAX_READERS 개를 넘으면 슬롯을 힙에 더 만든다 (더한 슬롯은 돌려받아 재사용하고 해제하지 않는다)
+class EpochDomain {
+private:
+	static const int MAX_READERS = 256;
+
+	//슬롯끼리 캐시 라인을 공유하지 않도록 정렬한다
+	struct alignas(64) ReaderSlot {
+		atomic<uint64_t> epoch{ 0 }; //0 이면 읽는 중이 아님
+		atomic<bool> used{ false };
+		int depth = 0;               //같은 스레드에서 중첩된 읽기 구역 수 (소유 스레드만 접근)
+		ReaderSlot* pNext = nullptr; //더한 슬롯 목록의 다음 슬롯 (목록에 넣은 뒤에는 바뀌지 않는다)
+	};
+
+	//스레드마다 슬롯 하나를 차지하고, 스레드가 끝나면 돌려준다
+	class ThreadSlot {
+	private:
+		ReaderSlot* _pSlot = nullptr;
+
+	public:
+		ReaderSlot& get(EpochDomain& domain) {
+			if (_pSlot == nullptr) {
+				_pSlot = &domain.acquireSlot();
+			}
+			return *_pSlot;
+		}
+
+		~ThreadSlot() {
+			if (_pSlot != nullptr) {
+				_pSlot->used.store(false);
+			}
+		}
+	};
+
+	ReaderSlot _slots[MAX_READERS];
+	atomic<ReaderSlot*> _extraSlots{ nullptr }; //고정 슬롯이 모자랄 때 더한 슬롯 (앞에 넣기만 하므로 잠금 없이 훑는다)
+	atomic<uint64_t> _globalEpoch{ 1 };
+
+	ReaderSlot& acquireSlot() {
+		for (ReaderSlot& slot : _slots) {
+			bool expected = false;
+			if (slot.used.compare_exchange_strong(expected, true)) {
+				return slot;
+			}
+		}
+		for (ReaderSlot* pSlot = _extraSlots.load(); pSlot != nullptr; pSlot = pSlot->pNext) {
+			bool expected = false;
+			if (pSlot->used.compare_exchange_strong(expected, true)) {
+				return *pSlot;
+			}
+		}
+
+		ReaderSlot* pSlot = new ReaderSlot();
+		pSlot->used.store(true);
+		pSlot->pNext = _extraSlots.load();
+		while (!_extraSlots.compare_exchange_weak(pSlot->pNext, pSlot)) {
+		}
+		return *pSlot;
+	}
+
+	static bool isBefore(const ReaderSlot& slot, uint64_t retireEpoch) {
+		uint64_t epoch = slot.epoch.load();
+		return epoch != 0 && epoch < retireEpoch;
+	}
+
+	ReaderSlot& currentSlot() {
+		static thread_local ThreadSlot threadSlot;
+		return threadSlot.get(*this);
+	}
+
+public:
+	~EpochDomain() {
+		ReaderSlot* pSlot = _extraSlots.load();
+		while (pSlot != nullptr) {
+			ReaderSlot* pNext = pSlot->pNext;
+			delete pSlot;
+			pSlot = pNext;
+		}
+	}
+
+	static EpochDomain& instance() {
+		static EpochDomain domain;
+		return domain;
+	}
+
+	//읽기 구역 : 생성~소멸 사이에 읽은 객체는 해제되지 않는다
+	class ReadGuard {
+	private:
+		ReaderSlot& _slot;
+
+	public:
+		ReadGuard() : _slot(EpochDomain::instance().currentSlot()) {
+			if (_slot.depth++ == 0) {
+				_slot.epoch.store(EpochDomain::instance()._globalEpoch.load());
+			}
+		}
+
+		~ReadGuard() {
+			if (--_slot.depth == 0) {
+				_slot.epoch.store(0);
+			}
+		}
+
+		ReadGuard(const ReadGuard&) = delete;
+		ReadGuard& operator=(const ReadGuard&) = delete;
+	};
+
+	//이 스레드가 읽기 구역 안에 있으면 true
+	bool isReading() {
+		return currentSlot().depth > 0;
+	}
+
+	//교체가 끝난 뒤 호출해서 회수 기준 epoch 를 얻는다
+	uint64_t advance() {
+		return _globalEpoch.fetch_add(1) + 1;
+	}
+
+	//retireEpoch 이전부터 읽는 중인 스레드가 없으면 true
+	bool isSafe(uint64_t retireEpoch) const {
+		for (const ReaderSlot& slot : _slots) {
+			if (isBefore(slot, retireEpoch)) {
+				return false;
+			}
+		}
+		for (const ReaderSlot* pSlot = _extraSlots.load(); pSlot != nullptr; pSlot = pSlot->pNext) {
+			if (isBefore(*pSlot, retireEpoch)) {
+				return false;
+			}
+		}
+		return true;
+	}
+};
+
+class Random {
+private:
+	// 시드값을 얻기 위한 random_device 생성.
+	random_device _rd;
+
+	// random_device 를 통해 난수 생성 엔진을 초기화 한다.
+	// getValue() const 에서 상태를 바꾸므로 mutable 로 선언한다
+	mutable mt19937 _generator;
+
+	// 예 :  0 부터 99 까지 균등하게 나타나는 난수열을 생성하기 위해 균등 분포 정의.
+	mutable uniform_int_distribution<int> _distribution;
+
+public:
+	Random(int from, int to) : _generator{ _rd() },
+		_distribution{from, to} {
+
+	}
+
+	int getValue() const {
+		return _distribution(_generator);
+	}
+};
+
+class WeatherStation {
+private:
+	Random _randomTemperature; //온도 난수 객체
+	Random _randomHumidity; //습도 난수 객체
+	Random _randomPressure; //압력 난수 객체
+
+public :
+	WeatherStation() : _randomTemperature{ -50, 50 }
+		, _randomHumidity{ -100, 100 }
+		, _randomPressure{ -100, 100 } {
+	}
+
+	float getTemperature() const {
+		return 25.0f + _randomTemperature.getValue() / 10.0f;
+	}
+	float getHumidity() const {
+		return 60.0f + _randomHumidity.getValue() / 10.0f;
+	};
+	float getPressure() const {
+		return 25.0f +  _randomPressure.getValue() / 10.0f;
+	};
+
+};
+
+class StatisticsDisplay : public IObserver {
+private:
+	float _maxTemp = 0.0f;
+	float _minTemp = 100.0f;
+	float _tempSum = 0.0f;
+	int _numReadings = 0;
+
+public:
+	void update(const SensorData& sensorData) override {
+		update(sensorData.temp, sensorData.humidity, sensorData.pressure);
+	}
+
+	void update(float temp, float humidity, float pressure) {
+		_tempSum += temp;
+		_numReadings++;
+
+		if (temp > _maxTemp) {
+			_maxTemp = temp;
+		}
+
+		if (temp < _minTemp) {
+			_minTemp = temp;
+		}
+
+		display();
+	}
+
+	void display() {
+		cout << "기상 통계 " << endl
+			<< "평균 기온 : " << (_tempSum / _numReadings) << "℃" << endl
+			<< "최저 기온 : " << _minTemp << "℃" << endl
+			<< "최고 기온 : " << _maxTemp << "℃" << endl << endl;
+	}
+};
+
+class CurrentConditionsDisplay : public IObserver {
+private:
+	float _temperature;
+	float _humidity;
+	float _pressure;
+
+public:
+	void update(const SensorData& sensorData) override {
+		update(sensorData.temp, sensorData.humidity, sensorData.pressure);
+	}
+
+	void update(float temperature, float humidity, float pressure) {
+		_temperature = temperature;
+		_humidity = humidity;
+		_pressure = pressure;
+		display();
+	}
+
+	void display() {
+		cout << "현재 조건 " << endl
+			<< "온도: " << _temperature << "℃" << endl
+			<< "습도: " << _humidity << "%" << endl
+			<< "기압: " << _pressure << endl << endl;
+
+	}
+};
+
+class ForecastDisplay : public IObserver {
+private:
+	float _currentPressure = 29.92f;
+	float _lastPressure;
+
+public:
+	void update(const SensorData& sensorData) override {
+		update(sensorData.temp, sensorData.humidity, sensorData.pressure);
+	}
+
+	void update(float temp, float humidity, float pressure) {
+		_lastPressure = _currentPressure;
+		_currentPressure = pressure;
+
+		display();
+	}
+
+	void display() {
+		cout << "기상 예보" << endl;
+		if (_currentPressure > _lastPressure) {
+			cout << "가는 길에 날씨 개선" << endl << endl;
+		}
+		else if (_currentPressure == _lastPressure) {
+			cout << "전과 같음" << endl << endl;
+		}
+		else if (_currentPressure < _lastPressure) {
+			cout << "선선하고 비오는 날씨에 조심하십시오" << endl << endl;
+		}
+	}
+};
+
+
+//동시성을 지원하는 옵저버 저장소
+//통보는 현재 옵저버 목록 스냅샷(불변)을 원자적으로 읽기만 하므로 잠금을 잡지 않는다
+//등록/제거는 스냅샷을 복사해 수정한 뒤 포인터를 바꿔 끼운다 (RCU 방식, 쓰기끼리만 잠금)
+//제거할 옵저버는 핸들 -> 위치 표로 바로 찾는다 (포인터로 목록을 훑지 않는다)
+class SnapshotRegistry : public IRegistry {
+private:
+	//한 번 공개된 스냅샷은 수정하지 않는다
+	struct Snapshot {
+		vector<IObserver*> observers;         //통보할 때 순회하는 연속 배열
+		vector<shared_ptr<IObserver>> owners; //스냅샷이 살아있는 동안 옵저버 수명 유지
+		vector<uint32_t> slotIndices;         //배열 위치 -> 슬롯 번호
+	};
+
+	//교체된 스냅샷과 회수 기준 epoch
+	struct Retired {
+		Snapshot* pSnapshot;
+		uint64_t epoch;
+	};
+
+	atomic<Snapshot*> _current;
+	mutable mutex _writeMutex; //등록/제거끼리만 직렬화한다
+	SlotTable _slotTable;      //_writeMutex 로 보호한다
+	vector<Retired> _retired;
+	atomic<size_t> _retiredCount{ 0 }; //통보 쪽이 잠금 없이 회수할 것이 있는지 본다
+
+	//잠금을 잡은 채로 호출한다 : 안전해진 예전 스냅샷을 꺼낸다
+	void collectReclaimable(vector<Snapshot*>& reclaimable) {
+		auto it = _retired.begin();
+		while (it != _retired.end()) {
+			if (EpochDomain::instance().isSafe(it->epoch)) {
+				reclaimable.push_back(it->pSnapshot);
+				it = _retired.erase(it);
+			}
+			else {
+				++it;
+			}
+		}
+		_retiredCount.store(_retired.size());
+	}
+
+	//잠금 밖에서 해제한다 (옵저버 소멸자가 다시 등록/제거를 할 수 있다)
+	static void destroy(vector<Snapshot*>& reclaimable) {
+		for (Snapshot* pSnapshot : reclaimable) {
+			delete pSnapshot;
+		}
+	}
+
+	//스냅샷을 복사해서 수정한 뒤 교체한다
+	template <typename Modify>
+	void replaceSnapshot(Modify&& modify) {
+		vector<Snapshot*> reclaimable;
+		{
+			lock_guard<mutex> lock(_writeMutex);
+
+			Snapshot* pOld = _current.load();
+			Snapshot* pNew = new Snapshot(*pOld);
+			modify(*pNew);
+
+			_current.store(pNew);
+			_retired.push_back(Retired{ pOld, EpochDomain::instance().advance() });
+			collectReclaimable(reclaimable);
+		}
+		destroy(reclaimable);
+	}
+
+	//교체 때 읽는 중이던 스레드가 있어 남겨 둔 스냅샷을 회수한다
+	//통보가 끝날 때 부르므로 다른 스레드가 등록/제거 중이면 기다리지 않고 넘어간다
+	void tryReclaim() {
+		vector<Snapshot*> reclaimable;
+		{
+			unique_lock<mutex> lock(_writeMutex, try_to_lock);
+			if (!lock.owns_lock()) {
+				return;
+			}
+			collectReclaimable(reclaimable);
+		}
+		destroy(reclaimable);
+	}
+
+public:
+	SnapshotRegistry() : _current(new Snapshot()) {
+	}
+
+	//통보 중인 스레드가 없을 때 소멸되어야 한다
+	~SnapshotRegistry() {
+		delete _current.load();
+		for (Retired& retired : _retired) {
+			delete retired.pSnapshot;
+		}
+	}
+
+	SnapshotRegistry(const SnapshotRegistry&) = delete;
+	SnapshotRegistry& operator=(const SnapshotRegistry&) = delete;
+
+	//옵저버 등록 : O(n) 복사
+	ObserverHandle insert(shared_ptr<IObserver> pObserver) {
+		ObserverHandle handle;
+		replaceSnapshot([this, &pObserver, &handle](Snapshot& snapshot) {
+			handle = _slotTable.allocate(static_cast<uint32_t>(snapshot.observers.size()));
+			snapshot.observers.push_back(pObserver.get());
+			snapshot.owners.push_back(move(pObserver));
+			snapshot.slotIndices.push_back(handle.index);
+		});
+		return handle;
+	}
+
+	bool contains(ObserverHandle handle) const override {
+		lock_guard<mutex> lock(_writeMutex);
+		return _slotTable.contains(handle);
+	}
+
+	//옵저버 제거 : 위치는 핸들로 O(1) 에 찾고, 스냅샷 복사는 O(n)
+	bool erase(ObserverHandle handle) override {
+		bool erased = false;
+		replaceSnapshot([this, handle, &erased](Snapshot& snapshot) {
+			if (!_slotTable.contains(handle)) {
+				return;
+			}
+			uint32_t denseIndex = _slotTable.getDenseIndex(handle);
+			snapshot.observers.erase(snapshot.observers.begin() + denseIndex);
+			snapshot.owners.erase(snapshot.owners.begin() + denseIndex);
+			snapshot.slotIndices.erase(snapshot.slotIndices.begin() + denseIndex);
+			for (size_t idx = denseIndex; idx < snapshot.slotIndices.size(); idx++) {
+				_slotTable.setDenseIndex(snapshot.slotIndices[idx], static_cast<uint32_t>(idx));
+			}
+			_slotTable.free(handle);
+			erased = true;
+		});
+		return erased;
+	}
+
+	//잠금 없음, 할당 없음
+	//가장 바깥 읽기 구역을 빠져나올 때 남아 있는 예전 스냅샷이 있으면 회수한다
+	//(제거 뒤에 등록/제거가 더 없어도 옵저버가 WeatherData 소멸 때까지 남지 않는다)
+	template <typename Func>
+	void forEach(Func&& func) {
+		{
+			EpochDomain::ReadGuard guard;
+			const Snapshot* pSnapshot = _current.load();
+			for (IObserver* pObserver : pSnapshot->observers) {
+				func(*pObserver);
+			}
+		}
+		if (_retiredCount.load(memory_order_relaxed) != 0 && !EpochDomain::instance().isReading()) {
+			tryReclaim();
+		}
+	}
+
+	size_t size() const {
+		EpochDomain::ReadGuard guard;
+		return _current.load()->observers.size();
+	}
+};
+
+class WeatherData : public ISubject {
+private:
+	//구독 토큰이 weak_ptr 로 가리킬 수 있도록 shared_ptr 로 보관한다
+	shared_ptr<SnapshotRegistry> _registry = make_shared<SnapshotRegistry>();
+
+public:
+	//옵저버 등록 : O(n) 복사
+	Subscription registerObserver(shared_ptr<IObserver> pObserver) override {
+		return Subscription(_registry, _registry->insert(move(pObserver)));
+	}
+
+	//옵저버 제거
+	void removeObserver(Subscription& subscription) override {
+		subscription.release();
+	}
+
+	//변경 사실을 알린다 : 잠금 없음, 할당 없음
+	void notifyObserver(const SensorData& sensorData) override {
+		_registry->forEach([&sensorData](IObserver& observer) {
+			observer.update(sensorData);
+		});
+	}
+
+	size_t getObserverCount() const {
+		return _registry->size();
+	}
+
+	void measurementsChanged(const SensorData& sensorData) {
+		notifyObserver(sensorData);
+	}
+
+	//호출한 스레드의 측정 장비로 값을 읽는다
+	//WeatherStation 은 스레드 안전하지 않으므로 스레드마다 하나씩 둔다
+	void readMeasurements() {
+		static thread_local WeatherStation weatherStation;
+
+		SensorData sensorData{};
+		sensorData.temp = weatherStation.getTemperature();
+		sensorData.humidity = weatherStation.getHumidity();
+		sensorData.pressure = weatherStation.getPressure();
+
+		measurementsChanged(sensorData);
+	}
+};
+
+//비교용 : 큰 잠금 하나로 모든 호출을 직렬화하는 주제 객체
+class LockedRegistry : public IRegistry {
+private:
+	vector<shared_ptr<IObserver>> _observers;
+	vector<uint32_t> _slotIndices; //배열 위치 -> 슬롯 번호
+	SlotTable _slotTable;
+	mutable mutex _mutex;
+
+public:
+	ObserverHandle insert(shared_ptr<IObserver> pObserver) {
+		lock_guard<mutex> lock(_mutex);
+		ObserverHandle handle = _slotTable.allocate(static_cast<uint32_t>(_observers.size()));
+		_observers.push_back(move(pObserver));
+		_slotIndices.push_back(handle.index);
+		return handle;
+	}
+
+	bool contains(ObserverHandle handle) const override {
+		lock_guard<mutex> lock(_mutex);
+		return _slotTable.contains(handle);
+	}
+
+	bool erase(ObserverHandle handle) override {
+		shared_ptr<IObserver> pRemoved;
+		{
+			lock_guard<mutex> lock(_mutex);
+			if (!_slotTable.contains(handle)) {
+				return false;
+			}
+			uint32_t denseIndex = _slotTable.getDenseIndex(handle);
+			pRemoved = move(_observers[denseIndex]);
+			_observers.erase(_observers.begin() + denseIndex);
+			_slotIndices.erase(_slotIndices.begin() + denseIndex);
+			for (size_t idx = denseIndex; idx < _slotIndices.size(); idx++) {
+				_slotTable.setDenseIndex(_slotIndices[idx], static_cast<uint32_t>(idx));
+			}
+			_slotTable.free(handle);
+		}
+		//옵저버 소멸은 잠금 밖에서
+		return true;
+	}
+
+	void notify(const SensorData& sensorData) {
+		lock_guard<mutex> lock(_mutex);
+		for (auto& pObserver : _observers) {
+			pObserver->update(sensorData);
+		}
+	}
+};
+
+class LockedWeatherData : public ISubject {
+private:
+	shared_ptr<LockedRegistry> _registry = make_shared<LockedRegistry>();
+
+public:
+	Subscription registerObserver(shared_ptr<IObserver> pObserver) override {
+		return Subscription(_registry, _registry->insert(move(pObserver)));
+	}
+
+	void removeObserver(Subscription& subscription) override {
+		subscription.release();
+	}
+
+	void notifyObserver(const SensorData& sensorData) override {
+		_registry->notify(sensorData);
+	}
+};
+
+//벤치마크용 옵저버 : 임계값을 넘을 때만 공유 카운터를 쓴다 (측정 중에는 넘지 않는다)
+class AlarmObserver : public IObserver {
+private:
+	float _threshold;
+	atomic<size_t> _alarmCount{ 0 };
+
+public:
+	AlarmObserver(float threshold) : _threshold(threshold) {
+	}
+
+	void update(const SensorData& sensorData) override {
+		if (sensorData.temp > _threshold) {
+			_alarmCount.fetch_add(1, memory_order_relaxed);
+		}
+	}
+};
+
+//생산자 producerCount 개가 동시에 통보하고, 제어 스레드 하나가 계속 등록/제거를 한다
+//전체 초당 통보 횟수를 돌려준다
+double benchmarkProducers(ISubject& subject, int producerCount) {
+	const int readingsPerProducer = 100000;
+
+	atomic<bool> start{ false };
+	atomic<int> finished{ 0 };
+
+	vector<thread> producers;
+	for (int idx = 0; idx < producerCount; idx++) {
+		producers.emplace_back([&subject, &start, &finished, idx]() {
+			SensorData sensorData{ 20.0f + idx, 60.0f, 25.0f, 0.0f, 0.0f };
+			while (!start.load()) {
+				this_thread::yield();
+			}
+			for (int reading = 0; reading < readingsPerProducer; reading++) {
+				subject.notifyObserver(sensorData);
+			}
+			finished.fetch_add(1);
+		});
+	}
+
+	//대시보드가 붙었다 떨어지는 상황을 흉내낸다
+	thread control([&subject, &start, &finished, producerCount]() {
+		shared_ptr<IObserver> pDashboard = make_shared<AlarmObserver>(1000.0f);
+		while (!start.load()) {
+			this_thread::yield();
+		}
+		while (finished.load() < producerCount) {
+			Subscription subscription = subject.registerObserver(pDashboard);
+			this_thread::sleep_for(chrono::microseconds(100));
+			subject.removeObserver(subscription);
+		}
+	});
+
+	auto begin = chrono::steady_clock::now();
+	start.store(true);
+	for (thread& producer : producers) {
+		producer.join();
+	}
+	auto end = chrono::steady_clock::now();
+	control.join();
+
+	double seconds = chrono::duration<double>(end - begin).count();
+	return producerCount * readingsPerProducer / seconds;
+}
+
+int main(int argc, char** argv) {
+
+	shared_ptr<WeatherData> pWeatherData = make_shared<WeatherData>();
+	//출력 장치 객체 생성 (출력 장치는 스레드 안전하지 않으므로 이 예제는 생산자 1개로 실행한다)
+	shared_ptr<StatisticsDisplay> pStatisticsDisplay = make_shared<StatisticsDisplay>();
+	shared_ptr<CurrentConditionsDisplay> pCurrentConditionsDisplay = make_shared<CurrentConditionsDisplay>();
+	shared_ptr<ForecastDisplay> pForecastDisplay = make_shared<ForecastDisplay>();
+
+	//출력 장치를 등록한다
+	Subscription statisticsSubscription = pWeatherData->registerObserver(pStatisticsDisplay);
+	Subscription currentConditionsSubscription = pWeatherData->registerObserver(pCurrentConditionsDisplay);
+	Subscription forecastSubscription = pWeatherData->registerObserver(pForecastDisplay);
+
+	//측정값을 읽는다
+	pWeatherData->readMeasurements(); //등록된 3개의 출력 장치에 값을 출력한다
+	pWeatherData->readMeasurements();
+	pWeatherData->readMeasurements();
+
+	//출력 장치를 제거한다
+	pWeatherData->removeObserver(forecastSubscription);
+
+	//측정값을 읽는다
+	pWeatherData->readMeasurements(); //등록된 2개의 출력 장치에 값을 출력한다
+	pWeatherData->readMeasurements();
+	pWeatherData->readMeasurements();
+
+	//생산자 수에 따른 처리량 측정 (옵저버 100개)
+	int maxProducers = max(4, static_cast<int>(thread::hardware_concurrency()));
+	for (int producerCount = 1; producerCount <= maxProducers; producerCount *= 2) {
+		WeatherData weatherData;
+		LockedWeatherData lockedWeatherData;
+		vector<Subscription> subscriptions;
+		for (int idx = 0; idx < 100; idx++) {
+			shared_ptr<IObserver> pObserver = make_shared<AlarmObserver>(1000.0f);
+			subscriptions.push_back(weatherData.registerObserver(pObserver));
+			subscriptions.push_back(lockedWeatherData.registerObserver(pObserver));
+		}
+
+		double lockedRate = benchmarkProducers(lockedWeatherData, producerCount);
+		double lockFreeRate = benchmarkProducers(weatherData, producerCount);
+
+		cout << "생산자 " << producerCount << "개 : "
+			<< "큰 잠금 " << static_cast<long long>(lockedRate) << " 회/초, "
+			<< "스냅샷 " << static_cast<long long>(lockFreeRate) << " 회/초" << endl;
+	}
+
+	return 0;
+}
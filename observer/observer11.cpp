@@ -0,0 +1,957 @@
+﻿// observer.cpp : 이 파일에는 'main' 함수가 포함됩니다. 거기서 프로그램 실행이 시작되고 종료됩니다.
+//
+
+#include <iostream>
+#include <memory>
+#include <random>
+#include <ctime>
+#include <functional>
+#include <list>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+
+using namespace std;
+
+struct SensorData {
+	float temp;
+	float humidity;
+	float pressure;
+	float temp_top;
+	float temp_bottom;
+};
+
+class IObserver {
+public:
+	virtual void update(const SensorData& sensorData) = 0;
+};
+
+//등록된 옵저버를 가리키는 핸들 (슬롯 번호 + 세대)
+//제거된 뒤 같은 슬롯이 재사용되면 세대가 달라지므로 예전 핸들은 무효가 된다
+struct ObserverHandle {
+	uint32_t index = UINT32_MAX;
+	uint32_t generation = 0;
+};
+
+//슬롯맵(slot map) 방식의 옵저버 저장소
+//제거는 핸들로 O(1) 에 처리하고 빈칸은 표시만 해 둔다
+//
+//통보 도중(update() 안)에 등록/제거가 일어나도 안전하도록 구조 변경은 미뤄 둔다
+// - 등록 : 배열 끝에 추가되므로 이번 통보에서는 보이지 않고 다음 통보부터 받는다
+// - 제거 : 빈칸으로 표시만 하고 옵저버 객체도 통보가 끝날 때까지 놓아주지 않는다
+// - 정리(compact) : 가장 바깥 통보가 끝난 뒤에 한 번만 한다
+//목록을 복사하지 않으므로 평상시 통보 경로에서는 메모리 할당이 전혀 없다
+class ObserverRegistry {
+private:
+	static const uint32_t INVALID_INDEX = UINT32_MAX;
+
+	struct Slot {
+		uint32_t denseIndex; //_observers 안의 위치 (INVALID_INDEX 이면 빈 슬롯)
+		uint32_t generation; //슬롯 재사용 횟수
+	};
+
+	vector<IObserver*> _observers;         //통보할 때 순회하는 연속 배열 (정리 전에는 nullptr 빈칸이 있을 수 있다)
+	vector<shared_ptr<IObserver>> _owners; //수명 유지용 (통보할 때는 읽지 않는다)
+	vector<uint32_t> _denseToSlot;         //_observers 위치 -> 슬롯 번호
+	vector<Slot> _slots;                   //핸들 -> _observers 위치
+	vector<uint32_t> _freeSlots;           //재사용할 빈 슬롯 번호
+	vector<shared_ptr<IObserver>> _released; //정리 중에 놓아줄 옵저버 (용량은 재사용한다)
+	size_t _holeCount = 0;                 //정리되지 않은 빈칸 수
+	int _dispatchDepth = 0;                //진행 중인 통보 깊이 (update() 안에서 다시 통보할 수 있다)
+
+	//예외가 나도 통보 깊이가 복구되도록 한다
+	class DispatchScope {
+	private:
+		ObserverRegistry& _registry;
+
+	public:
+		DispatchScope(ObserverRegistry& registry) : _registry(registry) {
+			_registry._dispatchDepth++;
+		}
+
+		~DispatchScope() {
+			if (--_registry._dispatchDepth == 0) {
+				_registry.compact();
+			}
+		}
+	};
+
+public:
+	void reserve(size_t count) {
+		_observers.reserve(count);
+		_owners.reserve(count);
+		_denseToSlot.reserve(count);
+		_slots.reserve(count);
+	}
+
+	size_t size() const {
+		return _observers.size() - _holeCount;
+	}
+
+	bool isDispatching() const {
+		return _dispatchDepth > 0;
+	}
+
+	//배열 끝에 추가한다 : O(1)
+	ObserverHandle insert(shared_ptr<IObserver> pObserver) {
+		uint32_t slotIndex;
+		if (_freeSlots.empty()) {
+			slotIndex = static_cast<uint32_t>(_slots.size());
+			_slots.push_back(Slot{ INVALID_INDEX, 0 });
+		}
+		else {
+			slotIndex = _freeSlots.back();
+			_freeSlots.pop_back();
+		}
+
+		Slot& slot = _slots[slotIndex];
+		slot.denseIndex = static_cast<uint32_t>(_observers.size());
+
+		_observers.push_back(pObserver.get());
+		_owners.push_back(move(pObserver));
+		_denseToSlot.push_back(slotIndex);
+
+		return ObserverHandle{ slotIndex, slot.generation };
+	}
+
+	bool contains(ObserverHandle handle) const {
+		return handle.index < _slots.size()
+			&& _slots[handle.index].denseIndex != INVALID_INDEX
+			&& _slots[handle.index].generation == handle.generation;
+	}
+
+	//빈칸으로 표시만 한다 : O(1)
+	//통보 중이면 update() 가 아직 실행 중일 수 있으므로 옵저버 객체는 정리할 때 놓아준다
+	bool erase(ObserverHandle handle) {
+		if (!contains(handle)) {
+			return false;
+		}
+
+		Slot& slot = _slots[handle.index];
+		uint32_t denseIndex = slot.denseIndex;
+		_observers[denseIndex] = nullptr;
+		_holeCount++;
+
+		slot.denseIndex = INVALID_INDEX;
+		slot.generation++;
+		_freeSlots.push_back(handle.index);
+
+		if (!isDispatching()) {
+			_owners[denseIndex].reset();
+		}
+		return true;
+	}
+
+	//빈칸을 제거하고 남은 옵저버를 앞으로 당긴다 (등록 순서 유지)
+	//통보 중에는 아무 일도 하지 않고 가장 바깥 통보가 끝날 때 다시 불린다
+	void compact() {
+		if (_holeCount == 0 || isDispatching()) {
+			return;
+		}
+
+		size_t writeIndex = 0;
+		for (size_t readIndex = 0; readIndex < _observers.size(); readIndex++) {
+			if (_observers[readIndex] == nullptr) {
+				if (_owners[readIndex]) {
+					_released.push_back(move(_owners[readIndex]));
+				}
+				continue;
+			}
+			if (writeIndex != readIndex) {
+				_observers[writeIndex] = _observers[readIndex];
+				_owners[writeIndex] = move(_owners[readIndex]);
+				_denseToSlot[writeIndex] = _denseToSlot[readIndex];
+				_slots[_denseToSlot[writeIndex]].denseIndex = static_cast<uint32_t>(writeIndex);
+			}
+			writeIndex++;
+		}
+
+		_observers.resize(writeIndex);
+		_owners.resize(writeIndex);
+		_denseToSlot.resize(writeIndex);
+		_holeCount = 0;
+
+		//옵저버 소멸자가 다시 등록/제거를 해도 되도록 배열 정리가 끝난 뒤에 놓아준다
+		_released.clear();
+	}
+
+	//통보 시작 시점의 옵저버만 순회한다
+	//배열이 재할당될 수 있으므로 반복자 대신 위치로 접근하고, 도중에 생긴 빈칸은 건너뛴다
+	template <typename Func>
+	void forEach(Func&& func) {
+		compact();
+		DispatchScope scope(*this);
+
+		const size_t count = _observers.size();
+		for (size_t idx = 0; idx < count; idx++) {
+			IObserver* pObserver = _observers[idx];
+			if (pObserver != nullptr) {
+				func(*pObserver);
+			}
+		}
+	}
+};
+
+//registerObserver() 가 돌려주는 구독 토큰
+//토큰이 소멸되거나 release() 를 호출하면 O(1) 로 구독이 해제된다
+//주제 객체가 먼저 사라져도 안전하도록 저장소는 weak_ptr 로 가리킨다
+class Subscription {
+private:
+	weak_ptr<ObserverRegistry> _registry;
+	ObserverHandle _handle;
+
+public:
+	Subscription() = default;
+
+	Subscription(weak_ptr<ObserverRegistry> registry, ObserverHandle handle)
+		: _registry(move(registry)), _handle(handle) {
+	}
+
+	Subscription(const Subscription&) = delete;
+	Subscription& operator=(const Subscription&) = delete;
+
+	Subscription(Subscription&& r) noexcept
+		: _registry(move(r._registry)), _handle(r._handle) {
+		r._registry.reset();
+	}
+
+	Subscription& operator=(Subscription&& r) noexcept {
+		if (this != &r) {
+			release();
+			_registry = move(r._registry);
+			_handle = r._handle;
+			r._registry.reset();
+		}
+		return *this;
+	}
+
+	~Subscription() {
+		release();
+	}
+
+	//구독 해제
+	void release() {
+		if (shared_ptr<ObserverRegistry> pRegistry = _registry.lock()) {
+			pRegistry->erase(_handle);
+		}
+		_registry.reset();
+	}
+
+	//토큰과의 연결만 끊고 구독은 주제 객체가 사라질 때까지 유지한다
+	void detach() {
+		_registry.reset();
+	}
+
+	bool isActive() const {
+		shared_ptr<ObserverRegistry> pRegistry = _registry.lock();
+		return pRegistry && pRegistry->contains(_handle);
+	}
+};
+
+class ISubject {
+
+public:
+	//옵저버 등록 : 반환된 토큰이 살아있는 동안만 구독이 유지된다
+	[[nodiscard]] virtual Subscription registerObserver(shared_ptr<IObserver> pObserver) = 0;
+
+	//옵저버 제거
+	virtual void removeObserver(Subscription& subscription) = 0;
+
+	//변경 사실을 알린다
+	virtual void notifyObserver() = 0;
+};
+
+//큐가 가득 찼을 때의 처리 방법
+enum class OverflowPolicy {
+	Block,          //자리가 날 때까지 생산자가 기다린다
+	DropOldest,     //가장 오래된 측정값을 버리고 새 값을 넣는다
+	CoalesceLatest, //마지막으로 들어간 측정값을 새 값으로 덮어쓴다
+};
+
+//옵저버별 큐 통계
+struct QueueMetrics {
+	size_t depth = 0;     //현재 대기 중인 측정값 수
+	size_t maxDepth = 0;  //지금까지의 최대 대기 수
+	size_t enqueued = 0;  //들어온 측정값 수
+	size_t delivered = 0; //update() 로 전달한 수
+	size_t dropped = 0;   //버린 수 (DropOldest, 구독 해제 시 남은 값)
+	size_t coalesced = 0; //덮어쓴 수 (CoalesceLatest)
+	size_t blocked = 0;   //생산자가 기다린 횟수 (Block)
+};
+
+class Mailbox;
+
+//작업 훔치기(work stealing) 방식의 작업 스레드 풀
+//작업 스레드마다 준비된 우편함 큐를 두고, 자기 큐가 비면 다른 스레드 큐의 앞쪽에서 가져온다
+class DispatchPool {
+private:
+	static const size_t DRAIN_BATCH = 32; //우편함 하나를 한 번에 비우는 최대 개수
+
+	struct WorkerQueue {
+		mutex queueMutex;
+		deque<shared_ptr<Mailbox>> mailboxes;
+	};
+
+	vector<unique_ptr<WorkerQueue>> _queues;
+	vector<thread> _workers;
+	atomic<size_t> _nextQueue{ 0 };
+	atomic<size_t> _pending{ 0 };
+	atomic<size_t> _busy{ 0 };    //우편함을 비우는 중인 작업 스레드 수
+	atomic<size_t> _steals{ 0 };
+
+	mutex _sleepMutex;
+	condition_variable _wake;
+	condition_variable _idle;
+	bool _stopping = false;
+
+	//지금 스레드가 이 풀의 작업 스레드이면 그 번호
+	static thread_local DispatchPool* t_pPool;
+	static thread_local size_t t_workerIndex;
+
+	shared_ptr<Mailbox> take(size_t workerIndex) {
+		{
+			//자기 큐는 뒤에서 (방금 넣은 우편함이 캐시에 남아있다)
+			WorkerQueue& own = *_queues[workerIndex];
+			lock_guard<mutex> lock(own.queueMutex);
+			if (!own.mailboxes.empty()) {
+				shared_ptr<Mailbox> pMailbox = move(own.mailboxes.back());
+				own.mailboxes.pop_back();
+				return pMailbox;
+			}
+		}
+
+		//다른 큐는 앞에서 훔친다
+		for (size_t offset = 1; offset < _queues.size(); offset++) {
+			WorkerQueue& victim = *_queues[(workerIndex + offset) % _queues.size()];
+			lock_guard<mutex> lock(victim.queueMutex);
+			if (!victim.mailboxes.empty()) {
+				shared_ptr<Mailbox> pMailbox = move(victim.mailboxes.front());
+				victim.mailboxes.pop_front();
+				_steals.fetch_add(1, memory_order_relaxed);
+				return pMailbox;
+			}
+		}
+		return nullptr;
+	}
+
+	void workerLoop(size_t workerIndex);
+
+public:
+	DispatchPool(size_t workerCount) {
+		workerCount = max<size_t>(1, workerCount);
+		for (size_t idx = 0; idx < workerCount; idx++) {
+			_queues.push_back(make_unique<WorkerQueue>());
+		}
+		for (size_t idx = 0; idx < workerCount; idx++) {
+			_workers.emplace_back(&DispatchPool::workerLoop, this, idx);
+		}
+	}
+
+	//남은 측정값을 모두 전달한 뒤 작업 스레드를 끝낸다
+	~DispatchPool() {
+		{
+			lock_guard<mutex> lock(_sleepMutex);
+			_stopping = true;
+		}
+		_wake.notify_all();
+		for (thread& worker : _workers) {
+			worker.join();
+		}
+	}
+
+	DispatchPool(const DispatchPool&) = delete;
+	DispatchPool& operator=(const DispatchPool&) = delete;
+
+	//처리할 측정값이 생긴 우편함을 큐에 넣는다
+	void schedule(shared_ptr<Mailbox> pMailbox) {
+		size_t queueIndex = (t_pPool == this)
+			? t_workerIndex
+			: _nextQueue.fetch_add(1, memory_order_relaxed) % _queues.size();
+		{
+			WorkerQueue& queue = *_queues[queueIndex];
+			lock_guard<mutex> lock(queue.queueMutex);
+			queue.mailboxes.push_back(move(pMailbox));
+		}
+		_pending.fetch_add(1);
+
+		//잠들려는 스레드가 깨우기 신호를 놓치지 않도록 잠금을 한 번 거친다
+		{
+			lock_guard<mutex> lock(_sleepMutex);
+		}
+		_wake.notify_one();
+	}
+
+	//예약된 우편함이 모두 비워질 때까지 기다린다
+	//(기다리는 동안 새로 넣는 측정값이 있으면 그것도 기다린다)
+	void waitIdle() {
+		unique_lock<mutex> lock(_sleepMutex);
+		_idle.wait(lock, [this]() { return _pending.load() == 0 && _busy.load() == 0; });
+	}
+
+	size_t getWorkerCount() const {
+		return _workers.size();
+	}
+
+	size_t getStealCount() const {
+		return _steals.load(memory_order_relaxed);
+	}
+};
+
+thread_local DispatchPool* DispatchPool::t_pPool = nullptr;
+thread_local size_t DispatchPool::t_workerIndex = 0;
+
+//옵저버 하나에 붙는 고정 크기 원형 큐 (우편함)
+//한 번에 한 작업 스레드만 비우므로 같은 옵저버의 update() 가 동시에 호출되지 않는다
+class Mailbox : public enable_shared_from_this<Mailbox> {
+private:
+	shared_ptr<IObserver> _pObserver;
+	DispatchPool& _pool;
+	const OverflowPolicy _policy;
+
+	mutex _mutex;
+	condition_variable _notFull;
+	vector<SensorData> _buffer;
+	size_t _head = 0;
+	size_t _count = 0;
+	bool _closed = false;
+	QueueMetrics _metrics;
+
+	//작업 스레드 큐에 들어가 있거나 비우는 중이면 true
+	atomic<bool> _scheduled{ false };
+
+	void scheduleIfIdle() {
+		if (!_scheduled.exchange(true)) {
+			_pool.schedule(shared_from_this());
+		}
+	}
+
+public:
+	Mailbox(shared_ptr<IObserver> pObserver, DispatchPool& pool, size_t capacity, OverflowPolicy policy)
+		: _pObserver(move(pObserver)), _pool(pool), _policy(policy), _buffer(max<size_t>(1, capacity)) {
+	}
+
+	//생산자 스레드 : 측정값을 복사해 넣는다
+	void push(const SensorData& sensorData) {
+		{
+			unique_lock<mutex> lock(_mutex);
+			if (_closed) {
+				return;
+			}
+			_metrics.enqueued++;
+
+			if (_count == _buffer.size()) {
+				switch (_policy) {
+				case OverflowPolicy::Block:
+					_metrics.blocked++;
+					_notFull.wait(lock, [this]() { return _count < _buffer.size() || _closed; });
+					if (_closed) {
+						return;
+					}
+					break;
+
+				case OverflowPolicy::DropOldest:
+					_head = (_head + 1) % _buffer.size();
+					_count--;
+					_metrics.dropped++;
+					break;
+
+				case OverflowPolicy::CoalesceLatest:
+					_buffer[(_head + _count - 1) % _buffer.size()] = sensorData;
+					_metrics.coalesced++;
+					return;
+				}
+			}
+
+			_buffer[(_head + _count) % _buffer.size()] = sensorData;
+			_count++;
+			_metrics.maxDepth = max(_metrics.maxDepth, _count);
+		}
+		scheduleIfIdle();
+	}
+
+	//작업 스레드 : 최대 maxItems 개를 옵저버에 전달한다
+	//update() 를 호출하는 동안에는 잠금을 잡지 않는다
+	void drain(size_t maxItems) {
+		for (size_t idx = 0; idx < maxItems; idx++) {
+			SensorData sensorData;
+			{
+				lock_guard<mutex> lock(_mutex);
+				if (_count == 0 || _closed) {
+					break;
+				}
+				sensorData = _buffer[_head];
+				_head = (_head + 1) % _buffer.size();
+				_count--;
+				_metrics.delivered++;
+			}
+			_notFull.notify_one();
+			_pObserver->update(sensorData);
+		}
+
+		//예약을 풀고 그 사이에 들어온 값이 있으면 다시 예약한다
+		_scheduled.store(false);
+		bool hasMore;
+		{
+			lock_guard<mutex> lock(_mutex);
+			hasMore = _count > 0 && !_closed;
+		}
+		if (hasMore) {
+			scheduleIfIdle();
+		}
+	}
+
+	//구독 해제 : 남은 측정값은 버리고 기다리는 생산자를 깨운다
+	void close() {
+		{
+			lock_guard<mutex> lock(_mutex);
+			_closed = true;
+			_metrics.dropped += _count;
+			_count = 0;
+		}
+		_notFull.notify_all();
+	}
+
+	bool isClosed() {
+		lock_guard<mutex> lock(_mutex);
+		return _closed;
+	}
+
+	QueueMetrics getMetrics() {
+		lock_guard<mutex> lock(_mutex);
+		QueueMetrics metrics = _metrics;
+		metrics.depth = _count;
+		return metrics;
+	}
+};
+
+void DispatchPool::workerLoop(size_t workerIndex) {
+	t_pPool = this;
+	t_workerIndex = workerIndex;
+
+	while (true) {
+		shared_ptr<Mailbox> pMailbox = take(workerIndex);
+		if (pMailbox) {
+			//_pending 을 줄이기 전에 _busy 를 올려야 waitIdle() 이 둘 다 0 인 순간을 잘못 보지 않는다
+			_busy.fetch_add(1);
+			_pending.fetch_sub(1);
+			pMailbox->drain(DRAIN_BATCH);
+			if (_busy.fetch_sub(1) == 1 && _pending.load() == 0) {
+				lock_guard<mutex> lock(_sleepMutex);
+				_idle.notify_all();
+			}
+			continue;
+		}
+
+		unique_lock<mutex> lock(_sleepMutex);
+		_wake.wait(lock, [this]() { return _stopping || _pending.load() > 0; });
+		if (_stopping && _pending.load() == 0) {
+			return;
+		}
+	}
+}
+
+//비동기 옵저버 어댑터 : update() 는 측정값을 우편함에 넣기만 하고 바로 돌아온다
+//저장소에서 제거되어 소멸되면 우편함을 닫는다
+class AsyncObserver : public IObserver {
+private:
+	shared_ptr<Mailbox> _pMailbox;
+
+public:
+	AsyncObserver(shared_ptr<Mailbox> pMailbox) : _pMailbox(move(pMailbox)) {
+	}
+
+	~AsyncObserver() {
+		_pMailbox->close();
+	}
+
+	void update(const SensorData& sensorData) override {
+		_pMailbox->push(sensorData);
+	}
+};
+
+class Random {
+private:
+	// 시드값을 얻기 위한 random_device 생성.
+	random_device _rd;
+
+	// random_device 를 통해 난수 생성 엔진을 초기화 한다.
+	// getValue() const 에서 상태를 바꾸므로 mutable 로 선언한다
+	mutable mt19937 _generator;
+
+	// 예 :  0 부터 99 까지 균등하게 나타나는 난수열을 생성하기 위해 균등 분포 정의.
+	mutable uniform_int_distribution<int> _distribution;
+
+public:
+	Random(int from, int to) : _generator{ _rd() },
+		_distribution{from, to} {
+
+	}
+
+	int getValue() const {
+		return _distribution(_generator);
+	}
+};
+
+class WeatherStation {
+private:
+	Random _randomTemperature; //온도 난수 객체
+	Random _randomHumidity; //습도 난수 객체
+	Random _randomPressure; //압력 난수 객체
+
+public :
+	WeatherStation() : _randomTemperature{ -50, 50 }
+		, _randomHumidity{ -100, 100 }
+		, _randomPressure{ -100, 100 } {
+	}
+
+	float getTemperature() const {
+		return 25.0f + _randomTemperature.getValue() / 10.0f;
+	}
+	float getHumidity() const {
+		return 60.0f + _randomHumidity.getValue() / 10.0f;
+	};
+	float getPressure() const {
+		return 25.0f +  _randomPressure.getValue() / 10.0f;
+	};
+
+};
+
+class StatisticsDisplay : public IObserver {
+private:
+	float _maxTemp = 0.0f;
+	float _minTemp = 100.0f;
+	float _tempSum = 0.0f;
+	int _numReadings = 0;
+
+public:
+	void update(const SensorData& sensorData) override {
+		update(sensorData.temp, sensorData.humidity, sensorData.pressure);
+	}
+
+	void update(float temp, float humidity, float pressure) {
+		_tempSum += temp;
+		_numReadings++;
+
+		if (temp > _maxTemp) {
+			_maxTemp = temp;
+		}
+
+		if (temp < _minTemp) {
+			_minTemp = temp;
+		}
+
+		display();
+	}
+
+	void display() {
+		cout << "기상 통계 " << endl
+			<< "평균 기온 : " << (_tempSum / _numReadings) << "℃" << endl
+			<< "최저 기온 : " << _minTemp << "℃" << endl
+			<< "최고 기온 : " << _maxTemp << "℃" << endl << endl;
+	}
+};
+
+class CurrentConditionsDisplay : public IObserver {
+private:
+	float _temperature;
+	float _humidity;
+	float _pressure;
+
+public:
+	void update(const SensorData& sensorData) override {
+		update(sensorData.temp, sensorData.humidity, sensorData.pressure);
+	}
+
+	void update(float temperature, float humidity, float pressure) {
+		_temperature = temperature;
+		_humidity = humidity;
+		_pressure = pressure;
+		display();
+	}
+
+	void display() {
+		cout << "현재 조건 " << endl
+			<< "온도: " << _temperature << "℃" << endl
+			<< "습도: " << _humidity << "%" << endl
+			<< "기압: " << _pressure << endl << endl;
+
+	}
+};
+
+class ForecastDisplay : public IObserver {
+private:
+	float _currentPressure = 29.92f;
+	float _lastPressure;
+
+public:
+	void update(const SensorData& sensorData) override {
+		update(sensorData.temp, sensorData.humidity, sensorData.pressure);
+	}
+
+	void update(float temp, float humidity, float pressure) {
+		_lastPressure = _currentPressure;
+		_currentPressure = pressure;
+
+		display();
+	}
+
+	void display() {
+		cout << "기상 예보" << endl;
+		if (_currentPressure > _lastPressure) {
+			cout << "가는 길에 날씨 개선" << endl << endl;
+		}
+		else if (_currentPressure == _lastPressure) {
+			cout << "전과 같음" << endl << endl;
+		}
+		else if (_currentPressure < _lastPressure) {
+			cout << "선선하고 비오는 날씨에 조심하십시오" << endl << endl;
+		}
+	}
+};
+
+
+class WeatherData : public ISubject {
+private:
+	WeatherStation _weatherStation;
+
+	//ISubject 구현시 사용할 멤버변수
+	//구독 토큰이 weak_ptr 로 가리킬 수 있도록 shared_ptr 로 보관한다
+	shared_ptr<ObserverRegistry> _registry = make_shared<ObserverRegistry>();
+
+	//비동기 옵저버의 우편함 (통계 조회용)
+	vector<weak_ptr<Mailbox>> _mailboxes;
+
+	//비동기 전달용 작업 스레드 풀 (처음 쓸 때 만든다)
+	//_registry 보다 먼저 소멸되어야 남은 측정값이 옵저버에 모두 전달된다
+	unique_ptr<DispatchPool> _pool;
+
+	SensorData _sensorData;
+
+public:
+
+	//옵저버 등록 : update() 는 readMeasurements() 를 호출한 스레드에서 바로 호출된다
+	Subscription registerObserver(shared_ptr<IObserver> pObserver) override {
+		return Subscription(_registry, _registry->insert(move(pObserver)));
+	}
+
+	//작업 스레드 수를 정한다 (비동기 옵저버를 등록하기 전에 호출)
+	void enableAsyncDispatch(size_t workerCount) {
+		if (!_pool) {
+			_pool = make_unique<DispatchPool>(workerCount);
+		}
+	}
+
+	//비동기 옵저버 등록 : update() 는 작업 스레드에서 호출되고 생산자는 기다리지 않는다
+	[[nodiscard]] Subscription registerAsyncObserver(shared_ptr<IObserver> pObserver,
+		size_t capacity = 64, OverflowPolicy policy = OverflowPolicy::DropOldest) {
+		enableAsyncDispatch(thread::hardware_concurrency());
+
+		shared_ptr<Mailbox> pMailbox = make_shared<Mailbox>(move(pObserver), *_pool, capacity, policy);
+		_mailboxes.push_back(pMailbox);
+		return registerObserver(make_shared<AsyncObserver>(move(pMailbox)));
+	}
+
+	//옵저버 제거
+	void removeObserver(Subscription& subscription) override {
+		subscription.release();
+	}
+
+	//변경 사실을 알린다
+	void notifyObserver() override {
+		const SensorData& sensorData = _sensorData;
+		_registry->forEach([&sensorData](IObserver& observer) {
+			observer.update(sensorData);
+		});
+	}
+
+	//구독 중인 비동기 옵저버의 큐 통계 (등록 순서)
+	vector<QueueMetrics> getQueueMetrics() {
+		vector<QueueMetrics> metrics;
+		for (auto it = _mailboxes.begin(); it != _mailboxes.end();) {
+			shared_ptr<Mailbox> pMailbox = it->lock();
+			if (!pMailbox || pMailbox->isClosed()) {
+				it = _mailboxes.erase(it);
+				continue;
+			}
+			metrics.push_back(pMailbox->getMetrics());
+			++it;
+		}
+		return metrics;
+	}
+
+	size_t getStealCount() const {
+		return _pool ? _pool->getStealCount() : 0;
+	}
+
+	//비동기 옵저버에 넣은 측정값이 모두 전달될 때까지 기다린다
+	void waitAsyncIdle() {
+		if (_pool) {
+			_pool->waitIdle();
+		}
+	}
+
+	size_t getObserverCount() const {
+		return _registry->size();
+	}
+
+	float getTemperature() const {
+		return _weatherStation.getTemperature();
+	}
+
+	float getHumidity() const {
+		return _weatherStation.getHumidity();
+	}
+
+	float getPressure() const {
+		return _weatherStation.getPressure();
+	}
+
+	void measurementsChanged() {
+		notifyObserver();
+	}
+
+	void readMeasurements() {
+		_sensorData.temp = _weatherStation.getTemperature();
+		_sensorData.humidity = _weatherStation.getHumidity();
+		_sensorData.pressure = _weatherStation.getPressure();
+
+		measurementsChanged();
+	}
+};
+
+//벤치마크용 옵저버 : 측정값 하나를 처리하는 데 delay 만큼 걸린다 (느린 화면 출력 흉내)
+class SlowObserver : public IObserver {
+private:
+	chrono::microseconds _delay;
+	atomic<size_t> _count{ 0 };
+
+public:
+	SlowObserver(chrono::microseconds delay) : _delay(delay) {
+	}
+
+	void update(const SensorData& /*sensorData*/) override {
+		auto until = chrono::steady_clock::now() + _delay;
+		while (chrono::steady_clock::now() < until) {
+		}
+		_count.fetch_add(1, memory_order_relaxed);
+	}
+
+	size_t getCount() const {
+		return _count.load(memory_order_relaxed);
+	}
+};
+
+void printMetrics(const char* name, const QueueMetrics& metrics) {
+	cout << "  " << name
+		<< " : 대기 " << metrics.depth
+		<< ", 최대 대기 " << metrics.maxDepth
+		<< ", 입력 " << metrics.enqueued
+		<< ", 전달 " << metrics.delivered
+		<< ", 버림 " << metrics.dropped
+		<< ", 덮어씀 " << metrics.coalesced
+		<< ", 생산자 대기 " << metrics.blocked << endl;
+}
+
+//느린 옵저버 1개 + 빠른 옵저버 8개일 때 처리량을 동기/비동기로 비교한다
+//비동기는 생산자가 넣기를 마친 시점(생산 속도)과 우편함이 모두 비워진 시점(전달 완료 속도)을 함께 잰다
+void benchmarkAsyncDispatch() {
+	const int readings = 2000;
+	const chrono::microseconds slowDelay(200);
+
+	{
+		WeatherData weatherData;
+		vector<Subscription> subscriptions;
+		subscriptions.push_back(weatherData.registerObserver(make_shared<SlowObserver>(slowDelay)));
+		for (int idx = 0; idx < 8; idx++) {
+			subscriptions.push_back(weatherData.registerObserver(make_shared<SlowObserver>(chrono::microseconds(0))));
+		}
+
+		auto start = chrono::steady_clock::now();
+		for (int reading = 0; reading < readings; reading++) {
+			weatherData.readMeasurements();
+		}
+		auto end = chrono::steady_clock::now();
+		cout << "동기 전달 : " << static_cast<long long>(readings / chrono::duration<double>(end - start).count()) << " 회/초" << endl;
+	}
+
+	const OverflowPolicy policies[] = { OverflowPolicy::Block, OverflowPolicy::DropOldest, OverflowPolicy::CoalesceLatest };
+	const char* policyNames[] = { "Block", "DropOldest", "CoalesceLatest" };
+
+	for (int policyIndex = 0; policyIndex < 3; policyIndex++) {
+		WeatherData weatherData;
+		weatherData.enableAsyncDispatch(4);
+
+		vector<Subscription> subscriptions;
+		subscriptions.push_back(weatherData.registerAsyncObserver(make_shared<SlowObserver>(slowDelay), 64, policies[policyIndex]));
+		for (int idx = 0; idx < 8; idx++) {
+			subscriptions.push_back(weatherData.registerAsyncObserver(make_shared<SlowObserver>(chrono::microseconds(0)), 64, policies[policyIndex]));
+		}
+
+		auto start = chrono::steady_clock::now();
+		for (int reading = 0; reading < readings; reading++) {
+			weatherData.readMeasurements();
+		}
+		auto produced = chrono::steady_clock::now();
+		weatherData.waitAsyncIdle();
+		auto end = chrono::steady_clock::now();
+
+		vector<QueueMetrics> metrics = weatherData.getQueueMetrics();
+		size_t delivered = 0;
+		for (const QueueMetrics& queueMetrics : metrics) {
+			delivered += queueMetrics.delivered;
+		}
+
+		cout << "비동기 전달 (" << policyNames[policyIndex] << ") : 생산 "
+			<< static_cast<long long>(readings / chrono::duration<double>(produced - start).count()) << " 회/초"
+			<< ", 전달 완료까지 " << static_cast<long long>(readings / chrono::duration<double>(end - start).count()) << " 회/초"
+			<< " (옵저버 전달 " << delivered << "번, " << static_cast<long long>(delivered / chrono::duration<double>(end - start).count())
+			<< " 번/초), 작업 훔치기 " << weatherData.getStealCount() << "회" << endl;
+		printMetrics("느린 옵저버", metrics[0]);
+		printMetrics("빠른 옵저버", metrics[1]);
+	}
+}
+
+int main(int argc, char** argv) {
+
+	shared_ptr<WeatherData> pWeatherData = make_shared<WeatherData>();
+	//출력 장치 객체 생성
+	shared_ptr<StatisticsDisplay> pStatisticsDisplay = make_shared<StatisticsDisplay>();
+	shared_ptr<CurrentConditionsDisplay> pCurrentConditionsDisplay = make_shared<CurrentConditionsDisplay>();
+	shared_ptr<ForecastDisplay> pForecastDisplay = make_shared<ForecastDisplay>();
+
+	//출력이 섞이지 않도록 작업 스레드 1개로 비동기 전달한다
+	pWeatherData->enableAsyncDispatch(1);
+
+	//출력 장치를 등록한다
+	//화면 출력이 느려도 측정은 기다리지 않는다 (현재 조건은 최신 값만 있으면 된다)
+	Subscription statisticsSubscription = pWeatherData->registerAsyncObserver(pStatisticsDisplay, 16, OverflowPolicy::Block);
+	Subscription currentConditionsSubscription = pWeatherData->registerAsyncObserver(pCurrentConditionsDisplay, 1, OverflowPolicy::CoalesceLatest);
+	Subscription forecastSubscription = pWeatherData->registerAsyncObserver(pForecastDisplay, 16, OverflowPolicy::Block);
+
+	//측정값을 읽는다
+	pWeatherData->readMeasurements(); //등록된 3개의 출력 장치에 값을 출력한다
+	pWeatherData->readMeasurements();
+	pWeatherData->readMeasurements();
+
+	//출력 장치를 제거한다 (제거하면 남은 측정값은 버려지므로 먼저 전달을 마친다)
+	pWeatherData->waitAsyncIdle();
+	pWeatherData->removeObserver(forecastSubscription);
+
+	//측정값을 읽는다
+	pWeatherData->readMeasurements(); //등록된 2개의 출력 장치에 값을 출력한다
+	pWeatherData->readMeasurements();
+	pWeatherData->readMeasurements();
+
+	//남은 출력이 끝나도록 주제 객체를 먼저 정리한다
+	pWeatherData.reset();
+
+	benchmarkAsyncDispatch();
+
+	return 0;
+}
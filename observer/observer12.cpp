@@ -0,0 +1,673 @@
+﻿// observer.cpp : 이 파일에는 'main' 함수가 포함됩니다. 거기서 프로그램 실행이 시작되고 종료됩니다.
+//
+
+#include <iostream>
+#include <memory>
+#include <random>
+#include <ctime>
+#include <functional>
+#include <list>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <algorithm>
+
+using namespace std;
+
+struct SensorData {
+	float temp;
+	float humidity;
+	float pressure;
+	float temp_top;
+	float temp_bottom;
+};
+
+//연속된 측정값 묶음을 가리키는 읽기 전용 구간 (복사하지 않는다)
+class SensorDataSpan {
+private:
+	const SensorData* _data;
+	size_t _size;
+
+public:
+	SensorDataSpan(const SensorData* data, size_t size) : _data(data), _size(size) {
+	}
+
+	SensorDataSpan(const vector<SensorData>& readings) : _data(readings.data()), _size(readings.size()) {
+	}
+
+	const SensorData* begin() const {
+		return _data;
+	}
+
+	const SensorData* end() const {
+		return _data + _size;
+	}
+
+	const SensorData& operator[](size_t idx) const {
+		return _data[idx];
+	}
+
+	const SensorData& back() const {
+		return _data[_size - 1];
+	}
+
+	size_t size() const {
+		return _size;
+	}
+
+	bool empty() const {
+		return _size == 0;
+	}
+};
+
+class IObserver {
+public:
+	virtual void update(const SensorData& sensorData) = 0;
+
+	//여러 측정값을 가상 함수 호출 한 번으로 받는다
+	//기본 구현은 하나씩 update() 를 호출하고, 한꺼번에 처리할 수 있는 옵저버는 재정의한다
+	virtual void updateBatch(SensorDataSpan readings) {
+		for (const SensorData& sensorData : readings) {
+			update(sensorData);
+		}
+	}
+};
+
+//등록된 옵저버를 가리키는 핸들 (슬롯 번호 + 세대)
+//제거된 뒤 같은 슬롯이 재사용되면 세대가 달라지므로 예전 핸들은 무효가 된다
+struct ObserverHandle {
+	uint32_t index = UINT32_MAX;
+	uint32_t generation = 0;
+};
+
+//슬롯맵(slot map) 방식의 옵저버 저장소
+//제거는 핸들로 O(1) 에 처리하고 빈칸은 표시만 해 둔다
+//
+//통보 도중(update() 안)에 등록/제거가 일어나도 안전하도록 구조 변경은 미뤄 둔다
+// - 등록 : 배열 끝에 추가되므로 이번 통보에서는 보이지 않고 다음 통보부터 받는다
+// - 제거 : 빈칸으로 표시만 하고 옵저버 객체도 통보가 끝날 때까지 놓아주지 않는다
+// - 정리(compact) : 가장 바깥 통보가 끝난 뒤에 한 번만 한다
+//목록을 복사하지 않으므로 평상시 통보 경로에서는 메모리 할당이 전혀 없다
+class ObserverRegistry {
+private:
+	static const uint32_t INVALID_INDEX = UINT32_MAX;
+
+	struct Slot {
+		uint32_t denseIndex; //_observers 안의 위치 (INVALID_INDEX 이면 빈 슬롯)
+		uint32_t generation; //슬롯 재사용 횟수
+	};
+
+	vector<IObserver*> _observers;         //통보할 때 순회하는 연속 배열 (정리 전에는 nullptr 빈칸이 있을 수 있다)
+	vector<shared_ptr<IObserver>> _owners; //수명 유지용 (통보할 때는 읽지 않는다)
+	vector<uint32_t> _denseToSlot;         //_observers 위치 -> 슬롯 번호
+	vector<Slot> _slots;                   //핸들 -> _observers 위치
+	vector<uint32_t> _freeSlots;           //재사용할 빈 슬롯 번호
+	vector<shared_ptr<IObserver>> _released; //정리 중에 놓아줄 옵저버 (용량은 재사용한다)
+	size_t _holeCount = 0;                 //정리되지 않은 빈칸 수
+	int _dispatchDepth = 0;                //진행 중인 통보 깊이 (update() 안에서 다시 통보할 수 있다)
+
+	//예외가 나도 통보 깊이가 복구되도록 한다
+	class DispatchScope {
+	private:
+		ObserverRegistry& _registry;
+
+	public:
+		DispatchScope(ObserverRegistry& registry) : _registry(registry) {
+			_registry._dispatchDepth++;
+		}
+
+		~DispatchScope() {
+			if (--_registry._dispatchDepth == 0) {
+				_registry.compact();
+			}
+		}
+	};
+
+public:
+	void reserve(size_t count) {
+		_observers.reserve(count);
+		_owners.reserve(count);
+		_denseToSlot.reserve(count);
+		_slots.reserve(count);
+	}
+
+	size_t size() const {
+		return _observers.size() - _holeCount;
+	}
+
+	bool isDispatching() const {
+		return _dispatchDepth > 0;
+	}
+
+	//배열 끝에 추가한다 : O(1)
+	ObserverHandle insert(shared_ptr<IObserver> pObserver) {
+		uint32_t slotIndex;
+		if (_freeSlots.empty()) {
+			slotIndex = static_cast<uint32_t>(_slots.size());
+			_slots.push_back(Slot{ INVALID_INDEX, 0 });
+		}
+		else {
+			slotIndex = _freeSlots.back();
+			_freeSlots.pop_back();
+		}
+
+		Slot& slot = _slots[slotIndex];
+		slot.denseIndex = static_cast<uint32_t>(_observers.size());
+
+		_observers.push_back(pObserver.get());
+		_owners.push_back(move(pObserver));
+		_denseToSlot.push_back(slotIndex);
+
+		return ObserverHandle{ slotIndex, slot.generation };
+	}
+
+	bool contains(ObserverHandle handle) const {
+		return handle.index < _slots.size()
+			&& _slots[handle.index].denseIndex != INVALID_INDEX
+			&& _slots[handle.index].generation == handle.generation;
+	}
+
+	//빈칸으로 표시만 한다 : O(1)
+	//통보 중이면 update() 가 아직 실행 중일 수 있으므로 옵저버 객체는 정리할 때 놓아준다
+	bool erase(ObserverHandle handle) {
+		if (!contains(handle)) {
+			return false;
+		}
+
+		Slot& slot = _slots[handle.index];
+		uint32_t denseIndex = slot.denseIndex;
+		_observers[denseIndex] = nullptr;
+		_holeCount++;
+
+		slot.denseIndex = INVALID_INDEX;
+		slot.generation++;
+		_freeSlots.push_back(handle.index);
+
+		if (!isDispatching()) {
+			_owners[denseIndex].reset();
+		}
+		return true;
+	}
+
+	//빈칸을 제거하고 남은 옵저버를 앞으로 당긴다 (등록 순서 유지)
+	//통보 중에는 아무 일도 하지 않고 가장 바깥 통보가 끝날 때 다시 불린다
+	void compact() {
+		if (_holeCount == 0 || isDispatching()) {
+			return;
+		}
+
+		size_t writeIndex = 0;
+		for (size_t readIndex = 0; readIndex < _observers.size(); readIndex++) {
+			if (_observers[readIndex] == nullptr) {
+				if (_owners[readIndex]) {
+					_released.push_back(move(_owners[readIndex]));
+				}
+				continue;
+			}
+			if (writeIndex != readIndex) {
+				_observers[writeIndex] = _observers[readIndex];
+				_owners[writeIndex] = move(_owners[readIndex]);
+				_denseToSlot[writeIndex] = _denseToSlot[readIndex];
+				_slots[_denseToSlot[writeIndex]].denseIndex = static_cast<uint32_t>(writeIndex);
+			}
+			writeIndex++;
+		}
+
+		_observers.resize(writeIndex);
+		_owners.resize(writeIndex);
+		_denseToSlot.resize(writeIndex);
+		_holeCount = 0;
+
+		//옵저버 소멸자가 다시 등록/제거를 해도 되도록 배열 정리가 끝난 뒤에 놓아준다
+		_released.clear();
+	}
+
+	//통보 시작 시점의 옵저버만 순회한다
+	//배열이 재할당될 수 있으므로 반복자 대신 위치로 접근하고, 도중에 생긴 빈칸은 건너뛴다
+	template <typename Func>
+	void forEach(Func&& func) {
+		compact();
+		DispatchScope scope(*this);
+
+		const size_t count = _observers.size();
+		for (size_t idx = 0; idx < count; idx++) {
+			IObserver* pObserver = _observers[idx];
+			if (pObserver != nullptr) {
+				func(*pObserver);
+			}
+		}
+	}
+};
+
+//registerObserver() 가 돌려주는 구독 토큰
+//토큰이 소멸되거나 release() 를 호출하면 O(1) 로 구독이 해제된다
+//주제 객체가 먼저 사라져도 안전하도록 저장소는 weak_ptr 로 가리킨다
+class Subscription {
+private:
+	weak_ptr<ObserverRegistry> _registry;
+	ObserverHandle _handle;
+
+public:
+	Subscription() = default;
+
+	Subscription(weak_ptr<ObserverRegistry> registry, ObserverHandle handle)
+		: _registry(move(registry)), _handle(handle) {
+	}
+
+	Subscription(const Subscription&) = delete;
+	Subscription& operator=(const Subscription&) = delete;
+
+	Subscription(Subscription&& r) noexcept
+		: _registry(move(r._registry)), _handle(r._handle) {
+		r._registry.reset();
+	}
+
+	Subscription& operator=(Subscription&& r) noexcept {
+		if (this != &r) {
+			release();
+			_registry = move(r._registry);
+			_handle = r._handle;
+			r._registry.reset();
+		}
+		return *this;
+	}
+
+	~Subscription() {
+		release();
+	}
+
+	//구독 해제
+	void release() {
+		if (shared_ptr<ObserverRegistry> pRegistry = _registry.lock()) {
+			pRegistry->erase(_handle);
+		}
+		_registry.reset();
+	}
+
+	//토큰과의 연결만 끊고 구독은 주제 객체가 사라질 때까지 유지한다
+	void detach() {
+		_registry.reset();
+	}
+
+	bool isActive() const {
+		shared_ptr<ObserverRegistry> pRegistry = _registry.lock();
+		return pRegistry && pRegistry->contains(_handle);
+	}
+};
+
+class ISubject {
+
+public:
+	//옵저버 등록 : 반환된 토큰이 살아있는 동안만 구독이 유지된다
+	[[nodiscard]] virtual Subscription registerObserver(shared_ptr<IObserver> pObserver) = 0;
+
+	//옵저버 제거
+	virtual void removeObserver(Subscription& subscription) = 0;
+
+	//변경 사실을 알린다
+	virtual void notifyObserver() = 0;
+};
+
+class Random {
+private:
+	// 시드값을 얻기 위한 random_device 생성.
+	random_device _rd;
+
+	// random_device 를 통해 난수 생성 엔진을 초기화 한다.
+	// getValue() const 에서 상태를 바꾸므로 mutable 로 선언한다
+	mutable mt19937 _generator;
+
+	// 예 :  0 부터 99 까지 균등하게 나타나는 난수열을 생성하기 위해 균등 분포 정의.
+	mutable uniform_int_distribution<int> _distribution;
+
+public:
+	Random(int from, int to) : _generator{ _rd() },
+		_distribution{from, to} {
+
+	}
+
+	int getValue() const {
+		return _distribution(_generator);
+	}
+};
+
+class WeatherStation {
+private:
+	Random _randomTemperature; //온도 난수 객체
+	Random _randomHumidity; //습도 난수 객체
+	Random _randomPressure; //압력 난수 객체
+
+public :
+	WeatherStation() : _randomTemperature{ -50, 50 }
+		, _randomHumidity{ -100, 100 }
+		, _randomPressure{ -100, 100 } {
+	}
+
+	float getTemperature() const {
+		return 25.0f + _randomTemperature.getValue() / 10.0f;
+	}
+	float getHumidity() const {
+		return 60.0f + _randomHumidity.getValue() / 10.0f;
+	};
+	float getPressure() const {
+		return 25.0f +  _randomPressure.getValue() / 10.0f;
+	};
+
+};
+
+class StatisticsDisplay : public IObserver {
+private:
+	float _maxTemp = 0.0f;
+	float _minTemp = 100.0f;
+	float _tempSum = 0.0f;
+	int _numReadings = 0;
+
+public:
+	void update(const SensorData& sensorData) override {
+		update(sensorData.temp, sensorData.humidity, sensorData.pressure);
+	}
+
+	void update(float temp, float humidity, float pressure) {
+		_tempSum += temp;
+		_numReadings++;
+
+		if (temp > _maxTemp) {
+			_maxTemp = temp;
+		}
+
+		if (temp < _minTemp) {
+			_minTemp = temp;
+		}
+
+		display();
+	}
+
+	//묶음 전체를 누적한 뒤 한 번만 출력한다
+	void updateBatch(SensorDataSpan readings) override {
+		if (readings.empty()) {
+			return;
+		}
+
+		accumulate(readings);
+		display();
+	}
+
+	//출력 없이 누적만 한다
+	void accumulate(SensorDataSpan readings) {
+		float tempSum = 0.0f;
+		float maxTemp = _maxTemp;
+		float minTemp = _minTemp;
+
+		for (const SensorData& sensorData : readings) {
+			tempSum += sensorData.temp;
+			maxTemp = max(maxTemp, sensorData.temp);
+			minTemp = min(minTemp, sensorData.temp);
+		}
+
+		_tempSum += tempSum;
+		_numReadings += static_cast<int>(readings.size());
+		_maxTemp = maxTemp;
+		_minTemp = minTemp;
+	}
+
+	void display() {
+		cout << "기상 통계 " << endl
+			<< "평균 기온 : " << (_tempSum / _numReadings) << "℃" << endl
+			<< "최저 기온 : " << _minTemp << "℃" << endl
+			<< "최고 기온 : " << _maxTemp << "℃" << endl << endl;
+	}
+};
+
+class CurrentConditionsDisplay : public IObserver {
+private:
+	float _temperature;
+	float _humidity;
+	float _pressure;
+
+public:
+	void update(const SensorData& sensorData) override {
+		update(sensorData.temp, sensorData.humidity, sensorData.pressure);
+	}
+
+	void update(float temperature, float humidity, float pressure) {
+		_temperature = temperature;
+		_humidity = humidity;
+		_pressure = pressure;
+		display();
+	}
+
+	void display() {
+		cout << "현재 조건 " << endl
+			<< "온도: " << _temperature << "℃" << endl
+			<< "습도: " << _humidity << "%" << endl
+			<< "기압: " << _pressure << endl << endl;
+
+	}
+};
+
+class ForecastDisplay : public IObserver {
+private:
+	float _currentPressure = 29.92f;
+	float _lastPressure;
+
+public:
+	void update(const SensorData& sensorData) override {
+		update(sensorData.temp, sensorData.humidity, sensorData.pressure);
+	}
+
+	void update(float temp, float humidity, float pressure) {
+		_lastPressure = _currentPressure;
+		_currentPressure = pressure;
+
+		display();
+	}
+
+	//예보는 마지막 두 기압만 비교하므로 묶음의 끝부분만 보고 한 번만 출력한다
+	void updateBatch(SensorDataSpan readings) override {
+		if (readings.empty()) {
+			return;
+		}
+
+		_lastPressure = readings.size() >= 2 ? readings[readings.size() - 2].pressure : _currentPressure;
+		_currentPressure = readings.back().pressure;
+
+		display();
+	}
+
+	void display() {
+		cout << "기상 예보" << endl;
+		if (_currentPressure > _lastPressure) {
+			cout << "가는 길에 날씨 개선" << endl << endl;
+		}
+		else if (_currentPressure == _lastPressure) {
+			cout << "전과 같음" << endl << endl;
+		}
+		else if (_currentPressure < _lastPressure) {
+			cout << "선선하고 비오는 날씨에 조심하십시오" << endl << endl;
+		}
+	}
+};
+
+
+class WeatherData : public ISubject {
+private:
+	WeatherStation _weatherStation;
+
+	//ISubject 구현시 사용할 멤버변수
+	//구독 토큰이 weak_ptr 로 가리킬 수 있도록 shared_ptr 로 보관한다
+	shared_ptr<ObserverRegistry> _registry = make_shared<ObserverRegistry>();
+
+	SensorData _sensorData;
+
+	//readMeasurementsBatch() 에서 재사용하는 버퍼 (용량을 유지하므로 매번 할당하지 않는다)
+	vector<SensorData> _batch;
+
+public:
+
+	//옵저버 등록
+	Subscription registerObserver(shared_ptr<IObserver> pObserver) override {
+		return Subscription(_registry, _registry->insert(move(pObserver)));
+	}
+
+	//옵저버 제거
+	void removeObserver(Subscription& subscription) override {
+		subscription.release();
+	}
+
+	//변경 사실을 알린다
+	void notifyObserver() override {
+		const SensorData& sensorData = _sensorData;
+		_registry->forEach([&sensorData](IObserver& observer) {
+			observer.update(sensorData);
+		});
+	}
+
+	size_t getObserverCount() const {
+		return _registry->size();
+	}
+
+	//여러 측정값을 옵저버마다 한 번에 알린다
+	void notifyObserverBatch(SensorDataSpan readings) {
+		_registry->forEach([&readings](IObserver& observer) {
+			observer.updateBatch(readings);
+		});
+	}
+
+	//이미 수집된 측정값(밀린 기록 등)을 한 번에 전달한다
+	void replayBatch(SensorDataSpan readings) {
+		if (readings.empty()) {
+			return;
+		}
+		_sensorData = readings.back();
+		notifyObserverBatch(readings);
+	}
+
+	float getTemperature() const {
+		return _weatherStation.getTemperature();
+	}
+
+	float getHumidity() const {
+		return _weatherStation.getHumidity();
+	}
+
+	float getPressure() const {
+		return _weatherStation.getPressure();
+	}
+
+	void measurementsChanged() {
+		notifyObserver();
+	}
+
+	void readMeasurements() {
+		_sensorData.temp = _weatherStation.getTemperature();
+		_sensorData.humidity = _weatherStation.getHumidity();
+		_sensorData.pressure = _weatherStation.getPressure();
+
+		measurementsChanged();
+	}
+
+	//측정값 count 개를 먼저 모두 읽은 뒤 한 번만 알린다
+	void readMeasurementsBatch(size_t count) {
+		_batch.resize(count);
+		for (SensorData& sensorData : _batch) {
+			sensorData.temp = _weatherStation.getTemperature();
+			sensorData.humidity = _weatherStation.getHumidity();
+			sensorData.pressure = _weatherStation.getPressure();
+		}
+
+		replayBatch(_batch);
+	}
+};
+
+
+
+//벤치마크용 옵저버 : 출력 없이 기온 통계만 누적한다 (묶음 처리 재정의)
+class StatisticsAccumulator : public IObserver {
+private:
+	StatisticsDisplay _statisticsDisplay;
+
+public:
+	void update(const SensorData& sensorData) override {
+		_statisticsDisplay.accumulate(SensorDataSpan(&sensorData, 1));
+	}
+
+	void updateBatch(SensorDataSpan readings) override {
+		_statisticsDisplay.accumulate(readings);
+	}
+};
+
+//벤치마크용 옵저버 : 묶음 처리를 재정의하지 않는다 (기본 구현으로 하나씩 받는다)
+class CountingObserver : public IObserver {
+private:
+	float _sum = 0.0f;
+
+public:
+	void update(const SensorData& sensorData) override {
+		_sum += sensorData.temp;
+	}
+};
+
+//미리 모아둔 측정값을 1개씩 전달할 때와 batchSize 개씩 전달할 때를 비교한다
+void benchmarkBatch(size_t batchSize) {
+	const size_t readingCount = 200000;
+
+	vector<SensorData> readings(readingCount);
+	WeatherStation weatherStation;
+	for (SensorData& sensorData : readings) {
+		sensorData.temp = weatherStation.getTemperature();
+		sensorData.humidity = weatherStation.getHumidity();
+		sensorData.pressure = weatherStation.getPressure();
+	}
+
+	WeatherData weatherData;
+	vector<Subscription> subscriptions;
+	for (int idx = 0; idx < 50; idx++) {
+		subscriptions.push_back(weatherData.registerObserver(make_shared<StatisticsAccumulator>()));
+		subscriptions.push_back(weatherData.registerObserver(make_shared<CountingObserver>()));
+	}
+
+	auto start = chrono::steady_clock::now();
+	for (size_t idx = 0; idx < readingCount; idx++) {
+		weatherData.replayBatch(SensorDataSpan(&readings[idx], 1));
+	}
+	auto middle = chrono::steady_clock::now();
+	for (size_t idx = 0; idx < readingCount; idx += batchSize) {
+		weatherData.replayBatch(SensorDataSpan(&readings[idx], min(batchSize, readingCount - idx)));
+	}
+	auto end = chrono::steady_clock::now();
+
+	double single = chrono::duration<double, milli>(middle - start).count();
+	double batch = chrono::duration<double, milli>(end - middle).count();
+	cout << "측정값 " << readingCount << "개, 옵저버 100개 : "
+		<< "1개씩 " << single << " ms, "
+		<< batchSize << "개씩 " << batch << " ms" << endl;
+}
+
+int main(int argc, char** argv) {
+
+	shared_ptr<WeatherData> pWeatherData = make_shared<WeatherData>();
+	//출력 장치 객체 생성
+	shared_ptr<StatisticsDisplay> pStatisticsDisplay = make_shared<StatisticsDisplay>();
+	shared_ptr<CurrentConditionsDisplay> pCurrentConditionsDisplay = make_shared<CurrentConditionsDisplay>();
+	shared_ptr<ForecastDisplay> pForecastDisplay = make_shared<ForecastDisplay>();
+
+	//출력 장치를 등록한다 (토큰을 보관해야 구독이 유지된다)
+	Subscription statisticsSubscription = pWeatherData->registerObserver(pStatisticsDisplay);
+	Subscription currentConditionsSubscription = pWeatherData->registerObserver(pCurrentConditionsDisplay);
+	Subscription forecastSubscription = pWeatherData->registerObserver(pForecastDisplay);
+
+	//측정값을 읽는다
+	pWeatherData->readMeasurements(); //등록된 3개의 출력 장치에 값을 출력한다
+	pWeatherData->readMeasurements();
+
+	//출력 장치를 제거한다
+	pWeatherData->removeObserver(currentConditionsSubscription);
+
+	//측정값 10개를 모아서 한 번에 알린다
+	pWeatherData->readMeasurementsBatch(10); //통계와 예보가 한 번씩만 출력된다
+
+	benchmarkBatch(64);
+	benchmarkBatch(1024);
+
+	return 0;
+}
@@ -0,0 +1,1016 @@
+﻿// observer.cpp : 이 파일에는 'main' 함수가 포함됩니다. 거기서 프로그램 실행이 시작되고 종료됩니다.
+//
+
+#include <iostream>
+#include <memory>
+#include <random>
+#include <ctime>
+#include <functional>
+#include <list>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <algorithm>
+#include <limits>
+#include <cstring>
+
+using namespace std;
+
+struct SensorData {
+	float temp;
+	float humidity;
+	float pressure;
+	float temp_top;
+	float temp_bottom;
+};
+
+//연속된 측정값 묶음을 가리키는 읽기 전용 구간 (복사하지 않는다)
+class SensorDataSpan {
+private:
+	const SensorData* _data;
+	size_t _size;
+
+public:
+	SensorDataSpan(const SensorData* data, size_t size) : _data(data), _size(size) {
+	}
+
+	SensorDataSpan(const vector<SensorData>& readings) : _data(readings.data()), _size(readings.size()) {
+	}
+
+	const SensorData* begin() const {
+		return _data;
+	}
+
+	const SensorData* end() const {
+		return _data + _size;
+	}
+
+	const SensorData& operator[](size_t idx) const {
+		return _data[idx];
+	}
+
+	const SensorData& back() const {
+		return _data[_size - 1];
+	}
+
+	size_t size() const {
+		return _size;
+	}
+
+	bool empty() const {
+		return _size == 0;
+	}
+};
+
+class IObserver {
+public:
+	virtual void update(const SensorData& sensorData) = 0;
+
+	//여러 측정값을 가상 함수 호출 한 번으로 받는다
+	//기본 구현은 하나씩 update() 를 호출하고, 한꺼번에 처리할 수 있는 옵저버는 재정의한다
+	virtual void updateBatch(SensorDataSpan readings) {
+		for (const SensorData& sensorData : readings) {
+			update(sensorData);
+		}
+	}
+};
+
+//등록된 옵저버를 가리키는 핸들 (슬롯 번호 + 세대)
+//제거된 뒤 같은 슬롯이 재사용되면 세대가 달라지므로 예전 핸들은 무효가 된다
+struct ObserverHandle {
+	uint32_t index = UINT32_MAX;
+	uint32_t generation = 0;
+};
+
+//슬롯맵(slot map) 방식의 옵저버 저장소
+//제거는 핸들로 O(1) 에 처리하고 빈칸은 표시만 해 둔다
+//
+//통보 도중(update() 안)에 등록/제거가 일어나도 안전하도록 구조 변경은 미뤄 둔다
+// - 등록 : 배열 끝에 추가되므로 이번 통보에서는 보이지 않고 다음 통보부터 받는다
+// - 제거 : 빈칸으로 표시만 하고 옵저버 객체도 통보가 끝날 때까지 놓아주지 않는다
+// - 정리(compact) : 가장 바깥 통보가 끝난 뒤에 한 번만 한다
+//목록을 복사하지 않으므로 평상시 통보 경로에서는 메모리 할당이 전혀 없다
+class ObserverRegistry {
+private:
+	static const uint32_t INVALID_INDEX = UINT32_MAX;
+
+	struct Slot {
+		uint32_t denseIndex; //_observers 안의 위치 (INVALID_INDEX 이면 빈 슬롯)
+		uint32_t generation; //슬롯 재사용 횟수
+	};
+
+	vector<IObserver*> _observers;         //통보할 때 순회하는 연속 배열 (정리 전에는 nullptr 빈칸이 있을 수 있다)
+	vector<shared_ptr<IObserver>> _owners; //수명 유지용 (통보할 때는 읽지 않는다)
+	vector<uint32_t> _denseToSlot;         //_observers 위치 -> 슬롯 번호
+	vector<Slot> _slots;                   //핸들 -> _observers 위치
+	vector<uint32_t> _freeSlots;           //재사용할 빈 슬롯 번호
+	vector<shared_ptr<IObserver>> _released; //정리 중에 놓아줄 옵저버 (용량은 재사용한다)
+	size_t _holeCount = 0;                 //정리되지 않은 빈칸 수
+	int _dispatchDepth = 0;                //진행 중인 통보 깊이 (update() 안에서 다시 통보할 수 있다)
+
+	//예외가 나도 통보 깊이가 복구되도록 한다
+	class DispatchScope {
+	private:
+		ObserverRegistry& _registry;
+
+	public:
+		DispatchScope(ObserverRegistry& registry) : _registry(registry) {
+			_registry._dispatchDepth++;
+		}
+
+		~DispatchScope() {
+			if (--_registry._dispatchDepth == 0) {
+				_registry.compact();
+			}
+		}
+	};
+
+public:
+	void reserve(size_t count) {
+		_observers.reserve(count);
+		_owners.reserve(count);
+		_denseToSlot.reserve(count);
+		_slots.reserve(count);
+	}
+
+	size_t size() const {
+		return _observers.size() - _holeCount;
+	}
+
+	bool isDispatching() const {
+		return _dispatchDepth > 0;
+	}
+
+	//배열 끝에 추가한다 : O(1)
+	ObserverHandle insert(shared_ptr<IObserver> pObserver) {
+		uint32_t slotIndex;
+		if (_freeSlots.empty()) {
+			slotIndex = static_cast<uint32_t>(_slots.size());
+			_slots.push_back(Slot{ INVALID_INDEX, 0 });
+		}
+		else {
+			slotIndex = _freeSlots.back();
+			_freeSlots.pop_back();
+		}
+
+		Slot& slot = _slots[slotIndex];
+		slot.denseIndex = static_cast<uint32_t>(_observers.size());
+
+		_observers.push_back(pObserver.get());
+		_owners.push_back(move(pObserver));
+		_denseToSlot.push_back(slotIndex);
+
+		return ObserverHandle{ slotIndex, slot.generation };
+	}
+
+	bool contains(ObserverHandle handle) const {
+		return handle.index < _slots.size()
+			&& _slots[handle.index].denseIndex != INVALID_INDEX
+			&& _slots[handle.index].generation == handle.generation;
+	}
+
+	//빈칸으로 표시만 한다 : O(1)
+	//통보 중이면 update() 가 아직 실행 중일 수 있으므로 옵저버 객체는 정리할 때 놓아준다
+	bool erase(ObserverHandle handle) {
+		if (!contains(handle)) {
+			return false;
+		}
+
+		Slot& slot = _slots[handle.index];
+		uint32_t denseIndex = slot.denseIndex;
+		_observers[denseIndex] = nullptr;
+		_holeCount++;
+
+		slot.denseIndex = INVALID_INDEX;
+		slot.generation++;
+		_freeSlots.push_back(handle.index);
+
+		if (!isDispatching()) {
+			_owners[denseIndex].reset();
+		}
+		return true;
+	}
+
+	//빈칸을 제거하고 남은 옵저버를 앞으로 당긴다 (등록 순서 유지)
+	//통보 중에는 아무 일도 하지 않고 가장 바깥 통보가 끝날 때 다시 불린다
+	void compact() {
+		if (_holeCount == 0 || isDispatching()) {
+			return;
+		}
+
+		size_t writeIndex = 0;
+		for (size_t readIndex = 0; readIndex < _observers.size(); readIndex++) {
+			if (_observers[readIndex] == nullptr) {
+				if (_owners[readIndex]) {
+					_released.push_back(move(_owners[readIndex]));
+				}
+				continue;
+			}
+			if (writeIndex != readIndex) {
+				_observers[writeIndex] = _observers[readIndex];
+				_owners[writeIndex] = move(_owners[readIndex]);
+				_denseToSlot[writeIndex] = _denseToSlot[readIndex];
+				_slots[_denseToSlot[writeIndex]].denseIndex = static_cast<uint32_t>(writeIndex);
+			}
+			writeIndex++;
+		}
+
+		_observers.resize(writeIndex);
+		_owners.resize(writeIndex);
+		_denseToSlot.resize(writeIndex);
+		_holeCount = 0;
+
+		//옵저버 소멸자가 다시 등록/제거를 해도 되도록 배열 정리가 끝난 뒤에 놓아준다
+		_released.clear();
+	}
+
+	//통보 시작 시점의 옵저버만 순회한다
+	//배열이 재할당될 수 있으므로 반복자 대신 위치로 접근하고, 도중에 생긴 빈칸은 건너뛴다
+	template <typename Func>
+	void forEach(Func&& func) {
+		compact();
+		DispatchScope scope(*this);
+
+		const size_t count = _observers.size();
+		for (size_t idx = 0; idx < count; idx++) {
+			IObserver* pObserver = _observers[idx];
+			if (pObserver != nullptr) {
+				func(*pObserver);
+			}
+		}
+	}
+};
+
+//registerObserver() 가 돌려주는 구독 토큰
+//토큰이 소멸되거나 release() 를 호출하면 O(1) 로 구독이 해제된다
+//주제 객체가 먼저 사라져도 안전하도록 저장소는 weak_ptr 로 가리킨다
+class Subscription {
+private:
+	weak_ptr<ObserverRegistry> _registry;
+	ObserverHandle _handle;
+
+public:
+	Subscription() = default;
+
+	Subscription(weak_ptr<ObserverRegistry> registry, ObserverHandle handle)
+		: _registry(move(registry)), _handle(handle) {
+	}
+
+	Subscription(const Subscription&) = delete;
+	Subscription& operator=(const Subscription&) = delete;
+
+	Subscription(Subscription&& r) noexcept
+		: _registry(move(r._registry)), _handle(r._handle) {
+		r._registry.reset();
+	}
+
+	Subscription& operator=(Subscription&& r) noexcept {
+		if (this != &r) {
+			release();
+			_registry = move(r._registry);
+			_handle = r._handle;
+			r._registry.reset();
+		}
+		return *this;
+	}
+
+	~Subscription() {
+		release();
+	}
+
+	//구독 해제
+	void release() {
+		if (shared_ptr<ObserverRegistry> pRegistry = _registry.lock()) {
+			pRegistry->erase(_handle);
+		}
+		_registry.reset();
+	}
+
+	//토큰과의 연결만 끊고 구독은 주제 객체가 사라질 때까지 유지한다
+	void detach() {
+		_registry.reset();
+	}
+
+	bool isActive() const {
+		shared_ptr<ObserverRegistry> pRegistry = _registry.lock();
+		return pRegistry && pRegistry->contains(_handle);
+	}
+};
+
+class ISubject {
+
+public:
+	//옵저버 등록 : 반환된 토큰이 살아있는 동안만 구독이 유지된다
+	[[nodiscard]] virtual Subscription registerObserver(shared_ptr<IObserver> pObserver) = 0;
+
+	//옵저버 제거
+	virtual void removeObserver(Subscription& subscription) = 0;
+
+	//변경 사실을 알린다
+	virtual void notifyObserver() = 0;
+};
+
+class Random {
+private:
+	// 시드값을 얻기 위한 random_device 생성.
+	random_device _rd;
+
+	// random_device 를 통해 난수 생성 엔진을 초기화 한다.
+	// getValue() const 에서 상태를 바꾸므로 mutable 로 선언한다
+	mutable mt19937 _generator;
+
+	// 예 :  0 부터 99 까지 균등하게 나타나는 난수열을 생성하기 위해 균등 분포 정의.
+	mutable uniform_int_distribution<int> _distribution;
+
+public:
+	Random(int from, int to) : _generator{ _rd() },
+		_distribution{from, to} {
+
+	}
+
+	int getValue() const {
+		return _distribution(_generator);
+	}
+};
+
+class WeatherStation {
+private:
+	Random _randomTemperature; //온도 난수 객체
+	Random _randomHumidity; //습도 난수 객체
+	Random _randomPressure; //압력 난수 객체
+
+public :
+	WeatherStation() : _randomTemperature{ -50, 50 }
+		, _randomHumidity{ -100, 100 }
+		, _randomPressure{ -100, 100 } {
+	}
+
+	float getTemperature() const {
+		return 25.0f + _randomTemperature.getValue() / 10.0f;
+	}
+	float getHumidity() const {
+		return 60.0f + _randomHumidity.getValue() / 10.0f;
+	};
+	float getPressure() const {
+		return 25.0f +  _randomPressure.getValue() / 10.0f;
+	};
+
+};
+
+
+//측정값 묶음 통계 커널 (SIMD)
+//
+//구조체 배열(SensorData[]) 대신 필드별 배열(온도[], 습도[], 기압[])을 한 번에 훑어서
+//세 필드의 합계, 최소, 최대, 평균, 분산을 구한다
+//
+//스칼라/SSE/AVX2 결과가 비트 단위까지 같도록 덧셈 순서를 하나로 정해 둔다
+// - 원소 i 는 레인 (i % 8) 에 더한다 (AVX2 폭 기준, SSE 는 레지스터 4개로 8 레인을 흉내낸다)
+// - 합계는 double 로, 첫 원소를 뺀 값(x - K)으로 누적해 자리수 손실을 줄인다
+// - 레인을 합치는 순서는 reduceLanes() 하나만 쓴다
+//곱셈-덧셈이 FMA 로 합쳐지면 반올림이 달라지므로 FMA 축약 없이 빌드해야 한다 (/fp:precise, -ffp-contract=off)
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define STATISTICS_SIMD 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define TARGET_AVX2
+#else
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+//필드 하나의 통계
+struct FieldStatistics {
+	double sum = 0.0;
+	float min = 0.0f;
+	float max = 0.0f;
+	double mean = 0.0;
+	double variance = 0.0; //모분산
+};
+
+//측정값 묶음의 통계
+struct BlockStatistics {
+	size_t count = 0;
+	FieldStatistics temp;
+	FieldStatistics humidity;
+	FieldStatistics pressure;
+};
+
+//필드별 배열로 나눈 측정값 묶음 (버퍼는 재사용한다)
+struct SensorColumns {
+	vector<float> temp;
+	vector<float> humidity;
+	vector<float> pressure;
+
+	size_t size() const {
+		return temp.size();
+	}
+
+	void assign(SensorDataSpan readings) {
+		temp.resize(readings.size());
+		humidity.resize(readings.size());
+		pressure.resize(readings.size());
+		for (size_t idx = 0; idx < readings.size(); idx++) {
+			temp[idx] = readings[idx].temp;
+			humidity[idx] = readings[idx].humidity;
+			pressure[idx] = readings[idx].pressure;
+		}
+	}
+};
+
+static const size_t STATISTICS_LANES = 8;
+
+//레인별 중간 결과
+struct LaneAccumulator {
+	double sum[STATISTICS_LANES];   //(x - K) 의 합
+	double sumSq[STATISTICS_LANES]; //(x - K)^2 의 합
+	float min[STATISTICS_LANES];
+	float max[STATISTICS_LANES];
+	double shift;                   //K : 첫 원소
+
+	void reset(float first) {
+		for (size_t lane = 0; lane < STATISTICS_LANES; lane++) {
+			sum[lane] = 0.0;
+			sumSq[lane] = 0.0;
+			min[lane] = numeric_limits<float>::infinity();
+			max[lane] = -numeric_limits<float>::infinity();
+		}
+		shift = first;
+	}
+
+	//스칼라 누적 : SIMD 명령의 minps/maxps 와 같은 비교 방식을 쓴다
+	void add(size_t lane, float x) {
+		double d = static_cast<double>(x) - shift;
+		double sq = d * d;
+		sum[lane] += d;
+		sumSq[lane] += sq;
+		min[lane] = (x < min[lane]) ? x : min[lane];
+		max[lane] = (x > max[lane]) ? x : max[lane];
+	}
+};
+
+//레인 8개를 정해진 순서로 합친다 : ((0+4)+(2+6)) + ((1+5)+(3+7))
+double reduceLanes(const double lanes[STATISTICS_LANES]) {
+	double half[4];
+	for (size_t idx = 0; idx < 4; idx++) {
+		half[idx] = lanes[idx] + lanes[idx + 4];
+	}
+	return (half[0] + half[2]) + (half[1] + half[3]);
+}
+
+FieldStatistics finishField(const LaneAccumulator& lanes, size_t count) {
+	FieldStatistics result;
+	if (count == 0) {
+		return result;
+	}
+
+	double shiftedSum = reduceLanes(lanes.sum);
+	double shiftedSumSq = reduceLanes(lanes.sumSq);
+
+	result.min = lanes.min[0];
+	result.max = lanes.max[0];
+	for (size_t lane = 1; lane < STATISTICS_LANES; lane++) {
+		result.min = (lanes.min[lane] < result.min) ? lanes.min[lane] : result.min;
+		result.max = (lanes.max[lane] > result.max) ? lanes.max[lane] : result.max;
+	}
+
+	double n = static_cast<double>(count);
+	result.sum = shiftedSum + lanes.shift * n;
+	result.mean = lanes.shift + shiftedSum / n;
+	result.variance = max(0.0, (shiftedSumSq - shiftedSum * shiftedSum / n) / n);
+	return result;
+}
+
+//8개 단위로 처리하지 못한 나머지 원소를 스칼라로 누적한다
+void addTail(const SensorColumns& columns, size_t from, LaneAccumulator (&lanes)[3]) {
+	for (size_t idx = from; idx < columns.size(); idx++) {
+		size_t lane = idx % STATISTICS_LANES;
+		lanes[0].add(lane, columns.temp[idx]);
+		lanes[1].add(lane, columns.humidity[idx]);
+		lanes[2].add(lane, columns.pressure[idx]);
+	}
+}
+
+void computeStatisticsScalar(const SensorColumns& columns, LaneAccumulator (&lanes)[3]) {
+	addTail(columns, 0, lanes);
+}
+
+#ifdef STATISTICS_SIMD
+//SSE2 : double 레인 2개짜리 레지스터 4개로 8 레인을 만든다
+struct SseField {
+	__m128d sum[4];
+	__m128d sumSq[4];
+	__m128 min[2];
+	__m128 max[2];
+	__m128d shift;
+
+	void load(const LaneAccumulator& lanes) {
+		for (int idx = 0; idx < 4; idx++) {
+			sum[idx] = _mm_loadu_pd(&lanes.sum[idx * 2]);
+			sumSq[idx] = _mm_loadu_pd(&lanes.sumSq[idx * 2]);
+		}
+		for (int idx = 0; idx < 2; idx++) {
+			min[idx] = _mm_loadu_ps(&lanes.min[idx * 4]);
+			max[idx] = _mm_loadu_ps(&lanes.max[idx * 4]);
+		}
+		shift = _mm_set1_pd(lanes.shift);
+	}
+
+	void store(LaneAccumulator& lanes) const {
+		for (int idx = 0; idx < 4; idx++) {
+			_mm_storeu_pd(&lanes.sum[idx * 2], sum[idx]);
+			_mm_storeu_pd(&lanes.sumSq[idx * 2], sumSq[idx]);
+		}
+		for (int idx = 0; idx < 2; idx++) {
+			_mm_storeu_ps(&lanes.min[idx * 4], min[idx]);
+			_mm_storeu_ps(&lanes.max[idx * 4], max[idx]);
+		}
+	}
+
+	void add(const float* values) {
+		for (int half = 0; half < 2; half++) {
+			__m128 x = _mm_loadu_ps(values + half * 4);
+			min[half] = _mm_min_ps(x, min[half]);
+			max[half] = _mm_max_ps(x, max[half]);
+
+			__m128d low = _mm_sub_pd(_mm_cvtps_pd(x), shift);
+			__m128d high = _mm_sub_pd(_mm_cvtps_pd(_mm_movehl_ps(x, x)), shift);
+			sum[half * 2] = _mm_add_pd(sum[half * 2], low);
+			sum[half * 2 + 1] = _mm_add_pd(sum[half * 2 + 1], high);
+			sumSq[half * 2] = _mm_add_pd(sumSq[half * 2], _mm_mul_pd(low, low));
+			sumSq[half * 2 + 1] = _mm_add_pd(sumSq[half * 2 + 1], _mm_mul_pd(high, high));
+		}
+	}
+};
+
+void computeStatisticsSse(const SensorColumns& columns, LaneAccumulator (&lanes)[3]) {
+	SseField temp, humidity, pressure;
+	temp.load(lanes[0]);
+	humidity.load(lanes[1]);
+	pressure.load(lanes[2]);
+
+	size_t full = columns.size() / STATISTICS_LANES * STATISTICS_LANES;
+	for (size_t idx = 0; idx < full; idx += STATISTICS_LANES) {
+		temp.add(&columns.temp[idx]);
+		humidity.add(&columns.humidity[idx]);
+		pressure.add(&columns.pressure[idx]);
+	}
+
+	temp.store(lanes[0]);
+	humidity.store(lanes[1]);
+	pressure.store(lanes[2]);
+	addTail(columns, full, lanes);
+}
+
+//AVX2 : double 레인 4개짜리 레지스터 2개로 8 레인을 만든다
+struct Avx2Field {
+	__m256d sum[2];
+	__m256d sumSq[2];
+	__m256 min;
+	__m256 max;
+	__m256d shift;
+
+	TARGET_AVX2 void load(const LaneAccumulator& lanes) {
+		for (int idx = 0; idx < 2; idx++) {
+			sum[idx] = _mm256_loadu_pd(&lanes.sum[idx * 4]);
+			sumSq[idx] = _mm256_loadu_pd(&lanes.sumSq[idx * 4]);
+		}
+		min = _mm256_loadu_ps(lanes.min);
+		max = _mm256_loadu_ps(lanes.max);
+		shift = _mm256_set1_pd(lanes.shift);
+	}
+
+	TARGET_AVX2 void store(LaneAccumulator& lanes) const {
+		for (int idx = 0; idx < 2; idx++) {
+			_mm256_storeu_pd(&lanes.sum[idx * 4], sum[idx]);
+			_mm256_storeu_pd(&lanes.sumSq[idx * 4], sumSq[idx]);
+		}
+		_mm256_storeu_ps(lanes.min, min);
+		_mm256_storeu_ps(lanes.max, max);
+	}
+
+	TARGET_AVX2 void add(const float* values) {
+		__m256 x = _mm256_loadu_ps(values);
+		min = _mm256_min_ps(x, min);
+		max = _mm256_max_ps(x, max);
+
+		__m256d low = _mm256_sub_pd(_mm256_cvtps_pd(_mm256_castps256_ps128(x)), shift);
+		__m256d high = _mm256_sub_pd(_mm256_cvtps_pd(_mm256_extractf128_ps(x, 1)), shift);
+		sum[0] = _mm256_add_pd(sum[0], low);
+		sum[1] = _mm256_add_pd(sum[1], high);
+		sumSq[0] = _mm256_add_pd(sumSq[0], _mm256_mul_pd(low, low));
+		sumSq[1] = _mm256_add_pd(sumSq[1], _mm256_mul_pd(high, high));
+	}
+};
+
+TARGET_AVX2 void computeStatisticsAvx2(const SensorColumns& columns, LaneAccumulator (&lanes)[3]) {
+	Avx2Field temp, humidity, pressure;
+	temp.load(lanes[0]);
+	humidity.load(lanes[1]);
+	pressure.load(lanes[2]);
+
+	size_t full = columns.size() / STATISTICS_LANES * STATISTICS_LANES;
+	for (size_t idx = 0; idx < full; idx += STATISTICS_LANES) {
+		temp.add(&columns.temp[idx]);
+		humidity.add(&columns.humidity[idx]);
+		pressure.add(&columns.pressure[idx]);
+	}
+
+	temp.store(lanes[0]);
+	humidity.store(lanes[1]);
+	pressure.store(lanes[2]);
+	addTail(columns, full, lanes);
+}
+
+//CPU 와 운영체제가 AVX2 를 지원하는지 확인한다
+bool isAvx2Supported() {
+#if defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7) {
+		return false;
+	}
+	__cpuid(info, 1);
+	bool osxsave = (info[2] & (1 << 27)) != 0;
+	bool avx = (info[2] & (1 << 28)) != 0;
+	if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) {
+		return false;
+	}
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#else
+	return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
+enum class StatisticsKernel {
+	Scalar,
+	Sse,
+	Avx2,
+};
+
+//실행 중인 CPU 에서 쓸 수 있는 가장 빠른 커널
+StatisticsKernel detectStatisticsKernel() {
+#ifdef STATISTICS_SIMD
+	if (isAvx2Supported()) {
+		return StatisticsKernel::Avx2;
+	}
+	return StatisticsKernel::Sse; //x86 MSVC 기본값(/arch:SSE2)과 x64 는 SSE2 를 항상 지원한다
+#else
+	return StatisticsKernel::Scalar;
+#endif
+}
+
+const char* getKernelName(StatisticsKernel kernel) {
+	switch (kernel) {
+	case StatisticsKernel::Avx2:
+		return "AVX2";
+	case StatisticsKernel::Sse:
+		return "SSE2";
+	default:
+		return "스칼라";
+	}
+}
+
+//커널을 지정해서 통계를 구한다 (지원하지 않는 커널을 지정하면 스칼라로 처리한다)
+BlockStatistics computeStatistics(const SensorColumns& columns, StatisticsKernel kernel) {
+	BlockStatistics result;
+	result.count = columns.size();
+	if (result.count == 0) {
+		return result;
+	}
+
+	LaneAccumulator lanes[3];
+	lanes[0].reset(columns.temp[0]);
+	lanes[1].reset(columns.humidity[0]);
+	lanes[2].reset(columns.pressure[0]);
+
+	switch (kernel) {
+#ifdef STATISTICS_SIMD
+	case StatisticsKernel::Avx2:
+		computeStatisticsAvx2(columns, lanes);
+		break;
+	case StatisticsKernel::Sse:
+		computeStatisticsSse(columns, lanes);
+		break;
+#endif
+	default:
+		computeStatisticsScalar(columns, lanes);
+		break;
+	}
+
+	result.temp = finishField(lanes[0], result.count);
+	result.humidity = finishField(lanes[1], result.count);
+	result.pressure = finishField(lanes[2], result.count);
+	return result;
+}
+
+//처음 한 번 CPU 를 확인해서 고른 커널로 통계를 구한다
+BlockStatistics computeStatistics(const SensorColumns& columns) {
+	static const StatisticsKernel kernel = detectStatisticsKernel();
+	return computeStatistics(columns, kernel);
+}
+
+class StatisticsDisplay : public IObserver {
+private:
+	float _maxTemp = 0.0f;
+	float _minTemp = 100.0f;
+	float _tempSum = 0.0f;
+	int _numReadings = 0;
+
+	SensorColumns _columns;     //묶음을 필드별 배열로 옮겨 담는 버퍼 (재사용)
+	BlockStatistics _lastBatch; //마지막 묶음의 통계
+
+public:
+	void update(const SensorData& sensorData) override {
+		update(sensorData.temp, sensorData.humidity, sensorData.pressure);
+	}
+
+	void update(float temp, float humidity, float pressure) {
+		_tempSum += temp;
+		_numReadings++;
+
+		if (temp > _maxTemp) {
+			_maxTemp = temp;
+		}
+
+		if (temp < _minTemp) {
+			_minTemp = temp;
+		}
+
+		display();
+	}
+
+	//묶음 전체를 누적한 뒤 한 번만 출력한다
+	void updateBatch(SensorDataSpan readings) override {
+		if (readings.empty()) {
+			return;
+		}
+
+		accumulate(readings);
+		display();
+	}
+
+	//출력 없이 누적만 한다 (SIMD 커널로 세 필드를 한 번에 계산)
+	void accumulate(SensorDataSpan readings) {
+		_columns.assign(readings);
+		_lastBatch = computeStatistics(_columns);
+
+		_tempSum += static_cast<float>(_lastBatch.temp.sum);
+		_numReadings += static_cast<int>(_lastBatch.count);
+		_maxTemp = max(_maxTemp, _lastBatch.temp.max);
+		_minTemp = min(_minTemp, _lastBatch.temp.min);
+	}
+
+	void display() {
+		cout << "기상 통계 " << endl
+			<< "평균 기온 : " << (_tempSum / _numReadings) << "℃" << endl
+			<< "최저 기온 : " << _minTemp << "℃" << endl
+			<< "최고 기온 : " << _maxTemp << "℃" << endl;
+
+		if (_lastBatch.count > 0) {
+			cout << "최근 " << _lastBatch.count << "개 기온 분산 : " << _lastBatch.temp.variance << endl
+				<< "최근 " << _lastBatch.count << "개 평균 습도 : " << _lastBatch.humidity.mean << "%" << endl
+				<< "최근 " << _lastBatch.count << "개 평균 기압 : " << _lastBatch.pressure.mean << endl;
+		}
+		cout << endl;
+	}
+};
+
+class CurrentConditionsDisplay : public IObserver {
+private:
+	float _temperature;
+	float _humidity;
+	float _pressure;
+
+public:
+	void update(const SensorData& sensorData) override {
+		update(sensorData.temp, sensorData.humidity, sensorData.pressure);
+	}
+
+	void update(float temperature, float humidity, float pressure) {
+		_temperature = temperature;
+		_humidity = humidity;
+		_pressure = pressure;
+		display();
+	}
+
+	void display() {
+		cout << "현재 조건 " << endl
+			<< "온도: " << _temperature << "℃" << endl
+			<< "습도: " << _humidity << "%" << endl
+			<< "기압: " << _pressure << endl << endl;
+
+	}
+};
+
+class ForecastDisplay : public IObserver {
+private:
+	float _currentPressure = 29.92f;
+	float _lastPressure;
+
+public:
+	void update(const SensorData& sensorData) override {
+		update(sensorData.temp, sensorData.humidity, sensorData.pressure);
+	}
+
+	void update(float temp, float humidity, float pressure) {
+		_lastPressure = _currentPressure;
+		_currentPressure = pressure;
+
+		display();
+	}
+
+	//예보는 마지막 두 기압만 비교하므로 묶음의 끝부분만 보고 한 번만 출력한다
+	void updateBatch(SensorDataSpan readings) override {
+		if (readings.empty()) {
+			return;
+		}
+
+		_lastPressure = readings.size() >= 2 ? readings[readings.size() - 2].pressure : _currentPressure;
+		_currentPressure = readings.back().pressure;
+
+		display();
+	}
+
+	void display() {
+		cout << "기상 예보" << endl;
+		if (_currentPressure > _lastPressure) {
+			cout << "가는 길에 날씨 개선" << endl << endl;
+		}
+		else if (_currentPressure == _lastPressure) {
+			cout << "전과 같음" << endl << endl;
+		}
+		else if (_currentPressure < _lastPressure) {
+			cout << "선선하고 비오는 날씨에 조심하십시오" << endl << endl;
+		}
+	}
+};
+
+
+class WeatherData : public ISubject {
+private:
+	WeatherStation _weatherStation;
+
+	//ISubject 구현시 사용할 멤버변수
+	//구독 토큰이 weak_ptr 로 가리킬 수 있도록 shared_ptr 로 보관한다
+	shared_ptr<ObserverRegistry> _registry = make_shared<ObserverRegistry>();
+
+	SensorData _sensorData;
+
+	//readMeasurementsBatch() 에서 재사용하는 버퍼 (용량을 유지하므로 매번 할당하지 않는다)
+	vector<SensorData> _batch;
+
+public:
+
+	//옵저버 등록
+	Subscription registerObserver(shared_ptr<IObserver> pObserver) override {
+		return Subscription(_registry, _registry->insert(move(pObserver)));
+	}
+
+	//옵저버 제거
+	void removeObserver(Subscription& subscription) override {
+		subscription.release();
+	}
+
+	//변경 사실을 알린다
+	void notifyObserver() override {
+		const SensorData& sensorData = _sensorData;
+		_registry->forEach([&sensorData](IObserver& observer) {
+			observer.update(sensorData);
+		});
+	}
+
+	size_t getObserverCount() const {
+		return _registry->size();
+	}
+
+	//여러 측정값을 옵저버마다 한 번에 알린다
+	void notifyObserverBatch(SensorDataSpan readings) {
+		_registry->forEach([&readings](IObserver& observer) {
+			observer.updateBatch(readings);
+		});
+	}
+
+	//이미 수집된 측정값(밀린 기록 등)을 한 번에 전달한다
+	void replayBatch(SensorDataSpan readings) {
+		if (readings.empty()) {
+			return;
+		}
+		_sensorData = readings.back();
+		notifyObserverBatch(readings);
+	}
+
+	float getTemperature() const {
+		return _weatherStation.getTemperature();
+	}
+
+	float getHumidity() const {
+		return _weatherStation.getHumidity();
+	}
+
+	float getPressure() const {
+		return _weatherStation.getPressure();
+	}
+
+	void measurementsChanged() {
+		notifyObserver();
+	}
+
+	void readMeasurements() {
+		_sensorData.temp = _weatherStation.getTemperature();
+		_sensorData.humidity = _weatherStation.getHumidity();
+		_sensorData.pressure = _weatherStation.getPressure();
+
+		measurementsChanged();
+	}
+
+	//측정값 count 개를 먼저 모두 읽은 뒤 한 번만 알린다
+	void readMeasurementsBatch(size_t count) {
+		_batch.resize(count);
+		for (SensorData& sensorData : _batch) {
+			sensorData.temp = _weatherStation.getTemperature();
+			sensorData.humidity = _weatherStation.getHumidity();
+			sensorData.pressure = _weatherStation.getPressure();
+		}
+
+		replayBatch(_batch);
+	}
+};
+
+
+
+
+//스칼라 결과와 비트 단위로 같은지 확인한다
+bool isSameBits(const BlockStatistics& left, const BlockStatistics& right) {
+	return memcmp(&left, &right, sizeof(BlockStatistics)) == 0;
+}
+
+//통계 커널별 처리 속도를 비교하고 결과가 스칼라와 같은지 확인한다
+void benchmarkStatisticsKernels(size_t count) {
+	const int rounds = 20;
+
+	SensorColumns columns;
+	WeatherStation weatherStation;
+	columns.temp.resize(count);
+	columns.humidity.resize(count);
+	columns.pressure.resize(count);
+	for (size_t idx = 0; idx < count; idx++) {
+		columns.temp[idx] = weatherStation.getTemperature();
+		columns.humidity[idx] = weatherStation.getHumidity();
+		columns.pressure[idx] = weatherStation.getPressure();
+	}
+
+	StatisticsKernel best = detectStatisticsKernel();
+	vector<StatisticsKernel> kernels = { StatisticsKernel::Scalar };
+	if (best != StatisticsKernel::Scalar) {
+		kernels.push_back(StatisticsKernel::Sse);
+	}
+	if (best == StatisticsKernel::Avx2) {
+		kernels.push_back(StatisticsKernel::Avx2);
+	}
+
+	BlockStatistics reference = computeStatistics(columns, StatisticsKernel::Scalar);
+	cout << "측정값 " << count << "개 : 평균 기온 " << reference.temp.mean
+		<< ", 기온 분산 " << reference.temp.variance << endl;
+
+	for (StatisticsKernel kernel : kernels) {
+		BlockStatistics result;
+		auto start = chrono::steady_clock::now();
+		for (int round = 0; round < rounds; round++) {
+			result = computeStatistics(columns, kernel);
+		}
+		auto end = chrono::steady_clock::now();
+
+		double seconds = chrono::duration<double>(end - start).count() / rounds;
+		cout << "  " << getKernelName(kernel) << " : "
+			<< count / seconds / 1e6 << " 백만 측정값/초, "
+			<< "스칼라와 " << (isSameBits(result, reference) ? "같음" : "다름") << endl;
+	}
+}
+
+int main(int argc, char** argv) {
+
+	shared_ptr<WeatherData> pWeatherData = make_shared<WeatherData>();
+	//출력 장치 객체 생성
+	shared_ptr<StatisticsDisplay> pStatisticsDisplay = make_shared<StatisticsDisplay>();
+	shared_ptr<ForecastDisplay> pForecastDisplay = make_shared<ForecastDisplay>();
+
+	//출력 장치를 등록한다 (토큰을 보관해야 구독이 유지된다)
+	Subscription statisticsSubscription = pWeatherData->registerObserver(pStatisticsDisplay);
+	Subscription forecastSubscription = pWeatherData->registerObserver(pForecastDisplay);
+
+	//측정값을 읽는다
+	pWeatherData->readMeasurements();
+
+	//측정값 100개를 모아서 한 번에 알린다 (통계는 SIMD 커널로 계산)
+	pWeatherData->readMeasurementsBatch(100);
+
+	cout << "통계 커널 : " << getKernelName(detectStatisticsKernel()) << endl;
+	benchmarkStatisticsKernels(1000003);
+	benchmarkStatisticsKernels(16);
+
+	return 0;
+}
@@ -0,0 +1,907 @@
+﻿// observer.cpp : 이 파일에는 'main' 함수가 포함됩니다. 거기서 프로그램 실행이 시작되고 종료됩니다.
+//
+
+#include <iostream>
+#include <memory>
+#include <random>
+#include <ctime>
+#include <functional>
+#include <list>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <algorithm>
+
+using namespace std;
+
+struct SensorData {
+	float temp;
+	float humidity;
+	float pressure;
+	float temp_top;
+	float temp_bottom;
+};
+
+//연속된 측정값 묶음을 가리키는 읽기 전용 구간 (복사하지 않는다)
+class SensorDataSpan {
+private:
+	const SensorData* _data;
+	size_t _size;
+
+public:
+	SensorDataSpan(const SensorData* data, size_t size) : _data(data), _size(size) {
+	}
+
+	SensorDataSpan(const vector<SensorData>& readings) : _data(readings.data()), _size(readings.size()) {
+	}
+
+	const SensorData* begin() const {
+		return _data;
+	}
+
+	const SensorData* end() const {
+		return _data + _size;
+	}
+
+	const SensorData& operator[](size_t idx) const {
+		return _data[idx];
+	}
+
+	const SensorData& back() const {
+		return _data[_size - 1];
+	}
+
+	size_t size() const {
+		return _size;
+	}
+
+	bool empty() const {
+		return _size == 0;
+	}
+};
+
+class IObserver {
+public:
+	virtual void update(const SensorData& sensorData) = 0;
+
+	//여러 측정값을 가상 함수 호출 한 번으로 받는다
+	//기본 구현은 하나씩 update() 를 호출하고, 한꺼번에 처리할 수 있는 옵저버는 재정의한다
+	virtual void updateBatch(SensorDataSpan readings) {
+		for (const SensorData& sensorData : readings) {
+			update(sensorData);
+		}
+	}
+};
+
+//등록된 옵저버를 가리키는 핸들 (슬롯 번호 + 세대)
+//제거된 뒤 같은 슬롯이 재사용되면 세대가 달라지므로 예전 핸들은 무효가 된다
+struct ObserverHandle {
+	uint32_t index = UINT32_MAX;
+	uint32_t generation = 0;
+};
+
+//슬롯맵(slot map) 방식의 옵저버 저장소
+//제거는 핸들로 O(1) 에 처리하고 빈칸은 표시만 해 둔다
+//
+//통보 도중(update() 안)에 등록/제거가 일어나도 안전하도록 구조 변경은 미뤄 둔다
+// - 등록 : 배열 끝에 추가되므로 이번 통보에서는 보이지 않고 다음 통보부터 받는다
+// - 제거 : 빈칸으로 표시만 하고 옵저버 객체도 통보가 끝날 때까지 놓아주지 않는다
+// - 정리(compact) : 가장 바깥 통보가 끝난 뒤에 한 번만 한다
+//목록을 복사하지 않으므로 평상시 통보 경로에서는 메모리 할당이 전혀 없다
+class ObserverRegistry {
+private:
+	static const uint32_t INVALID_INDEX = UINT32_MAX;
+
+	struct Slot {
+		uint32_t denseIndex; //_observers 안의 위치 (INVALID_INDEX 이면 빈 슬롯)
+		uint32_t generation; //슬롯 재사용 횟수
+	};
+
+	vector<IObserver*> _observers;         //통보할 때 순회하는 연속 배열 (정리 전에는 nullptr 빈칸이 있을 수 있다)
+	vector<shared_ptr<IObserver>> _owners; //수명 유지용 (통보할 때는 읽지 않는다)
+	vector<uint32_t> _denseToSlot;         //_observers 위치 -> 슬롯 번호
+	vector<Slot> _slots;                   //핸들 -> _observers 위치
+	vector<uint32_t> _freeSlots;           //재사용할 빈 슬롯 번호
+	vector<shared_ptr<IObserver>> _released; //정리 중에 놓아줄 옵저버 (용량은 재사용한다)
+	size_t _holeCount = 0;                 //정리되지 않은 빈칸 수
+	int _dispatchDepth = 0;                //진행 중인 통보 깊이 (update() 안에서 다시 통보할 수 있다)
+
+	//예외가 나도 통보 깊이가 복구되도록 한다
+	class DispatchScope {
+	private:
+		ObserverRegistry& _registry;
+
+	public:
+		DispatchScope(ObserverRegistry& registry) : _registry(registry) {
+			_registry._dispatchDepth++;
+		}
+
+		~DispatchScope() {
+			if (--_registry._dispatchDepth == 0) {
+				_registry.compact();
+			}
+		}
+	};
+
+public:
+	void reserve(size_t count) {
+		_observers.reserve(count);
+		_owners.reserve(count);
+		_denseToSlot.reserve(count);
+		_slots.reserve(count);
+	}
+
+	size_t size() const {
+		return _observers.size() - _holeCount;
+	}
+
+	bool isDispatching() const {
+		return _dispatchDepth > 0;
+	}
+
+	//배열 끝에 추가한다 : O(1)
+	ObserverHandle insert(shared_ptr<IObserver> pObserver) {
+		uint32_t slotIndex;
+		if (_freeSlots.empty()) {
+			slotIndex = static_cast<uint32_t>(_slots.size());
+			_slots.push_back(Slot{ INVALID_INDEX, 0 });
+		}
+		else {
+			slotIndex = _freeSlots.back();
+			_freeSlots.pop_back();
+		}
+
+		Slot& slot = _slots[slotIndex];
+		slot.denseIndex = static_cast<uint32_t>(_observers.size());
+
+		_observers.push_back(pObserver.get());
+		_owners.push_back(move(pObserver));
+		_denseToSlot.push_back(slotIndex);
+
+		return ObserverHandle{ slotIndex, slot.generation };
+	}
+
+	bool contains(ObserverHandle handle) const {
+		return handle.index < _slots.size()
+			&& _slots[handle.index].denseIndex != INVALID_INDEX
+			&& _slots[handle.index].generation == handle.generation;
+	}
+
+	//빈칸으로 표시만 한다 : O(1)
+	//통보 중이면 update() 가 아직 실행 중일 수 있으므로 옵저버 객체는 정리할 때 놓아준다
+	bool erase(ObserverHandle handle) {
+		if (!contains(handle)) {
+			return false;
+		}
+
+		Slot& slot = _slots[handle.index];
+		uint32_t denseIndex = slot.denseIndex;
+		_observers[denseIndex] = nullptr;
+		_holeCount++;
+
+		slot.denseIndex = INVALID_INDEX;
+		slot.generation++;
+		_freeSlots.push_back(handle.index);
+
+		if (!isDispatching()) {
+			_owners[denseIndex].reset();
+		}
+		return true;
+	}
+
+	//빈칸을 제거하고 남은 옵저버를 앞으로 당긴다 (등록 순서 유지)
+	//통보 중에는 아무 일도 하지 않고 가장 바깥 통보가 끝날 때 다시 불린다
+	void compact() {
+		if (_holeCount == 0 || isDispatching()) {
+			return;
+		}
+
+		size_t writeIndex = 0;
+		for (size_t readIndex = 0; readIndex < _observers.size(); readIndex++) {
+			if (_observers[readIndex] == nullptr) {
+				if (_owners[readIndex]) {
+					_released.push_back(move(_owners[readIndex]));
+				}
+				continue;
+			}
+			if (writeIndex != readIndex) {
+				_observers[writeIndex] = _observers[readIndex];
+				_owners[writeIndex] = move(_owners[readIndex]);
+				_denseToSlot[writeIndex] = _denseToSlot[readIndex];
+				_slots[_denseToSlot[writeIndex]].denseIndex = static_cast<uint32_t>(writeIndex);
+			}
+			writeIndex++;
+		}
+
+		_observers.resize(writeIndex);
+		_owners.resize(writeIndex);
+		_denseToSlot.resize(writeIndex);
+		_holeCount = 0;
+
+		//옵저버 소멸자가 다시 등록/제거를 해도 되도록 배열 정리가 끝난 뒤에 놓아준다
+		_released.clear();
+	}
+
+	//통보 시작 시점의 옵저버만 순회한다
+	//배열이 재할당될 수 있으므로 반복자 대신 위치로 접근하고, 도중에 생긴 빈칸은 건너뛴다
+	template <typename Func>
+	void forEach(Func&& func) {
+		compact();
+		DispatchScope scope(*this);
+
+		const size_t count = _observers.size();
+		for (size_t idx = 0; idx < count; idx++) {
+			IObserver* pObserver = _observers[idx];
+			if (pObserver != nullptr) {
+				func(*pObserver);
+			}
+		}
+	}
+};
+
+//registerObserver() 가 돌려주는 구독 토큰
+//토큰이 소멸되거나 release() 를 호출하면 O(1) 로 구독이 해제된다
+//주제 객체가 먼저 사라져도 안전하도록 저장소는 weak_ptr 로 가리킨다
+class Subscription {
+private:
+	weak_ptr<ObserverRegistry> _registry;
+	ObserverHandle _handle;
+
+public:
+	Subscription() = default;
+
+	Subscription(weak_ptr<ObserverRegistry> registry, ObserverHandle handle)
+		: _registry(move(registry)), _handle(handle) {
+	}
+
+	Subscription(const Subscription&) = delete;
+	Subscription& operator=(const Subscription&) = delete;
+
+	Subscription(Subscription&& r) noexcept
+		: _registry(move(r._registry)), _handle(r._handle) {
+		r._registry.reset();
+	}
+
+	Subscription& operator=(Subscription&& r) noexcept {
+		if (this != &r) {
+			release();
+			_registry = move(r._registry);
+			_handle = r._handle;
+			r._registry.reset();
+		}
+		return *this;
+	}
+
+	~Subscription() {
+		release();
+	}
+
+	//구독 해제
+	void release() {
+		if (shared_ptr<ObserverRegistry> pRegistry = _registry.lock()) {
+			pRegistry->erase(_handle);
+		}
+		_registry.reset();
+	}
+
+	//토큰과의 연결만 끊고 구독은 주제 객체가 사라질 때까지 유지한다
+	void detach() {
+		_registry.reset();
+	}
+
+	bool isActive() const {
+		shared_ptr<ObserverRegistry> pRegistry = _registry.lock();
+		return pRegistry && pRegistry->contains(_handle);
+	}
+};
+
+class ISubject {
+
+public:
+	//옵저버 등록 : 반환된 토큰이 살아있는 동안만 구독이 유지된다
+	[[nodiscard]] virtual Subscription registerObserver(shared_ptr<IObserver> pObserver) = 0;
+
+	//옵저버 제거
+	virtual void removeObserver(Subscription& subscription) = 0;
+
+	//변경 사실을 알린다
+	virtual void notifyObserver() = 0;
+};
+
+
+//측정값 필드 번호 (열 저장소의 열 번호)
+enum class SensorField {
+	Temp,
+	Humidity,
+	Pressure,
+	TempTop,
+	TempBottom,
+};
+
+static const size_t SENSOR_FIELD_COUNT = 5;
+
+//한 열(필드)의 연속 구간을 가리키는 읽기 전용 뷰 (복사하지 않는다)
+class ColumnSpan {
+private:
+	const float* _data;
+	size_t _size;
+
+public:
+	ColumnSpan(const float* data, size_t size) : _data(data), _size(size) {
+	}
+
+	const float* begin() const {
+		return _data;
+	}
+
+	const float* end() const {
+		return _data + _size;
+	}
+
+	const float* data() const {
+		return _data;
+	}
+
+	float operator[](size_t idx) const {
+		return _data[idx];
+	}
+
+	size_t size() const {
+		return _size;
+	}
+};
+
+//측정 기록 열 저장소
+//측정값을 필드별 연속 배열(열)에 이어 붙인다 : 같은 필드끼리 붙어 있어 집계/벡터화에 유리하다
+//기록은 고정 크기 청크 단위로 나누고, 청크 수가 상한에 닿으면 가장 오래된 청크를 지우고 재사용한다
+//그래서 메모리 사용량이 정해져 있고, 상한에 닿은 뒤에는 추가할 때 할당이 없다
+class SensorHistory {
+public:
+	static const size_t CHUNK_CAPACITY = 4096; //청크 하나에 들어가는 측정값 수
+
+private:
+	struct Chunk {
+		float columns[SENSOR_FIELD_COUNT][CHUNK_CAPACITY];
+		size_t size = 0;
+	};
+
+	vector<unique_ptr<Chunk>> _ring; //청크 원형 버퍼 (필요할 때까지 할당을 미룬다)
+	size_t _firstChunk = 0;          //가장 오래된 청크 위치
+	size_t _chunkCount = 0;          //사용 중인 청크 수
+	uint64_t _totalAppended = 0;     //지금까지 추가된 측정값 수
+	uint64_t _recycledChunks = 0;    //재사용된 청크 수
+
+	Chunk& chunkAt(size_t chunkIndex) const {
+		return *_ring[(_firstChunk + chunkIndex) % _ring.size()];
+	}
+
+	//새 청크를 끝에 붙인다 (가득 찼으면 가장 오래된 청크를 재사용)
+	Chunk& pushChunk() {
+		if (_chunkCount == _ring.size()) {
+			Chunk& recycled = *_ring[_firstChunk];
+			_firstChunk = (_firstChunk + 1) % _ring.size();
+			recycled.size = 0;
+			_recycledChunks++;
+			return recycled;
+		}
+
+		size_t position = (_firstChunk + _chunkCount) % _ring.size();
+		if (!_ring[position]) {
+			_ring[position] = make_unique<Chunk>();
+		}
+		_chunkCount++;
+		_ring[position]->size = 0;
+		return *_ring[position];
+	}
+
+public:
+	//최대 maxReadings 개 (청크 단위로 올림) 를 보관한다
+	SensorHistory(size_t maxReadings)
+		: _ring(max<size_t>(1, (maxReadings + CHUNK_CAPACITY - 1) / CHUNK_CAPACITY)) {
+	}
+
+	void append(const SensorData& sensorData) {
+		Chunk* pChunk = _chunkCount == 0 ? nullptr : &chunkAt(_chunkCount - 1);
+		if (pChunk == nullptr || pChunk->size == CHUNK_CAPACITY) {
+			pChunk = &pushChunk();
+		}
+
+		size_t idx = pChunk->size++;
+		pChunk->columns[static_cast<size_t>(SensorField::Temp)][idx] = sensorData.temp;
+		pChunk->columns[static_cast<size_t>(SensorField::Humidity)][idx] = sensorData.humidity;
+		pChunk->columns[static_cast<size_t>(SensorField::Pressure)][idx] = sensorData.pressure;
+		pChunk->columns[static_cast<size_t>(SensorField::TempTop)][idx] = sensorData.temp_top;
+		pChunk->columns[static_cast<size_t>(SensorField::TempBottom)][idx] = sensorData.temp_bottom;
+		_totalAppended++;
+	}
+
+	void append(SensorDataSpan readings) {
+		for (const SensorData& sensorData : readings) {
+			append(sensorData);
+		}
+	}
+
+	//보관 중인 측정값 수
+	size_t size() const {
+		if (_chunkCount == 0) {
+			return 0;
+		}
+		return (_chunkCount - 1) * CHUNK_CAPACITY + chunkAt(_chunkCount - 1).size;
+	}
+
+	uint64_t getTotalAppended() const {
+		return _totalAppended;
+	}
+
+	uint64_t getRecycledChunks() const {
+		return _recycledChunks;
+	}
+
+	size_t getChunkCount() const {
+		return _chunkCount;
+	}
+
+	//할당된 청크 메모리 (상한에 닿으면 더 늘지 않는다)
+	size_t getMemoryBytes() const {
+		size_t allocated = 0;
+		for (const unique_ptr<Chunk>& pChunk : _ring) {
+			if (pChunk) {
+				allocated += sizeof(Chunk);
+			}
+		}
+		return allocated;
+	}
+
+	//chunkIndex 번째 청크(0 이 가장 오래됨)의 한 열
+	ColumnSpan getColumn(size_t chunkIndex, SensorField field) const {
+		const Chunk& chunk = chunkAt(chunkIndex);
+		return ColumnSpan(chunk.columns[static_cast<size_t>(field)], chunk.size);
+	}
+
+	//오래된 것부터 청크마다 한 열의 뷰를 넘긴다
+	template <typename Func>
+	void forEachColumn(SensorField field, Func&& func) const {
+		for (size_t chunkIndex = 0; chunkIndex < _chunkCount; chunkIndex++) {
+			func(getColumn(chunkIndex, field));
+		}
+	}
+
+	//가장 최근 count 개 (청크 경계에서 나뉠 수 있다) 에 대해 한 열의 뷰를 넘긴다
+	template <typename Func>
+	void forEachRecentColumn(SensorField field, size_t count, Func&& func) const {
+		count = min(count, size());
+		size_t skip = size() - count;
+		for (size_t chunkIndex = skip / CHUNK_CAPACITY; chunkIndex < _chunkCount; chunkIndex++) {
+			ColumnSpan column = getColumn(chunkIndex, field);
+			size_t offset = (chunkIndex == skip / CHUNK_CAPACITY) ? skip % CHUNK_CAPACITY : 0;
+			func(ColumnSpan(column.data() + offset, column.size() - offset));
+		}
+	}
+
+	//index 번째 측정값 (0 이 가장 오래됨) 을 다시 구조체로 모은다
+	SensorData at(size_t index) const {
+		const Chunk& chunk = chunkAt(index / CHUNK_CAPACITY);
+		size_t idx = index % CHUNK_CAPACITY;
+		return SensorData{
+			chunk.columns[static_cast<size_t>(SensorField::Temp)][idx],
+			chunk.columns[static_cast<size_t>(SensorField::Humidity)][idx],
+			chunk.columns[static_cast<size_t>(SensorField::Pressure)][idx],
+			chunk.columns[static_cast<size_t>(SensorField::TempTop)][idx],
+			chunk.columns[static_cast<size_t>(SensorField::TempBottom)][idx],
+		};
+	}
+};
+
+class Random {
+private:
+	// 시드값을 얻기 위한 random_device 생성.
+	random_device _rd;
+
+	// random_device 를 통해 난수 생성 엔진을 초기화 한다.
+	// getValue() const 에서 상태를 바꾸므로 mutable 로 선언한다
+	mutable mt19937 _generator;
+
+	// 예 :  0 부터 99 까지 균등하게 나타나는 난수열을 생성하기 위해 균등 분포 정의.
+	mutable uniform_int_distribution<int> _distribution;
+
+public:
+	Random(int from, int to) : _generator{ _rd() },
+		_distribution{from, to} {
+
+	}
+
+	int getValue() const {
+		return _distribution(_generator);
+	}
+};
+
+class WeatherStation {
+private:
+	Random _randomTemperature; //온도 난수 객체
+	Random _randomHumidity; //습도 난수 객체
+	Random _randomPressure; //압력 난수 객체
+
+public :
+	WeatherStation() : _randomTemperature{ -50, 50 }
+		, _randomHumidity{ -100, 100 }
+		, _randomPressure{ -100, 100 } {
+	}
+
+	float getTemperature() const {
+		return 25.0f + _randomTemperature.getValue() / 10.0f;
+	}
+	float getHumidity() const {
+		return 60.0f + _randomHumidity.getValue() / 10.0f;
+	};
+	float getPressure() const {
+		return 25.0f +  _randomPressure.getValue() / 10.0f;
+	};
+
+};
+
+class StatisticsDisplay : public IObserver {
+private:
+	float _maxTemp = 0.0f;
+	float _minTemp = 100.0f;
+	float _tempSum = 0.0f;
+	int _numReadings = 0;
+
+public:
+	void update(const SensorData& sensorData) override {
+		update(sensorData.temp, sensorData.humidity, sensorData.pressure);
+	}
+
+	void update(float temp, float humidity, float pressure) {
+		_tempSum += temp;
+		_numReadings++;
+
+		if (temp > _maxTemp) {
+			_maxTemp = temp;
+		}
+
+		if (temp < _minTemp) {
+			_minTemp = temp;
+		}
+
+		display();
+	}
+
+	//묶음 전체를 누적한 뒤 한 번만 출력한다
+	void updateBatch(SensorDataSpan readings) override {
+		if (readings.empty()) {
+			return;
+		}
+
+		accumulate(readings);
+		display();
+	}
+
+	//출력 없이 누적만 한다
+	void accumulate(SensorDataSpan readings) {
+		float tempSum = 0.0f;
+		float maxTemp = _maxTemp;
+		float minTemp = _minTemp;
+
+		for (const SensorData& sensorData : readings) {
+			tempSum += sensorData.temp;
+			maxTemp = max(maxTemp, sensorData.temp);
+			minTemp = min(minTemp, sensorData.temp);
+		}
+
+		_tempSum += tempSum;
+		_numReadings += static_cast<int>(readings.size());
+		_maxTemp = maxTemp;
+		_minTemp = minTemp;
+	}
+
+	void display() {
+		cout << "기상 통계 " << endl
+			<< "평균 기온 : " << (_tempSum / _numReadings) << "℃" << endl
+			<< "최저 기온 : " << _minTemp << "℃" << endl
+			<< "최고 기온 : " << _maxTemp << "℃" << endl << endl;
+	}
+};
+
+class CurrentConditionsDisplay : public IObserver {
+private:
+	float _temperature;
+	float _humidity;
+	float _pressure;
+
+public:
+	void update(const SensorData& sensorData) override {
+		update(sensorData.temp, sensorData.humidity, sensorData.pressure);
+	}
+
+	void update(float temperature, float humidity, float pressure) {
+		_temperature = temperature;
+		_humidity = humidity;
+		_pressure = pressure;
+		display();
+	}
+
+	void display() {
+		cout << "현재 조건 " << endl
+			<< "온도: " << _temperature << "℃" << endl
+			<< "습도: " << _humidity << "%" << endl
+			<< "기압: " << _pressure << endl << endl;
+
+	}
+};
+
+class ForecastDisplay : public IObserver {
+private:
+	float _currentPressure = 29.92f;
+	float _lastPressure;
+
+public:
+	void update(const SensorData& sensorData) override {
+		update(sensorData.temp, sensorData.humidity, sensorData.pressure);
+	}
+
+	void update(float temp, float humidity, float pressure) {
+		_lastPressure = _currentPressure;
+		_currentPressure = pressure;
+
+		display();
+	}
+
+	//예보는 마지막 두 기압만 비교하므로 묶음의 끝부분만 보고 한 번만 출력한다
+	void updateBatch(SensorDataSpan readings) override {
+		if (readings.empty()) {
+			return;
+		}
+
+		_lastPressure = readings.size() >= 2 ? readings[readings.size() - 2].pressure : _currentPressure;
+		_currentPressure = readings.back().pressure;
+
+		display();
+	}
+
+	void display() {
+		cout << "기상 예보" << endl;
+		if (_currentPressure > _lastPressure) {
+			cout << "가는 길에 날씨 개선" << endl << endl;
+		}
+		else if (_currentPressure == _lastPressure) {
+			cout << "전과 같음" << endl << endl;
+		}
+		else if (_currentPressure < _lastPressure) {
+			cout << "선선하고 비오는 날씨에 조심하십시오" << endl << endl;
+		}
+	}
+};
+
+
+
+class WeatherData : public ISubject {
+private:
+	WeatherStation _weatherStation;
+
+	//ISubject 구현시 사용할 멤버변수
+	//구독 토큰이 weak_ptr 로 가리킬 수 있도록 shared_ptr 로 보관한다
+	shared_ptr<ObserverRegistry> _registry = make_shared<ObserverRegistry>();
+
+	SensorData _sensorData{};
+
+	//측정 기록 (필드별 열 저장소)
+	SensorHistory _history;
+
+	//readMeasurementsBatch() 에서 재사용하는 버퍼 (용량을 유지하므로 매번 할당하지 않는다)
+	vector<SensorData> _batch;
+
+public:
+	//최근 historyCapacity 개의 측정값을 기록으로 보관한다
+	WeatherData(size_t historyCapacity = 65536) : _history(historyCapacity) {
+	}
+
+	//옵저버는 이 기록을 복사 없이 열 단위로 읽을 수 있다
+	const SensorHistory& getHistory() const {
+		return _history;
+	}
+
+	//옵저버 등록
+	Subscription registerObserver(shared_ptr<IObserver> pObserver) override {
+		return Subscription(_registry, _registry->insert(move(pObserver)));
+	}
+
+	//옵저버 제거
+	void removeObserver(Subscription& subscription) override {
+		subscription.release();
+	}
+
+	//변경 사실을 알린다
+	void notifyObserver() override {
+		const SensorData& sensorData = _sensorData;
+		_registry->forEach([&sensorData](IObserver& observer) {
+			observer.update(sensorData);
+		});
+	}
+
+	size_t getObserverCount() const {
+		return _registry->size();
+	}
+
+	//여러 측정값을 옵저버마다 한 번에 알린다
+	void notifyObserverBatch(SensorDataSpan readings) {
+		_registry->forEach([&readings](IObserver& observer) {
+			observer.updateBatch(readings);
+		});
+	}
+
+	//이미 수집된 측정값(밀린 기록 등)을 한 번에 전달한다
+	void replayBatch(SensorDataSpan readings) {
+		if (readings.empty()) {
+			return;
+		}
+		_sensorData = readings.back();
+		_history.append(readings);
+		notifyObserverBatch(readings);
+	}
+
+	float getTemperature() const {
+		return _weatherStation.getTemperature();
+	}
+
+	float getHumidity() const {
+		return _weatherStation.getHumidity();
+	}
+
+	float getPressure() const {
+		return _weatherStation.getPressure();
+	}
+
+	void measurementsChanged() {
+		_history.append(_sensorData);
+		notifyObserver();
+	}
+
+	void readMeasurements() {
+		_sensorData.temp = _weatherStation.getTemperature();
+		_sensorData.humidity = _weatherStation.getHumidity();
+		_sensorData.pressure = _weatherStation.getPressure();
+
+		measurementsChanged();
+	}
+
+	//측정값 count 개를 먼저 모두 읽은 뒤 한 번만 알린다
+	void readMeasurementsBatch(size_t count) {
+		_batch.resize(count);
+		for (SensorData& sensorData : _batch) {
+			sensorData.temp = _weatherStation.getTemperature();
+			sensorData.humidity = _weatherStation.getHumidity();
+			sensorData.pressure = _weatherStation.getPressure();
+		}
+
+		replayBatch(_batch);
+	}
+};
+
+
+
+
+//기록 저장소를 직접 읽는 옵저버 : 최근 측정값의 평균 기온으로 추세를 보여준다
+class TrendDisplay : public IObserver {
+private:
+	const WeatherData& _weatherData;
+	size_t _window;
+
+public:
+	TrendDisplay(const WeatherData& weatherData, size_t window) : _weatherData(weatherData), _window(window) {
+	}
+
+	void update(const SensorData& sensorData) override {
+		display(sensorData.temp);
+	}
+
+	void updateBatch(SensorDataSpan readings) override {
+		if (!readings.empty()) {
+			display(readings.back().temp);
+		}
+	}
+
+	void display(float currentTemp) {
+		float sum = 0.0f;
+		size_t count = 0;
+		_weatherData.getHistory().forEachRecentColumn(SensorField::Temp, _window, [&sum, &count](ColumnSpan column) {
+			for (float temp : column) {
+				sum += temp;
+			}
+			count += column.size();
+		});
+
+		float average = sum / count;
+		cout << "기온 추세 (최근 " << count << "개)" << endl
+			<< "평균 기온 : " << average << "℃, 현재 기온 : " << currentTemp << "℃ ";
+		if (currentTemp > average) {
+			cout << "(평균보다 높음)" << endl << endl;
+		}
+		else {
+			cout << "(평균 이하)" << endl << endl;
+		}
+	}
+};
+
+//기록 추가 속도와 열 읽기 대역폭을 잰다
+//비교용으로 같은 수의 측정값을 구조체 배열(vector<SensorData>)에서 기온만 읽는다
+void benchmarkHistory(size_t capacity, size_t appendCount) {
+	vector<SensorData> readings(8192);
+	WeatherStation weatherStation;
+	for (SensorData& sensorData : readings) {
+		sensorData.temp = weatherStation.getTemperature();
+		sensorData.humidity = weatherStation.getHumidity();
+		sensorData.pressure = weatherStation.getPressure();
+	}
+
+	SensorHistory history(capacity);
+
+	auto start = chrono::steady_clock::now();
+	for (size_t idx = 0; idx < appendCount; idx++) {
+		history.append(readings[idx % readings.size()]);
+	}
+	auto end = chrono::steady_clock::now();
+	double appendSeconds = chrono::duration<double>(end - start).count();
+
+	cout << "기록 추가 : " << appendCount << "개, "
+		<< appendCount / appendSeconds / 1e6 << " 백만 측정값/초, "
+		<< "보관 " << history.size() << "개, "
+		<< "메모리 " << history.getMemoryBytes() / 1024 << " KB, "
+		<< "재사용 청크 " << history.getRecycledChunks() << "개" << endl;
+
+	vector<SensorData> rows(history.size());
+	for (size_t idx = 0; idx < rows.size(); idx++) {
+		rows[idx] = history.at(idx);
+	}
+
+	const int rounds = 20;
+	double columnSum = 0.0;
+	start = chrono::steady_clock::now();
+	for (int round = 0; round < rounds; round++) {
+		history.forEachColumn(SensorField::Temp, [&columnSum](ColumnSpan column) {
+			for (float temp : column) {
+				columnSum += temp;
+			}
+		});
+	}
+	auto middle = chrono::steady_clock::now();
+	double rowSum = 0.0;
+	for (int round = 0; round < rounds; round++) {
+		for (const SensorData& sensorData : rows) {
+			rowSum += sensorData.temp;
+		}
+	}
+	end = chrono::steady_clock::now();
+
+	double bytes = static_cast<double>(history.size()) * sizeof(float) * rounds;
+	cout << "기온 열 읽기 : " << bytes / chrono::duration<double>(middle - start).count() / 1e9 << " GB/s (유효 데이터 기준), "
+		<< "구조체 배열 : " << bytes / chrono::duration<double>(end - middle).count() / 1e9 << " GB/s"
+		<< " (합계 " << columnSum << " / " << rowSum << ")" << endl;
+}
+
+int main(int argc, char** argv) {
+
+	shared_ptr<WeatherData> pWeatherData = make_shared<WeatherData>();
+	//출력 장치 객체 생성
+	shared_ptr<CurrentConditionsDisplay> pCurrentConditionsDisplay = make_shared<CurrentConditionsDisplay>();
+	shared_ptr<TrendDisplay> pTrendDisplay = make_shared<TrendDisplay>(*pWeatherData, 100);
+
+	//출력 장치를 등록한다 (토큰을 보관해야 구독이 유지된다)
+	Subscription currentConditionsSubscription = pWeatherData->registerObserver(pCurrentConditionsDisplay);
+	Subscription trendSubscription = pWeatherData->registerObserver(pTrendDisplay);
+
+	//측정값을 읽는다 (기록에도 쌓인다)
+	pWeatherData->readMeasurements();
+	pWeatherData->readMeasurements();
+
+	//출력 장치를 제거한다
+	pWeatherData->removeObserver(currentConditionsSubscription);
+
+	//측정값 500개를 모아서 한 번에 알린다
+	pWeatherData->readMeasurementsBatch(500);
+
+	cout << "기록된 측정값 : " << pWeatherData->getHistory().size() << "개" << endl;
+
+	benchmarkHistory(1 << 20, 10000000);
+
+	return 0;
+}
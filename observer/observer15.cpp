@@ -0,0 +1,899 @@
+﻿// observer.cpp : 이 파일에는 'main' 함수가 포함됩니다. 거기서 프로그램 실행이 시작되고 종료됩니다.
+//
+
+#include <iostream>
+#include <memory>
+#include <random>
+#include <ctime>
+#include <functional>
+#include <list>
+#include <vector>
+#include <unordered_map>
+#include <chrono>
+#include <cstdint>
+#include <algorithm>
+#include <thread>
+
+using namespace std;
+
+struct SensorData {
+	float temp;
+	float humidity;
+	float pressure;
+	float temp_top;
+	float temp_bottom;
+};
+
+//연속된 측정값 묶음을 가리키는 읽기 전용 구간 (복사하지 않는다)
+class SensorDataSpan {
+private:
+	const SensorData* _data;
+	size_t _size;
+
+public:
+	SensorDataSpan(const SensorData* data, size_t size) : _data(data), _size(size) {
+	}
+
+	SensorDataSpan(const vector<SensorData>& readings) : _data(readings.data()), _size(readings.size()) {
+	}
+
+	const SensorData* begin() const {
+		return _data;
+	}
+
+	const SensorData* end() const {
+		return _data + _size;
+	}
+
+	const SensorData& operator[](size_t idx) const {
+		return _data[idx];
+	}
+
+	const SensorData& back() const {
+		return _data[_size - 1];
+	}
+
+	size_t size() const {
+		return _size;
+	}
+
+	bool empty() const {
+		return _size == 0;
+	}
+};
+
+class IObserver {
+public:
+	virtual void update(const SensorData& sensorData) = 0;
+
+	//여러 측정값을 가상 함수 호출 한 번으로 받는다
+	//기본 구현은 하나씩 update() 를 호출하고, 한꺼번에 처리할 수 있는 옵저버는 재정의한다
+	virtual void updateBatch(SensorDataSpan readings) {
+		for (const SensorData& sensorData : readings) {
+			update(sensorData);
+		}
+	}
+};
+
+//등록된 옵저버를 가리키는 핸들 (슬롯 번호 + 세대)
+//제거된 뒤 같은 슬롯이 재사용되면 세대가 달라지므로 예전 핸들은 무효가 된다
+struct ObserverHandle {
+	uint32_t index = UINT32_MAX;
+	uint32_t generation = 0;
+};
+
+//슬롯맵(slot map) 방식의 옵저버 저장소
+//제거는 핸들로 O(1) 에 처리하고 빈칸은 표시만 해 둔다
+//
+//통보 도중(update() 안)에 등록/제거가 일어나도 안전하도록 구조 변경은 미뤄 둔다
+// - 등록 : 배열 끝에 추가되므로 이번 통보에서는 보이지 않고 다음 통보부터 받는다
+// - 제거 : 빈칸으로 표시만 하고 옵저버 객체도 통보가 끝날 때까지 놓아주지 않는다
+// - 정리(compact) : 가장 바깥 통보가 끝난 뒤에 한 번만 한다
+//목록을 복사하지 않으므로 평상시 통보 경로에서는 메모리 할당이 전혀 없다
+class ObserverRegistry {
+private:
+	static const uint32_t INVALID_INDEX = UINT32_MAX;
+
+	struct Slot {
+		uint32_t denseIndex; //_observers 안의 위치 (INVALID_INDEX 이면 빈 슬롯)
+		uint32_t generation; //슬롯 재사용 횟수
+	};
+
+	vector<IObserver*> _observers;         //통보할 때 순회하는 연속 배열 (정리 전에는 nullptr 빈칸이 있을 수 있다)
+	vector<shared_ptr<IObserver>> _owners; //수명 유지용 (통보할 때는 읽지 않는다)
+	vector<uint32_t> _denseToSlot;         //_observers 위치 -> 슬롯 번호
+	vector<Slot> _slots;                   //핸들 -> _observers 위치
+	vector<uint32_t> _freeSlots;           //재사용할 빈 슬롯 번호
+	vector<shared_ptr<IObserver>> _released; //정리 중에 놓아줄 옵저버 (용량은 재사용한다)
+	size_t _holeCount = 0;                 //정리되지 않은 빈칸 수
+	int _dispatchDepth = 0;                //진행 중인 통보 깊이 (update() 안에서 다시 통보할 수 있다)
+
+	//예외가 나도 통보 깊이가 복구되도록 한다
+	class DispatchScope {
+	private:
+		ObserverRegistry& _registry;
+
+	public:
+		DispatchScope(ObserverRegistry& registry) : _registry(registry) {
+			_registry._dispatchDepth++;
+		}
+
+		~DispatchScope() {
+			if (--_registry._dispatchDepth == 0) {
+				_registry.compact();
+			}
+		}
+	};
+
+public:
+	void reserve(size_t count) {
+		_observers.reserve(count);
+		_owners.reserve(count);
+		_denseToSlot.reserve(count);
+		_slots.reserve(count);
+	}
+
+	size_t size() const {
+		return _observers.size() - _holeCount;
+	}
+
+	bool isDispatching() const {
+		return _dispatchDepth > 0;
+	}
+
+	//배열 끝에 추가한다 : O(1)
+	ObserverHandle insert(shared_ptr<IObserver> pObserver) {
+		uint32_t slotIndex;
+		if (_freeSlots.empty()) {
+			slotIndex = static_cast<uint32_t>(_slots.size());
+			_slots.push_back(Slot{ INVALID_INDEX, 0 });
+		}
+		else {
+			slotIndex = _freeSlots.back();
+			_freeSlots.pop_back();
+		}
+
+		Slot& slot = _slots[slotIndex];
+		slot.denseIndex = static_cast<uint32_t>(_observers.size());
+
+		_observers.push_back(pObserver.get());
+		_owners.push_back(move(pObserver));
+		_denseToSlot.push_back(slotIndex);
+
+		return ObserverHandle{ slotIndex, slot.generation };
+	}
+
+	bool contains(ObserverHandle handle) const {
+		return handle.index < _slots.size()
+			&& _slots[handle.index].denseIndex != INVALID_INDEX
+			&& _slots[handle.index].generation == handle.generation;
+	}
+
+	//빈칸으로 표시만 한다 : O(1)
+	//통보 중이면 update() 가 아직 실행 중일 수 있으므로 옵저버 객체는 정리할 때 놓아준다
+	bool erase(ObserverHandle handle) {
+		if (!contains(handle)) {
+			return false;
+		}
+
+		Slot& slot = _slots[handle.index];
+		uint32_t denseIndex = slot.denseIndex;
+		_observers[denseIndex] = nullptr;
+		_holeCount++;
+
+		slot.denseIndex = INVALID_INDEX;
+		slot.generation++;
+		_freeSlots.push_back(handle.index);
+
+		if (!isDispatching()) {
+			_owners[denseIndex].reset();
+		}
+		return true;
+	}
+
+	//빈칸을 제거하고 남은 옵저버를 앞으로 당긴다 (등록 순서 유지)
+	//통보 중에는 아무 일도 하지 않고 가장 바깥 통보가 끝날 때 다시 불린다
+	void compact() {
+		if (_holeCount == 0 || isDispatching()) {
+			return;
+		}
+
+		size_t writeIndex = 0;
+		for (size_t readIndex = 0; readIndex < _observers.size(); readIndex++) {
+			if (_observers[readIndex] == nullptr) {
+				if (_owners[readIndex]) {
+					_released.push_back(move(_owners[readIndex]));
+				}
+				continue;
+			}
+			if (writeIndex != readIndex) {
+				_observers[writeIndex] = _observers[readIndex];
+				_owners[writeIndex] = move(_owners[readIndex]);
+				_denseToSlot[writeIndex] = _denseToSlot[readIndex];
+				_slots[_denseToSlot[writeIndex]].denseIndex = static_cast<uint32_t>(writeIndex);
+			}
+			writeIndex++;
+		}
+
+		_observers.resize(writeIndex);
+		_owners.resize(writeIndex);
+		_denseToSlot.resize(writeIndex);
+		_holeCount = 0;
+
+		//옵저버 소멸자가 다시 등록/제거를 해도 되도록 배열 정리가 끝난 뒤에 놓아준다
+		_released.clear();
+	}
+
+	//통보 시작 시점의 옵저버만 순회한다
+	//배열이 재할당될 수 있으므로 반복자 대신 위치로 접근하고, 도중에 생긴 빈칸은 건너뛴다
+	template <typename Func>
+	void forEach(Func&& func) {
+		compact();
+		DispatchScope scope(*this);
+
+		const size_t count = _observers.size();
+		for (size_t idx = 0; idx < count; idx++) {
+			IObserver* pObserver = _observers[idx];
+			if (pObserver != nullptr) {
+				func(*pObserver);
+			}
+		}
+	}
+};
+
+//registerObserver() 가 돌려주는 구독 토큰
+//토큰이 소멸되거나 release() 를 호출하면 O(1) 로 구독이 해제된다
+//주제 객체가 먼저 사라져도 안전하도록 저장소는 weak_ptr 로 가리킨다
+class Subscription {
+private:
+	weak_ptr<ObserverRegistry> _registry;
+	ObserverHandle _handle;
+
+public:
+	Subscription() = default;
+
+	Subscription(weak_ptr<ObserverRegistry> registry, ObserverHandle handle)
+		: _registry(move(registry)), _handle(handle) {
+	}
+
+	Subscription(const Subscription&) = delete;
+	Subscription& operator=(const Subscription&) = delete;
+
+	Subscription(Subscription&& r) noexcept
+		: _registry(move(r._registry)), _handle(r._handle) {
+		r._registry.reset();
+	}
+
+	Subscription& operator=(Subscription&& r) noexcept {
+		if (this != &r) {
+			release();
+			_registry = move(r._registry);
+			_handle = r._handle;
+			r._registry.reset();
+		}
+		return *this;
+	}
+
+	~Subscription() {
+		release();
+	}
+
+	//구독 해제
+	void release() {
+		if (shared_ptr<ObserverRegistry> pRegistry = _registry.lock()) {
+			pRegistry->erase(_handle);
+		}
+		_registry.reset();
+	}
+
+	//토큰과의 연결만 끊고 구독은 주제 객체가 사라질 때까지 유지한다
+	void detach() {
+		_registry.reset();
+	}
+
+	bool isActive() const {
+		shared_ptr<ObserverRegistry> pRegistry = _registry.lock();
+		return pRegistry && pRegistry->contains(_handle);
+	}
+};
+
+class ISubject {
+
+public:
+	//옵저버 등록 : 반환된 토큰이 살아있는 동안만 구독이 유지된다
+	[[nodiscard]] virtual Subscription registerObserver(shared_ptr<IObserver> pObserver) = 0;
+
+	//옵저버 제거
+	virtual void removeObserver(Subscription& subscription) = 0;
+
+	//변경 사실을 알린다
+	virtual void notifyObserver() = 0;
+};
+
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define FAST_RANDOM_SSE2 1
+#include <emmintrin.h>
+#endif
+
+//쓰기 가능한 float 연속 구간 (복사하지 않는다)
+class FloatSpan {
+private:
+	float* _data;
+	size_t _size;
+
+public:
+	FloatSpan(float* data, size_t size) : _data(data), _size(size) {
+	}
+
+	FloatSpan(vector<float>& values) : _data(values.data()), _size(values.size()) {
+	}
+
+	float* data() const {
+		return _data;
+	}
+
+	size_t size() const {
+		return _size;
+	}
+};
+
+//빠르고 작은 난수 생성기
+//xoshiro128** 4개를 나란히 돌려서 한 번에 4개씩 만든다 (상태 64바이트, mt19937 은 약 5KB)
+//같은 시드면 항상 같은 수열이 나오고, getValue() 로 하나씩 꺼내든 fill() 로 한꺼번에 채우든
+//SSE2 가 있든 없든 같은 순서로 같은 값이 나온다
+class FastRandom {
+private:
+	static const int LANES = 4;
+
+	uint32_t _state[4][LANES]; //[상태 워드][레인] : SIMD 레지스터에 바로 올릴 수 있는 배치
+	uint32_t _buffer[LANES];   //getValue() 용으로 미리 만들어 둔 값
+	int _bufferPos = LANES;
+	int _from;
+	uint32_t _range;           //to - from + 1
+
+	static uint64_t splitMix64(uint64_t& x) {
+		uint64_t z = (x += 0x9E3779B97F4A7C15ull);
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+		return z ^ (z >> 31);
+	}
+
+	static uint32_t rotl(uint32_t x, int k) {
+		return (x << k) | (x >> (32 - k));
+	}
+
+	//32비트 난수를 [0, range) 로 옮긴다 (곱셈 상위 32비트 방식, 나머지 연산 없음)
+	uint32_t toIndex(uint32_t bits) const {
+		return static_cast<uint32_t>((static_cast<uint64_t>(bits) * _range) >> 32);
+	}
+
+	//레인 4개를 한 단계씩 진행한다 (스칼라 기준 구현)
+	void next4(uint32_t out[LANES]) {
+		for (int lane = 0; lane < LANES; lane++) {
+			uint32_t s0 = _state[0][lane];
+			uint32_t s1 = _state[1][lane];
+			uint32_t s2 = _state[2][lane];
+			uint32_t s3 = _state[3][lane];
+
+			out[lane] = rotl(s1 * 5, 7) * 9;
+
+			uint32_t t = s1 << 9;
+			s2 ^= s0;
+			s3 ^= s1;
+			s1 ^= s2;
+			s0 ^= s3;
+			s2 ^= t;
+			s3 = rotl(s3, 11);
+
+			_state[0][lane] = s0;
+			_state[1][lane] = s1;
+			_state[2][lane] = s2;
+			_state[3][lane] = s3;
+		}
+	}
+
+public:
+	FastRandom(int from, int to, uint64_t seed) : _from(from), _range(static_cast<uint32_t>(to - from + 1)) {
+		//0 상태가 되지 않도록 splitmix64 로 시드를 펼친다
+		for (int lane = 0; lane < LANES; lane++) {
+			for (int word = 0; word < 4; word += 2) {
+				uint64_t z = splitMix64(seed);
+				_state[word][lane] = static_cast<uint32_t>(z);
+				_state[word + 1][lane] = static_cast<uint32_t>(z >> 32);
+			}
+		}
+	}
+
+	int getValue() {
+		if (_bufferPos == LANES) {
+			next4(_buffer);
+			_bufferPos = 0;
+		}
+		return _from + static_cast<int>(toIndex(_buffer[_bufferPos++]));
+	}
+
+	//out[i] = base + getValue() / divisor 를 한꺼번에 채운다
+	void fill(FloatSpan out, float base, float divisor) {
+		float* data = out.data();
+		size_t count = out.size();
+		size_t idx = 0;
+
+		//버퍼에 남은 값부터 써서 getValue() 와 같은 순서를 유지한다
+		for (; idx < count && _bufferPos < LANES; idx++) {
+			data[idx] = base + static_cast<float>(getValue()) / divisor;
+		}
+
+#ifdef FAST_RANDOM_SSE2
+		__m128i s0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(_state[0]));
+		__m128i s1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(_state[1]));
+		__m128i s2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(_state[2]));
+		__m128i s3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(_state[3]));
+		const __m128i range = _mm_set1_epi32(static_cast<int>(_range));
+		const __m128i from = _mm_set1_epi32(_from);
+		const __m128i oddMask = _mm_set_epi32(-1, 0, -1, 0);
+		const __m128 baseV = _mm_set1_ps(base);
+		const __m128 divisorV = _mm_set1_ps(divisor);
+
+		for (; idx + LANES <= count; idx += LANES) {
+			//rotl(s1 * 5, 7) * 9 : 곱셈을 시프트와 덧셈으로 바꾼다
+			__m128i x = _mm_add_epi32(_mm_slli_epi32(s1, 2), s1);
+			x = _mm_or_si128(_mm_slli_epi32(x, 7), _mm_srli_epi32(x, 25));
+			x = _mm_add_epi32(_mm_slli_epi32(x, 3), x);
+
+			__m128i t = _mm_slli_epi32(s1, 9);
+			s2 = _mm_xor_si128(s2, s0);
+			s3 = _mm_xor_si128(s3, s1);
+			s1 = _mm_xor_si128(s1, s2);
+			s0 = _mm_xor_si128(s0, s3);
+			s2 = _mm_xor_si128(s2, t);
+			s3 = _mm_or_si128(_mm_slli_epi32(s3, 11), _mm_srli_epi32(s3, 21));
+
+			//(x * range) >> 32 : 짝수/홀수 레인을 나눠 64비트 곱을 구한다
+			__m128i even = _mm_srli_epi64(_mm_mul_epu32(x, range), 32);
+			__m128i odd = _mm_and_si128(_mm_mul_epu32(_mm_srli_epi64(x, 32), range), oddMask);
+			__m128i value = _mm_add_epi32(_mm_or_si128(even, odd), from);
+
+			__m128 result = _mm_add_ps(baseV, _mm_div_ps(_mm_cvtepi32_ps(value), divisorV));
+			_mm_storeu_ps(data + idx, result);
+		}
+
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(_state[0]), s0);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(_state[1]), s1);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(_state[2]), s2);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(_state[3]), s3);
+#endif
+
+		for (; idx < count; idx++) {
+			data[idx] = base + static_cast<float>(getValue()) / divisor;
+		}
+	}
+};
+
+//비교용 : 이전 단계의 mt19937 기반 난수 객체
+class MersenneRandom {
+private:
+	random_device _rd;
+	mt19937 _generator;
+	uniform_int_distribution<int> _distribution;
+
+public:
+	MersenneRandom(int from, int to) : _generator{ _rd() },
+		_distribution{ from, to } {
+	}
+
+	int getValue() {
+		return _distribution(_generator);
+	}
+};
+
+class WeatherStation {
+private:
+	//getTemperature() 등은 const 이지만 난수 상태는 바뀌므로 mutable 로 둔다 (const_cast 불필요)
+	mutable FastRandom _randomTemperature; //온도 난수 객체
+	mutable FastRandom _randomHumidity; //습도 난수 객체
+	mutable FastRandom _randomPressure; //압력 난수 객체
+
+	static uint64_t makeSeed() {
+		random_device rd;
+		return (static_cast<uint64_t>(rd()) << 32) | rd();
+	}
+
+public :
+	//실행할 때마다 다른 값
+	WeatherStation() : WeatherStation(makeSeed()) {
+	}
+
+	//같은 시드면 항상 같은 측정값
+	explicit WeatherStation(uint64_t seed) : _randomTemperature{ -50, 50, seed }
+		, _randomHumidity{ -100, 100, seed + 1 }
+		, _randomPressure{ -100, 100, seed + 2 } {
+	}
+
+	float getTemperature() const {
+		return 25.0f + _randomTemperature.getValue() / 10.0f;
+	}
+	float getHumidity() const {
+		return 60.0f + _randomHumidity.getValue() / 10.0f;
+	};
+	float getPressure() const {
+		return 25.0f +  _randomPressure.getValue() / 10.0f;
+	};
+
+	//필드별로 한꺼번에 채운다 (getTemperature() 등을 차례로 부른 것과 같은 값)
+	void fillTemperatures(FloatSpan out) const {
+		_randomTemperature.fill(out, 25.0f, 10.0f);
+	}
+	void fillHumidities(FloatSpan out) const {
+		_randomHumidity.fill(out, 60.0f, 10.0f);
+	}
+	void fillPressures(FloatSpan out) const {
+		_randomPressure.fill(out, 25.0f, 10.0f);
+	}
+};
+
+//스레드마다 따로 두는 측정 장비 : 스레드끼리 난수 상태를 공유하지 않는다
+//시드마다 하나씩 만들어지므로 스레드 풀처럼 스레드를 다시 써도 같은 시드는 같은 수열을 이어 간다
+WeatherStation& getThreadWeatherStation(uint64_t seed) {
+	static thread_local unordered_map<uint64_t, WeatherStation> weatherStations;
+	return weatherStations.try_emplace(seed, seed).first->second;
+}
+
+class StatisticsDisplay : public IObserver {
+private:
+	float _maxTemp = 0.0f;
+	float _minTemp = 100.0f;
+	float _tempSum = 0.0f;
+	int _numReadings = 0;
+
+public:
+	void update(const SensorData& sensorData) override {
+		update(sensorData.temp, sensorData.humidity, sensorData.pressure);
+	}
+
+	void update(float temp, float humidity, float pressure) {
+		_tempSum += temp;
+		_numReadings++;
+
+		if (temp > _maxTemp) {
+			_maxTemp = temp;
+		}
+
+		if (temp < _minTemp) {
+			_minTemp = temp;
+		}
+
+		display();
+	}
+
+	//묶음 전체를 누적한 뒤 한 번만 출력한다
+	void updateBatch(SensorDataSpan readings) override {
+		if (readings.empty()) {
+			return;
+		}
+
+		accumulate(readings);
+		display();
+	}
+
+	//출력 없이 누적만 한다
+	void accumulate(SensorDataSpan readings) {
+		float tempSum = 0.0f;
+		float maxTemp = _maxTemp;
+		float minTemp = _minTemp;
+
+		for (const SensorData& sensorData : readings) {
+			tempSum += sensorData.temp;
+			maxTemp = max(maxTemp, sensorData.temp);
+			minTemp = min(minTemp, sensorData.temp);
+		}
+
+		_tempSum += tempSum;
+		_numReadings += static_cast<int>(readings.size());
+		_maxTemp = maxTemp;
+		_minTemp = minTemp;
+	}
+
+	void display() {
+		cout << "기상 통계 " << endl
+			<< "평균 기온 : " << (_tempSum / _numReadings) << "℃" << endl
+			<< "최저 기온 : " << _minTemp << "℃" << endl
+			<< "최고 기온 : " << _maxTemp << "℃" << endl << endl;
+	}
+};
+
+class CurrentConditionsDisplay : public IObserver {
+private:
+	float _temperature;
+	float _humidity;
+	float _pressure;
+
+public:
+	void update(const SensorData& sensorData) override {
+		update(sensorData.temp, sensorData.humidity, sensorData.pressure);
+	}
+
+	void update(float temperature, float humidity, float pressure) {
+		_temperature = temperature;
+		_humidity = humidity;
+		_pressure = pressure;
+		display();
+	}
+
+	void display() {
+		cout << "현재 조건 " << endl
+			<< "온도: " << _temperature << "℃" << endl
+			<< "습도: " << _humidity << "%" << endl
+			<< "기압: " << _pressure << endl << endl;
+
+	}
+};
+
+class ForecastDisplay : public IObserver {
+private:
+	float _currentPressure = 29.92f;
+	float _lastPressure;
+
+public:
+	void update(const SensorData& sensorData) override {
+		update(sensorData.temp, sensorData.humidity, sensorData.pressure);
+	}
+
+	void update(float temp, float humidity, float pressure) {
+		_lastPressure = _currentPressure;
+		_currentPressure = pressure;
+
+		display();
+	}
+
+	//예보는 마지막 두 기압만 비교하므로 묶음의 끝부분만 보고 한 번만 출력한다
+	void updateBatch(SensorDataSpan readings) override {
+		if (readings.empty()) {
+			return;
+		}
+
+		_lastPressure = readings.size() >= 2 ? readings[readings.size() - 2].pressure : _currentPressure;
+		_currentPressure = readings.back().pressure;
+
+		display();
+	}
+
+	void display() {
+		cout << "기상 예보" << endl;
+		if (_currentPressure > _lastPressure) {
+			cout << "가는 길에 날씨 개선" << endl << endl;
+		}
+		else if (_currentPressure == _lastPressure) {
+			cout << "전과 같음" << endl << endl;
+		}
+		else if (_currentPressure < _lastPressure) {
+			cout << "선선하고 비오는 날씨에 조심하십시오" << endl << endl;
+		}
+	}
+};
+
+
+
+class WeatherData : public ISubject {
+private:
+	WeatherStation _weatherStation;
+
+	//ISubject 구현시 사용할 멤버변수
+	//구독 토큰이 weak_ptr 로 가리킬 수 있도록 shared_ptr 로 보관한다
+	shared_ptr<ObserverRegistry> _registry = make_shared<ObserverRegistry>();
+
+	SensorData _sensorData;
+
+	//readMeasurementsBatch() 에서 재사용하는 버퍼 (용량을 유지하므로 매번 할당하지 않는다)
+	vector<SensorData> _batch;
+	vector<float> _temperatures;
+	vector<float> _humidities;
+	vector<float> _pressures;
+
+public:
+	WeatherData() = default;
+
+	//같은 시드면 항상 같은 측정값이 나온다
+	explicit WeatherData(uint64_t seed) : _weatherStation(seed) {
+	}
+
+	//옵저버 등록
+	Subscription registerObserver(shared_ptr<IObserver> pObserver) override {
+		return Subscription(_registry, _registry->insert(move(pObserver)));
+	}
+
+	//옵저버 제거
+	void removeObserver(Subscription& subscription) override {
+		subscription.release();
+	}
+
+	//변경 사실을 알린다
+	void notifyObserver() override {
+		const SensorData& sensorData = _sensorData;
+		_registry->forEach([&sensorData](IObserver& observer) {
+			observer.update(sensorData);
+		});
+	}
+
+	size_t getObserverCount() const {
+		return _registry->size();
+	}
+
+	//여러 측정값을 옵저버마다 한 번에 알린다
+	void notifyObserverBatch(SensorDataSpan readings) {
+		_registry->forEach([&readings](IObserver& observer) {
+			observer.updateBatch(readings);
+		});
+	}
+
+	//이미 수집된 측정값(밀린 기록 등)을 한 번에 전달한다
+	void replayBatch(SensorDataSpan readings) {
+		if (readings.empty()) {
+			return;
+		}
+		_sensorData = readings.back();
+		notifyObserverBatch(readings);
+	}
+
+	float getTemperature() const {
+		return _weatherStation.getTemperature();
+	}
+
+	float getHumidity() const {
+		return _weatherStation.getHumidity();
+	}
+
+	float getPressure() const {
+		return _weatherStation.getPressure();
+	}
+
+	void measurementsChanged() {
+		notifyObserver();
+	}
+
+	void readMeasurements() {
+		_sensorData.temp = _weatherStation.getTemperature();
+		_sensorData.humidity = _weatherStation.getHumidity();
+		_sensorData.pressure = _weatherStation.getPressure();
+
+		measurementsChanged();
+	}
+
+	//측정값 count 개를 먼저 모두 읽은 뒤 한 번만 알린다
+	//필드별로 난수를 한꺼번에 만든 뒤 측정값 구조체로 옮긴다
+	void readMeasurementsBatch(size_t count) {
+		_temperatures.resize(count);
+		_humidities.resize(count);
+		_pressures.resize(count);
+		_weatherStation.fillTemperatures(_temperatures);
+		_weatherStation.fillHumidities(_humidities);
+		_weatherStation.fillPressures(_pressures);
+
+		_batch.resize(count);
+		for (size_t idx = 0; idx < count; idx++) {
+			_batch[idx].temp = _temperatures[idx];
+			_batch[idx].humidity = _humidities[idx];
+			_batch[idx].pressure = _pressures[idx];
+		}
+
+		replayBatch(_batch);
+	}
+};
+
+
+
+
+//하나씩 꺼낸 값과 한꺼번에 채운 값이 같은지 확인한다
+bool checkFillMatchesGetValue(uint64_t seed, size_t count) {
+	WeatherStation single(seed);
+	WeatherStation bulk(seed);
+
+	//버퍼가 일부 남은 상태에서 fill() 하도록 하나를 먼저 꺼낸다
+	float first = bulk.getTemperature();
+	vector<float> temperatures(count);
+	bulk.fillTemperatures(temperatures);
+
+	if (single.getTemperature() != first) {
+		return false;
+	}
+	for (float temp : temperatures) {
+		if (single.getTemperature() != temp) {
+			return false;
+		}
+	}
+	return true;
+}
+
+//난수 생성 속도와 측정 장비 크기를 비교한다
+void benchmarkRandom() {
+	const size_t count = 20000000;
+
+	cout << "측정 장비 크기 : mt19937 3개 " << sizeof(MersenneRandom) * 3 << " 바이트, "
+		<< "FastRandom 3개 " << sizeof(WeatherStation) << " 바이트 "
+		<< "(장비 1만 개 : " << sizeof(MersenneRandom) * 3 * 10000 / 1024 << " KB -> "
+		<< sizeof(WeatherStation) * 10000 / 1024 << " KB)" << endl;
+
+	MersenneRandom mersenne(-50, 50);
+	FastRandom fast(-50, 50, 1);
+	vector<float> values(4096);
+	long long checksum = 0;
+
+	auto start = chrono::steady_clock::now();
+	for (size_t idx = 0; idx < count; idx++) {
+		checksum += mersenne.getValue();
+	}
+	auto middle = chrono::steady_clock::now();
+	for (size_t idx = 0; idx < count; idx++) {
+		checksum += fast.getValue();
+	}
+	auto middle2 = chrono::steady_clock::now();
+	for (size_t idx = 0; idx < count; idx += values.size()) {
+		fast.fill(values, 25.0f, 10.0f);
+		checksum += static_cast<long long>(values[0]);
+	}
+	auto end = chrono::steady_clock::now();
+
+	cout << "mt19937 + uniform_int_distribution : " << count / chrono::duration<double>(middle - start).count() / 1e6 << " 백만/초" << endl
+		<< "FastRandom::getValue() : " << count / chrono::duration<double>(middle2 - middle).count() / 1e6 << " 백만/초" << endl
+		<< "FastRandom::fill() : " << count / chrono::duration<double>(end - middle2).count() / 1e6 << " 백만/초"
+		<< " (" << checksum % 10 << ")" << endl;
+}
+
+//스레드마다 자기 측정 장비로 측정값을 만든다 (공유 상태 없음)
+void benchmarkThreadLocalStations(int threadCount) {
+	const size_t readingsPerThread = 4000000;
+	vector<thread> threads;
+	vector<double> sums(threadCount);
+
+	auto start = chrono::steady_clock::now();
+	for (int idx = 0; idx < threadCount; idx++) {
+		threads.emplace_back([idx, &sums]() {
+			WeatherStation& weatherStation = getThreadWeatherStation(1000 + idx);
+			vector<float> temperatures(4096);
+			double sum = 0.0;
+			for (size_t done = 0; done < readingsPerThread; done += temperatures.size()) {
+				weatherStation.fillTemperatures(temperatures);
+				sum += temperatures[0];
+			}
+			sums[idx] = sum;
+		});
+	}
+	for (thread& worker : threads) {
+		worker.join();
+	}
+	auto end = chrono::steady_clock::now();
+
+	cout << "스레드 " << threadCount << "개 : "
+		<< threadCount * readingsPerThread / chrono::duration<double>(end - start).count() / 1e6
+		<< " 백만 측정값/초" << endl;
+}
+
+int main(int argc, char** argv) {
+
+	//시드를 지정하면 실행할 때마다 같은 측정값이 나온다
+	shared_ptr<WeatherData> pWeatherData = make_shared<WeatherData>(42);
+	//출력 장치 객체 생성
+	shared_ptr<StatisticsDisplay> pStatisticsDisplay = make_shared<StatisticsDisplay>();
+	shared_ptr<CurrentConditionsDisplay> pCurrentConditionsDisplay = make_shared<CurrentConditionsDisplay>();
+
+	//출력 장치를 등록한다 (토큰을 보관해야 구독이 유지된다)
+	Subscription statisticsSubscription = pWeatherData->registerObserver(pStatisticsDisplay);
+	Subscription currentConditionsSubscription = pWeatherData->registerObserver(pCurrentConditionsDisplay);
+
+	//측정값을 읽는다
+	pWeatherData->readMeasurements();
+	pWeatherData->readMeasurements();
+
+	//측정값 1000개를 한꺼번에 만들어서 알린다
+	pWeatherData->removeObserver(currentConditionsSubscription);
+	pWeatherData->readMeasurementsBatch(1000);
+
+	cout << "getValue() 와 fill() 결과 일치 : "
+		<< (checkFillMatchesGetValue(7, 1001) ? "예" : "아니오") << endl;
+
+	benchmarkRandom();
+	benchmarkThreadLocalStations(1);
+	benchmarkThreadLocalStations(4);
+
+	return 0;
+}
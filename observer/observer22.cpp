@@ -0,0 +1,2125 @@
+﻿// observer.cpp : 이 파일에는 'main' 함수가 포함됩니다. 거기서 프로그램 실행이 시작되고 종료됩니다.
+//
+
+#include <iostream>
+#include <memory>
+#include <random>
+#include <ctime>
+#include <functional>
+#include <list>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <algorithm>
+#include <thread>
+#include <fstream>
+#include <string>
+#include <cstring>
+#include <stdexcept>
+#include <cstdio>
+#include <mutex>
+#include <condition_variable>
+#include <tuple>
+#include <new>
+#include <type_traits>
+#include <cstddef>
+#include <atomic>
+#include <cstdlib>
+#include <cmath>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+struct SensorData {
+	float temp;
+	float humidity;
+	float pressure;
+	float temp_top;
+	float temp_bottom;
+};
+
+//측정값 필드 번호
+enum class SensorField {
+	Temp,
+	Humidity,
+	Pressure,
+	TempTop,
+	TempBottom,
+};
+
+static const size_t SENSOR_FIELD_COUNT = 5;
+
+//필드 집합은 비트 마스크로 나타낸다
+static const uint32_t ALL_FIELDS = (1u << SENSOR_FIELD_COUNT) - 1;
+
+inline uint32_t fieldMask(SensorField field) {
+	return 1u << static_cast<uint32_t>(field);
+}
+
+inline float getField(const SensorData& sensorData, SensorField field) {
+	switch (field) {
+	case SensorField::Temp:
+		return sensorData.temp;
+	case SensorField::Humidity:
+		return sensorData.humidity;
+	case SensorField::Pressure:
+		return sensorData.pressure;
+	case SensorField::TempTop:
+		return sensorData.temp_top;
+	default:
+		return sensorData.temp_bottom;
+	}
+}
+
+//필드 값 조건 (예: 기온 > 30)
+enum class Comparison : uint8_t {
+	Always,
+	Greater,
+	Less,
+};
+
+struct FieldPredicate {
+	SensorField field = SensorField::Temp;
+	Comparison comparison = Comparison::Always;
+	float threshold = 0.0f;
+
+	bool test(const SensorData& sensorData) const {
+		switch (comparison) {
+		case Comparison::Greater:
+			return getField(sensorData, field) > threshold;
+		case Comparison::Less:
+			return getField(sensorData, field) < threshold;
+		default:
+			return true;
+		}
+	}
+};
+
+inline FieldPredicate whenGreater(SensorField field, float threshold) {
+	return FieldPredicate{ field, Comparison::Greater, threshold };
+}
+
+inline FieldPredicate whenLess(SensorField field, float threshold) {
+	return FieldPredicate{ field, Comparison::Less, threshold };
+}
+
+//필드별 불감대 : 마지막으로 알린 값에서 이보다 크게 바뀌어야 변경으로 본다
+//absolute 와 relative(마지막 값에 대한 비율) 중 큰 쪽을 쓰고, 둘 다 0 이면 값이 조금이라도 다르면 변경이다
+struct DeadBand {
+	float absolute = 0.0f;
+	float relative = 0.0f;
+};
+
+//측정값이 의미 있게 바뀐 필드를 찾는다
+//기준값은 변경으로 판정된 필드만 갱신하므로 조금씩 움직이는 값도 누적되면 결국 알린다
+class ChangeDetector {
+private:
+	DeadBand _deadBands[SENSOR_FIELD_COUNT];
+	float _reference[SENSOR_FIELD_COUNT] = {};
+	bool _hasReference = false;
+
+public:
+	void setDeadBand(SensorField field, DeadBand deadBand) {
+		_deadBands[static_cast<size_t>(field)] = deadBand;
+	}
+
+	//다음 측정값은 모든 필드가 바뀐 것으로 본다
+	void reset() {
+		_hasReference = false;
+	}
+
+	//바뀐 필드의 마스크를 돌려준다 (0 이면 알릴 필요가 없다)
+	uint32_t detect(const SensorData& sensorData) {
+		uint32_t changedFields = 0;
+		for (size_t idx = 0; idx < SENSOR_FIELD_COUNT; idx++) {
+			float value = getField(sensorData, static_cast<SensorField>(idx));
+			float threshold = max(_deadBands[idx].absolute, _deadBands[idx].relative * fabs(_reference[idx]));
+			float difference = fabs(value - _reference[idx]);
+
+			bool changed = !_hasReference || (threshold > 0.0f ? difference > threshold : value != _reference[idx]);
+			if (changed) {
+				_reference[idx] = value;
+				changedFields |= 1u << idx;
+			}
+		}
+		_hasReference = true;
+		return changedFields;
+	}
+};
+
+//연속된 측정값 묶음을 가리키는 읽기 전용 구간 (복사하지 않는다)
+class SensorDataSpan {
+private:
+	const SensorData* _data;
+	size_t _size;
+
+public:
+	SensorDataSpan(const SensorData* data, size_t size) : _data(data), _size(size) {
+	}
+
+	SensorDataSpan(const vector<SensorData>& readings) : _data(readings.data()), _size(readings.size()) {
+	}
+
+	const SensorData* begin() const {
+		return _data;
+	}
+
+	const SensorData* end() const {
+		return _data + _size;
+	}
+
+	const SensorData& operator[](size_t idx) const {
+		return _data[idx];
+	}
+
+	const SensorData& back() const {
+		return _data[_size - 1];
+	}
+
+	size_t size() const {
+		return _size;
+	}
+
+	bool empty() const {
+		return _size == 0;
+	}
+};
+
+class IObserver {
+public:
+	virtual void update(const SensorData& sensorData) = 0;
+
+	//여러 측정값을 가상 함수 호출 한 번으로 받는다
+	//기본 구현은 하나씩 update() 를 호출하고, 한꺼번에 처리할 수 있는 옵저버는 재정의한다
+	virtual void updateBatch(SensorDataSpan readings) {
+		for (const SensorData& sensorData : readings) {
+			update(sensorData);
+		}
+	}
+};
+
+//측정값을 받는 호출 가능 객체(람다, 멤버 함수 바인딩 등)를 담는 이동 전용 래퍼
+//캡처가 INLINE_SIZE 이하이면 객체 안에 직접 저장하므로 힙 할당이 없다
+//IObserver 와 달리 shared_ptr 이 필요 없어 등록/통보 중에 참조 카운트가 바뀌지 않는다
+class SensorCallback {
+public:
+	static const size_t INLINE_SIZE = 32;
+
+private:
+	struct Operations {
+		void (*invoke)(void* pStorage, const SensorData& sensorData);
+		void (*moveTo)(void* pFrom, void* pTo) noexcept; //pTo 로 옮기고 pFrom 은 소멸시킨다
+		void (*destroy)(void* pStorage) noexcept;
+		bool isInline;
+	};
+
+	//버퍼 안에 직접 저장
+	template<typename Func>
+	struct InlineOperations {
+		static void invoke(void* pStorage, const SensorData& sensorData) {
+			(*static_cast<Func*>(pStorage))(sensorData);
+		}
+		static void moveTo(void* pFrom, void* pTo) noexcept {
+			new (pTo) Func(move(*static_cast<Func*>(pFrom)));
+			static_cast<Func*>(pFrom)->~Func();
+		}
+		static void destroy(void* pStorage) noexcept {
+			static_cast<Func*>(pStorage)->~Func();
+		}
+		static constexpr Operations operations = { &invoke, &moveTo, &destroy, true };
+	};
+
+	//캡처가 크면 힙에 두고 포인터만 저장
+	template<typename Func>
+	struct HeapOperations {
+		static void invoke(void* pStorage, const SensorData& sensorData) {
+			(**static_cast<Func**>(pStorage))(sensorData);
+		}
+		static void moveTo(void* pFrom, void* pTo) noexcept {
+			*static_cast<Func**>(pTo) = *static_cast<Func**>(pFrom);
+		}
+		static void destroy(void* pStorage) noexcept {
+			delete *static_cast<Func**>(pStorage);
+		}
+		static constexpr Operations operations = { &invoke, &moveTo, &destroy, false };
+	};
+
+	template<typename Func>
+	static constexpr bool fitsInline = sizeof(Func) <= INLINE_SIZE
+		&& alignof(Func) <= alignof(max_align_t)
+		&& is_nothrow_move_constructible_v<Func>;
+
+	alignas(max_align_t) unsigned char _storage[INLINE_SIZE];
+	const Operations* _pOperations = nullptr;
+
+public:
+	SensorCallback() = default;
+
+	template<typename Func, typename = enable_if_t<!is_same_v<decay_t<Func>, SensorCallback>>>
+	SensorCallback(Func&& func) {
+		using Stored = decay_t<Func>;
+		if constexpr (fitsInline<Stored>) {
+			new (_storage) Stored(forward<Func>(func));
+			_pOperations = &InlineOperations<Stored>::operations;
+		}
+		else {
+			*reinterpret_cast<Stored**>(_storage) = new Stored(forward<Func>(func));
+			_pOperations = &HeapOperations<Stored>::operations;
+		}
+	}
+
+	SensorCallback(const SensorCallback&) = delete;
+	SensorCallback& operator=(const SensorCallback&) = delete;
+
+	SensorCallback(SensorCallback&& r) noexcept : _pOperations(r._pOperations) {
+		if (_pOperations != nullptr) {
+			_pOperations->moveTo(r._storage, _storage);
+			r._pOperations = nullptr;
+		}
+	}
+
+	SensorCallback& operator=(SensorCallback&& r) noexcept {
+		if (this != &r) {
+			reset();
+			if (r._pOperations != nullptr) {
+				r._pOperations->moveTo(r._storage, _storage);
+				_pOperations = r._pOperations;
+				r._pOperations = nullptr;
+			}
+		}
+		return *this;
+	}
+
+	~SensorCallback() {
+		reset();
+	}
+
+	void reset() {
+		if (_pOperations != nullptr) {
+			const Operations* pOperations = _pOperations;
+			_pOperations = nullptr;
+			pOperations->destroy(_storage);
+		}
+	}
+
+	explicit operator bool() const {
+		return _pOperations != nullptr;
+	}
+
+	//힙 할당 없이 저장되었는지
+	bool isInline() const {
+		return _pOperations != nullptr && _pOperations->isInline;
+	}
+
+	void operator()(const SensorData& sensorData) {
+		_pOperations->invoke(_storage, sensorData);
+	}
+};
+
+//객체의 멤버 함수를 콜백으로 묶는다 (객체는 구독이 끝날 때까지 살아 있어야 한다)
+template<typename T, typename Method>
+SensorCallback bindMember(T& object, Method method) {
+	return SensorCallback([pObject = &object, method](const SensorData& sensorData) {
+		(pObject->*method)(sensorData);
+	});
+}
+
+//등록된 옵저버를 가리키는 핸들 (슬롯 번호 + 세대)
+//제거된 뒤 같은 슬롯이 재사용되면 세대가 달라지므로 예전 핸들은 무효가 된다
+struct ObserverHandle {
+	uint32_t index = UINT32_MAX;
+	uint32_t generation = 0;
+};
+
+//구독 토큰이 가리키는 저장소 (옵저버 저장소와 콜백 저장소가 같은 토큰을 쓴다)
+//구독을 해제할 때만 불리므로 통보 경로에는 가상 호출이 늘지 않는다
+class IRegistry {
+public:
+	virtual ~IRegistry() = default;
+	virtual bool contains(ObserverHandle handle) const = 0;
+	virtual bool erase(ObserverHandle handle) = 0;
+};
+
+//슬롯맵(slot map) 방식의 옵저버 저장소
+//제거는 핸들로 O(1) 에 처리하고 빈칸은 표시만 해 둔다
+//
+//통보 도중(update() 안)에 등록/제거가 일어나도 안전하도록 구조 변경은 미뤄 둔다
+// - 등록 : 배열 끝에 추가되므로 이번 통보에서는 보이지 않고 다음 통보부터 받는다
+// - 제거 : 빈칸으로 표시만 하고 옵저버 객체도 통보가 끝날 때까지 놓아주지 않는다
+// - 정리(compact) : 가장 바깥 통보가 끝난 뒤에 한 번만 한다
+//목록을 복사하지 않으므로 평상시 통보 경로에서는 메모리 할당이 전혀 없다
+//
+//약한 참조로 등록한 옵저버는 소멸되면 통보 중에 발견하는 즉시 빈칸으로 표시하고
+//통보가 끝날 때 정리하므로 따로 목록을 훑지 않는다 (통보 한 번에 O(1) 씩 분할 상환)
+//
+//필드 -> 관심 옵저버 핸들의 역색인을 함께 유지한다
+//바뀐 필드에 관심 있는 옵저버가 전체보다 적으면 색인만 돌고, 많으면 배열 전체를 훑는다
+//색인은 핸들(슬롯 + 세대)을 저장하므로 정리로 배열 위치가 바뀌어도 다시 만들 필요가 없다
+//(제거된 핸들은 세대가 달라져 건너뛰고, 정리할 때 함께 지운다)
+class ObserverRegistry : public IRegistry {
+private:
+	static const uint32_t INVALID_INDEX = UINT32_MAX;
+
+	struct Slot {
+		uint32_t denseIndex; //_observers 안의 위치 (INVALID_INDEX 이면 빈 슬롯)
+		uint32_t generation; //슬롯 재사용 횟수
+	};
+
+	vector<IObserver*> _observers;         //통보할 때 순회하는 연속 배열 (정리 전에는 nullptr 빈칸이 있을 수 있다)
+	vector<shared_ptr<IObserver>> _owners; //수명 유지용 (약한 참조 옵저버는 비어 있다)
+	vector<weak_ptr<IObserver>> _weakOwners; //약한 참조로 등록한 옵저버 (강한 참조 옵저버는 비어 있다)
+	vector<uint32_t> _interestMasks;       //옵저버가 관심 있는 필드 (통보할 때 함께 읽는다)
+	vector<FieldPredicate> _predicates;    //옵저버가 받을 조건
+	vector<ObserverHandle> _fieldIndex[SENSOR_FIELD_COUNT]; //필드 -> 관심 옵저버 (등록 순서)
+	vector<uint32_t> _visitStamps;         //여러 필드가 바뀐 통보에서 같은 옵저버를 두 번 부르지 않도록 슬롯별로 표시
+	uint32_t _visitSerial = 0;
+	bool _indexedDispatch = true;
+	vector<uint32_t> _denseToSlot;         //_observers 위치 -> 슬롯 번호
+	vector<Slot> _slots;                   //핸들 -> _observers 위치
+	vector<uint32_t> _freeSlots;           //재사용할 빈 슬롯 번호
+	vector<shared_ptr<IObserver>> _released; //정리 중에 놓아줄 옵저버 (용량은 재사용한다)
+	size_t _holeCount = 0;                 //정리되지 않은 빈칸 수
+	int _dispatchDepth = 0;                //진행 중인 통보 깊이 (update() 안에서 다시 통보할 수 있다)
+	size_t _weakCount = 0;                 //약한 참조 옵저버 수 (0 이면 통보 경로가 기존과 같다)
+	uint64_t _prunedCount = 0;             //소멸된 것을 발견해서 정리한 약한 참조 옵저버 수
+
+	//예외가 나도 통보 깊이가 복구되도록 한다
+	class DispatchScope {
+	private:
+		ObserverRegistry& _registry;
+
+	public:
+		DispatchScope(ObserverRegistry& registry) : _registry(registry) {
+			_registry._dispatchDepth++;
+		}
+
+		~DispatchScope() {
+			if (--_registry._dispatchDepth == 0) {
+				_registry.compact();
+			}
+		}
+	};
+
+public:
+	void reserve(size_t count) {
+		_observers.reserve(count);
+		_owners.reserve(count);
+		_weakOwners.reserve(count);
+		_interestMasks.reserve(count);
+		_predicates.reserve(count);
+		_denseToSlot.reserve(count);
+		_slots.reserve(count);
+	}
+
+	size_t size() const {
+		return _observers.size() - _holeCount;
+	}
+
+	bool isDispatching() const {
+		return _dispatchDepth > 0;
+	}
+
+	size_t getWeakCount() const {
+		return _weakCount;
+	}
+
+	uint64_t getPrunedCount() const {
+		return _prunedCount;
+	}
+
+	//false 이면 색인을 쓰지 않고 항상 배열 전체를 훑는다 (비교용)
+	void setIndexedDispatch(bool enabled) {
+		_indexedDispatch = enabled;
+	}
+
+	//배열 끝에 추가한다 : O(1)
+	//interestMask 의 필드 중 하나라도 바뀌었을 때만 통보한다
+	ObserverHandle insert(shared_ptr<IObserver> pObserver, uint32_t interestMask = ALL_FIELDS) {
+		IObserver* pRaw = pObserver.get();
+		return insertEntry(pRaw, move(pObserver), weak_ptr<IObserver>(), interestMask, FieldPredicate());
+	}
+
+	//조건을 만족하는 측정값만 받는다 (조건의 필드가 바뀌었을 때만 검사한다)
+	ObserverHandle insert(shared_ptr<IObserver> pObserver, const FieldPredicate& predicate) {
+		IObserver* pRaw = pObserver.get();
+		return insertEntry(pRaw, move(pObserver), weak_ptr<IObserver>(), fieldMask(predicate.field), predicate);
+	}
+
+	//약한 참조로 추가한다 : 옵저버의 수명은 등록과 상관없이 다른 곳에서 정해진다
+	ObserverHandle insertWeak(const shared_ptr<IObserver>& pObserver, uint32_t interestMask = ALL_FIELDS) {
+		_weakCount++;
+		return insertEntry(pObserver.get(), nullptr, pObserver, interestMask, FieldPredicate());
+	}
+
+private:
+	ObserverHandle insertEntry(IObserver* pRaw, shared_ptr<IObserver> pOwner, weak_ptr<IObserver> pWeakOwner,
+		uint32_t interestMask, const FieldPredicate& predicate) {
+		uint32_t slotIndex;
+		if (_freeSlots.empty()) {
+			slotIndex = static_cast<uint32_t>(_slots.size());
+			_slots.push_back(Slot{ INVALID_INDEX, 0 });
+			_visitStamps.push_back(0);
+		}
+		else {
+			slotIndex = _freeSlots.back();
+			_freeSlots.pop_back();
+		}
+
+		Slot& slot = _slots[slotIndex];
+		slot.denseIndex = static_cast<uint32_t>(_observers.size());
+
+		_observers.push_back(pRaw);
+		_owners.push_back(move(pOwner));
+		_weakOwners.push_back(move(pWeakOwner));
+		_interestMasks.push_back(interestMask);
+		_predicates.push_back(predicate);
+		_denseToSlot.push_back(slotIndex);
+
+		ObserverHandle handle{ slotIndex, slot.generation };
+		for (size_t field = 0; field < SENSOR_FIELD_COUNT; field++) {
+			if (interestMask & (1u << field)) {
+				_fieldIndex[field].push_back(handle);
+			}
+		}
+		return handle;
+	}
+
+	bool isLive(ObserverHandle handle) const {
+		const Slot& slot = _slots[handle.index];
+		return slot.denseIndex != INVALID_INDEX && slot.generation == handle.generation;
+	}
+
+	//옵저버 하나를 부를지 확인하고 부른다
+	template <typename Func>
+	void visit(size_t denseIndex, const SensorData& sensorData, Func& func) {
+		IObserver* pObserver = _observers[denseIndex];
+		if (pObserver == nullptr || !_predicates[denseIndex].test(sensorData)) {
+			return;
+		}
+		if (_owners[denseIndex]) {
+			func(*pObserver);
+			return;
+		}
+		//약한 참조 옵저버는 update() 가 끝날 때까지 붙잡아 둔다
+		shared_ptr<IObserver> pPinned = _weakOwners[denseIndex].lock();
+		if (!pPinned) {
+			pruneAt(denseIndex);
+			return;
+		}
+		func(*pPinned);
+	}
+
+	//소멸된 약한 참조 옵저버를 빈칸으로 표시한다
+	void pruneAt(size_t denseIndex) {
+		uint32_t slotIndex = _denseToSlot[denseIndex];
+		erase(ObserverHandle{ slotIndex, _slots[slotIndex].generation });
+		_prunedCount++;
+	}
+
+public:
+
+	bool contains(ObserverHandle handle) const override {
+		return handle.index < _slots.size()
+			&& _slots[handle.index].denseIndex != INVALID_INDEX
+			&& _slots[handle.index].generation == handle.generation;
+	}
+
+	//빈칸으로 표시만 한다 : O(1)
+	//통보 중이면 update() 가 아직 실행 중일 수 있으므로 옵저버 객체는 정리할 때 놓아준다
+	bool erase(ObserverHandle handle) override {
+		if (!contains(handle)) {
+			return false;
+		}
+
+		Slot& slot = _slots[handle.index];
+		uint32_t denseIndex = slot.denseIndex;
+		_observers[denseIndex] = nullptr;
+		_holeCount++;
+		if (!_owners[denseIndex]) {
+			_weakCount--;
+		}
+
+		slot.denseIndex = INVALID_INDEX;
+		slot.generation++;
+		_freeSlots.push_back(handle.index);
+
+		if (!isDispatching()) {
+			_owners[denseIndex].reset();
+		}
+		_weakOwners[denseIndex].reset();
+		return true;
+	}
+
+	//빈칸을 제거하고 남은 옵저버를 앞으로 당긴다 (등록 순서 유지)
+	//통보 중에는 아무 일도 하지 않고 가장 바깥 통보가 끝날 때 다시 불린다
+	void compact() {
+		if (_holeCount == 0 || isDispatching()) {
+			return;
+		}
+
+		size_t writeIndex = 0;
+		for (size_t readIndex = 0; readIndex < _observers.size(); readIndex++) {
+			if (_observers[readIndex] == nullptr) {
+				if (_owners[readIndex]) {
+					_released.push_back(move(_owners[readIndex]));
+				}
+				continue;
+			}
+			if (writeIndex != readIndex) {
+				_observers[writeIndex] = _observers[readIndex];
+				_owners[writeIndex] = move(_owners[readIndex]);
+				_weakOwners[writeIndex] = move(_weakOwners[readIndex]);
+				_interestMasks[writeIndex] = _interestMasks[readIndex];
+				_predicates[writeIndex] = _predicates[readIndex];
+				_denseToSlot[writeIndex] = _denseToSlot[readIndex];
+				_slots[_denseToSlot[writeIndex]].denseIndex = static_cast<uint32_t>(writeIndex);
+			}
+			writeIndex++;
+		}
+
+		_observers.resize(writeIndex);
+		_owners.resize(writeIndex);
+		_weakOwners.resize(writeIndex);
+		_interestMasks.resize(writeIndex);
+		_predicates.resize(writeIndex);
+		_denseToSlot.resize(writeIndex);
+		_holeCount = 0;
+
+		//제거된 옵저버의 핸들을 색인에서 지운다 (순서 유지)
+		for (vector<ObserverHandle>& handles : _fieldIndex) {
+			handles.erase(remove_if(handles.begin(), handles.end(), [this](ObserverHandle handle) {
+				return !isLive(handle);
+			}), handles.end());
+		}
+
+		//옵저버 소멸자가 다시 등록/제거를 해도 되도록 배열 정리가 끝난 뒤에 놓아준다
+		_released.clear();
+	}
+
+	//통보 시작 시점의 옵저버만 순회한다
+	//배열이 재할당될 수 있으므로 반복자 대신 위치로 접근하고, 도중에 생긴 빈칸은 건너뛴다
+	template <typename Func>
+	void forEach(Func&& func) {
+		forEachInterested(ALL_FIELDS, forward<Func>(func));
+	}
+
+	//changedFields 중 하나라도 관심 있는 옵저버만 순회한다 (조건은 보지 않는다)
+	template <typename Func>
+	void forEachInterested(uint32_t changedFields, Func&& func) {
+		compact();
+		DispatchScope scope(*this);
+
+		const size_t count = _observers.size();
+		if (_weakCount == 0) {
+			for (size_t idx = 0; idx < count; idx++) {
+				IObserver* pObserver = _observers[idx];
+				if (pObserver != nullptr && (_interestMasks[idx] & changedFields) != 0) {
+					func(*pObserver);
+				}
+			}
+			return;
+		}
+
+		//약한 참조 옵저버는 lock() 으로 붙잡은 채 부른다 : 다른 스레드나 update() 안에서 마지막 소유자가 놓아주어도
+		//update() 가 끝날 때까지 살아 있다 (참조 카운트 증감은 약한 참조 옵저버에만 든다)
+		for (size_t idx = 0; idx < count; idx++) {
+			IObserver* pObserver = _observers[idx];
+			if (pObserver == nullptr || (_interestMasks[idx] & changedFields) == 0) {
+				continue;
+			}
+			if (_owners[idx]) {
+				func(*pObserver);
+				continue;
+			}
+			shared_ptr<IObserver> pPinned = _weakOwners[idx].lock();
+			if (!pPinned) {
+				pruneAt(idx);
+				continue;
+			}
+			func(*pPinned);
+		}
+	}
+
+	//changedFields 중 하나라도 관심 있고 조건도 만족하는 옵저버만 순회한다
+	//바뀐 필드의 색인 크기 합이 전체보다 작을 때만 색인을 쓴다
+	//색인을 돌 때는 필드 순서대로 부르므로 여러 필드에 관심 있는 옵저버끼리는 등록 순서가 바뀔 수 있다
+	template <typename Func>
+	void forEachMatching(uint32_t changedFields, const SensorData& sensorData, Func&& func) {
+		compact();
+		DispatchScope scope(*this);
+
+		size_t indexedCount = 0;
+		for (size_t field = 0; field < SENSOR_FIELD_COUNT; field++) {
+			if (changedFields & (1u << field)) {
+				indexedCount += _fieldIndex[field].size();
+			}
+		}
+
+		if (!_indexedDispatch || indexedCount >= _observers.size()) {
+			const size_t count = _observers.size();
+			for (size_t idx = 0; idx < count; idx++) {
+				if ((_interestMasks[idx] & changedFields) != 0) {
+					visit(idx, sensorData, func);
+				}
+			}
+			return;
+		}
+
+		const bool multipleFields = (changedFields & (changedFields - 1)) != 0;
+		if (multipleFields && ++_visitSerial == 0) {
+			fill(_visitStamps.begin(), _visitStamps.end(), 0);
+			_visitSerial = 1;
+		}
+
+		//도중에 등록된 옵저버는 통보 시작 시점의 색인 길이 뒤에 붙으므로 이번에는 보이지 않는다
+		for (size_t field = 0; field < SENSOR_FIELD_COUNT; field++) {
+			if ((changedFields & (1u << field)) == 0) {
+				continue;
+			}
+
+			const size_t count = _fieldIndex[field].size();
+			for (size_t idx = 0; idx < count; idx++) {
+				ObserverHandle handle = _fieldIndex[field][idx];
+				if (!isLive(handle)) {
+					continue;
+				}
+				if (multipleFields) {
+					if (_visitStamps[handle.index] == _visitSerial) {
+						continue;
+					}
+					_visitStamps[handle.index] = _visitSerial;
+				}
+				visit(_slots[handle.index].denseIndex, sensorData, func);
+			}
+		}
+	}
+};
+
+//콜백을 값으로 저장하는 슬롯맵 (ObserverRegistry 와 같은 핸들/지연 정리 규칙)
+//콜백은 배열 안에서 실행되므로 통보 중에 배열이 재할당되면 안 된다
+//그래서 통보 중에 등록된 콜백은 _pending 에 모았다가 가장 바깥 통보가 끝난 뒤에 옮긴다
+class CallbackRegistry : public IRegistry {
+private:
+	static const uint32_t INVALID_INDEX = UINT32_MAX;
+
+	struct Slot {
+		uint32_t denseIndex; //_callbacks 안의 위치, _callbacks.size() 이상이면 _pending 안의 위치
+		uint32_t generation;
+	};
+
+	vector<SensorCallback> _callbacks;  //통보할 때 순회하는 연속 배열
+	vector<uint32_t> _denseToSlot;      //_callbacks 위치 -> 슬롯 번호 (INVALID_INDEX 이면 빈칸)
+	vector<SensorCallback> _pending;    //통보 중에 등록된 콜백
+	vector<uint32_t> _pendingToSlot;
+	vector<Slot> _slots;
+	vector<uint32_t> _freeSlots;
+	vector<SensorCallback> _released;   //정리 중에 소멸시킬 콜백 (용량은 재사용한다)
+	size_t _holeCount = 0;
+	int _dispatchDepth = 0;
+
+	class DispatchScope {
+	private:
+		CallbackRegistry& _registry;
+
+	public:
+		DispatchScope(CallbackRegistry& registry) : _registry(registry) {
+			_registry._dispatchDepth++;
+		}
+
+		~DispatchScope() {
+			if (--_registry._dispatchDepth == 0) {
+				_registry.compact();
+			}
+		}
+	};
+
+public:
+	void reserve(size_t count) {
+		_callbacks.reserve(count);
+		_denseToSlot.reserve(count);
+		_slots.reserve(count);
+	}
+
+	size_t size() const {
+		size_t pendingCount = 0;
+		for (uint32_t slotIndex : _pendingToSlot) {
+			if (slotIndex != INVALID_INDEX) {
+				pendingCount++;
+			}
+		}
+		return _callbacks.size() - _holeCount + pendingCount;
+	}
+
+	bool isDispatching() const {
+		return _dispatchDepth > 0;
+	}
+
+	ObserverHandle insert(SensorCallback callback) {
+		uint32_t slotIndex;
+		if (_freeSlots.empty()) {
+			slotIndex = static_cast<uint32_t>(_slots.size());
+			_slots.push_back(Slot{ INVALID_INDEX, 0 });
+		}
+		else {
+			slotIndex = _freeSlots.back();
+			_freeSlots.pop_back();
+		}
+
+		Slot& slot = _slots[slotIndex];
+		if (isDispatching()) {
+			slot.denseIndex = static_cast<uint32_t>(_callbacks.size() + _pending.size());
+			_pending.push_back(move(callback));
+			_pendingToSlot.push_back(slotIndex);
+		}
+		else {
+			slot.denseIndex = static_cast<uint32_t>(_callbacks.size());
+			_callbacks.push_back(move(callback));
+			_denseToSlot.push_back(slotIndex);
+		}
+
+		return ObserverHandle{ slotIndex, slot.generation };
+	}
+
+	bool contains(ObserverHandle handle) const override {
+		return handle.index < _slots.size()
+			&& _slots[handle.index].denseIndex != INVALID_INDEX
+			&& _slots[handle.index].generation == handle.generation;
+	}
+
+	//통보 중이면 실행 중일 수 있으므로 콜백은 정리할 때 소멸시킨다
+	bool erase(ObserverHandle handle) override {
+		if (!contains(handle)) {
+			return false;
+		}
+
+		Slot& slot = _slots[handle.index];
+		uint32_t denseIndex = slot.denseIndex;
+		if (denseIndex < _callbacks.size()) {
+			_denseToSlot[denseIndex] = INVALID_INDEX;
+			_holeCount++;
+			if (!isDispatching()) {
+				_callbacks[denseIndex].reset();
+			}
+		}
+		else {
+			_pendingToSlot[denseIndex - _callbacks.size()] = INVALID_INDEX;
+		}
+
+		slot.denseIndex = INVALID_INDEX;
+		slot.generation++;
+		_freeSlots.push_back(handle.index);
+		return true;
+	}
+
+	//빈칸을 제거하고 통보 중에 등록된 콜백을 뒤에 붙인다 (등록 순서 유지)
+	void compact() {
+		if (isDispatching() || (_holeCount == 0 && _pending.empty())) {
+			return;
+		}
+
+		size_t writeIndex = 0;
+		for (size_t readIndex = 0; readIndex < _callbacks.size(); readIndex++) {
+			if (_denseToSlot[readIndex] == INVALID_INDEX) {
+				if (_callbacks[readIndex]) {
+					_released.push_back(move(_callbacks[readIndex]));
+				}
+				continue;
+			}
+			if (writeIndex != readIndex) {
+				_callbacks[writeIndex] = move(_callbacks[readIndex]);
+				_denseToSlot[writeIndex] = _denseToSlot[readIndex];
+				_slots[_denseToSlot[writeIndex]].denseIndex = static_cast<uint32_t>(writeIndex);
+			}
+			writeIndex++;
+		}
+		_callbacks.resize(writeIndex);
+		_denseToSlot.resize(writeIndex);
+		_holeCount = 0;
+
+		for (size_t idx = 0; idx < _pending.size(); idx++) {
+			uint32_t slotIndex = _pendingToSlot[idx];
+			if (slotIndex == INVALID_INDEX) {
+				_released.push_back(move(_pending[idx]));
+				continue;
+			}
+			_slots[slotIndex].denseIndex = static_cast<uint32_t>(_callbacks.size());
+			_callbacks.push_back(move(_pending[idx]));
+			_denseToSlot.push_back(slotIndex);
+		}
+		_pending.clear();
+		_pendingToSlot.clear();
+
+		//콜백 소멸자가 다시 등록/제거를 해도 되도록 배열 정리가 끝난 뒤에 소멸시킨다
+		_released.clear();
+	}
+
+	//통보 시작 시점의 콜백만 호출한다
+	void notify(const SensorData& sensorData) {
+		compact();
+		DispatchScope scope(*this);
+
+		const size_t count = _callbacks.size();
+		for (size_t idx = 0; idx < count; idx++) {
+			if (_denseToSlot[idx] != INVALID_INDEX) {
+				_callbacks[idx](sensorData);
+			}
+		}
+	}
+};
+
+//registerObserver() 가 돌려주는 구독 토큰
+//토큰이 소멸되거나 release() 를 호출하면 O(1) 로 구독이 해제된다
+//주제 객체가 먼저 사라져도 안전하도록 저장소는 weak_ptr 로 가리킨다
+class Subscription {
+private:
+	weak_ptr<IRegistry> _registry;
+	ObserverHandle _handle;
+
+public:
+	Subscription() = default;
+
+	Subscription(weak_ptr<IRegistry> registry, ObserverHandle handle)
+		: _registry(move(registry)), _handle(handle) {
+	}
+
+	Subscription(const Subscription&) = delete;
+	Subscription& operator=(const Subscription&) = delete;
+
+	Subscription(Subscription&& r) noexcept
+		: _registry(move(r._registry)), _handle(r._handle) {
+		r._registry.reset();
+	}
+
+	Subscription& operator=(Subscription&& r) noexcept {
+		if (this != &r) {
+			release();
+			_registry = move(r._registry);
+			_handle = r._handle;
+			r._registry.reset();
+		}
+		return *this;
+	}
+
+	~Subscription() {
+		release();
+	}
+
+	//구독 해제
+	void release() {
+		if (shared_ptr<IRegistry> pRegistry = _registry.lock()) {
+			pRegistry->erase(_handle);
+		}
+		_registry.reset();
+	}
+
+	//토큰과의 연결만 끊고 구독은 주제 객체가 사라질 때까지 유지한다
+	void detach() {
+		_registry.reset();
+	}
+
+	bool isActive() const {
+		shared_ptr<IRegistry> pRegistry = _registry.lock();
+		return pRegistry && pRegistry->contains(_handle);
+	}
+};
+
+class ISubject {
+
+public:
+	//옵저버 등록 : 반환된 토큰이 살아있는 동안만 구독이 유지된다
+	[[nodiscard]] virtual Subscription registerObserver(shared_ptr<IObserver> pObserver) = 0;
+
+	//옵저버 제거
+	virtual void removeObserver(Subscription& subscription) = 0;
+
+	//변경 사실을 알린다
+	virtual void notifyObserver() = 0;
+};
+
+
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define FAST_RANDOM_SSE2 1
+#include <emmintrin.h>
+#endif
+
+//쓰기 가능한 float 연속 구간 (복사하지 않는다)
+class FloatSpan {
+private:
+	float* _data;
+	size_t _size;
+
+public:
+	FloatSpan(float* data, size_t size) : _data(data), _size(size) {
+	}
+
+	FloatSpan(vector<float>& values) : _data(values.data()), _size(values.size()) {
+	}
+
+	float* data() const {
+		return _data;
+	}
+
+	size_t size() const {
+		return _size;
+	}
+};
+
+//빠르고 작은 난수 생성기
+//xoshiro128** 4개를 나란히 돌려서 한 번에 4개씩 만든다 (상태 64바이트, mt19937 은 약 5KB)
+//같은 시드면 항상 같은 수열이 나오고, getValue() 로 하나씩 꺼내든 fill() 로 한꺼번에 채우든
+//SSE2 가 있든 없든 같은 순서로 같은 값이 나온다
+class FastRandom {
+private:
+	static const int LANES = 4;
+
+	uint32_t _state[4][LANES]; //[상태 워드][레인] : SIMD 레지스터에 바로 올릴 수 있는 배치
+	uint32_t _buffer[LANES];   //getValue() 용으로 미리 만들어 둔 값
+	int _bufferPos = LANES;
+	int _from;
+	uint32_t _range;           //to - from + 1
+
+	static uint64_t splitMix64(uint64_t& x) {
+		uint64_t z = (x += 0x9E3779B97F4A7C15ull);
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+		return z ^ (z >> 31);
+	}
+
+	static uint32_t rotl(uint32_t x, int k) {
+		return (x << k) | (x >> (32 - k));
+	}
+
+	//32비트 난수를 [0, range) 로 옮긴다 (곱셈 상위 32비트 방식, 나머지 연산 없음)
+	uint32_t toIndex(uint32_t bits) const {
+		return static_cast<uint32_t>((static_cast<uint64_t>(bits) * _range) >> 32);
+	}
+
+	//레인 4개를 한 단계씩 진행한다 (스칼라 기준 구현)
+	void next4(uint32_t out[LANES]) {
+		for (int lane = 0; lane < LANES; lane++) {
+			uint32_t s0 = _state[0][lane];
+			uint32_t s1 = _state[1][lane];
+			uint32_t s2 = _state[2][lane];
+			uint32_t s3 = _state[3][lane];
+
+			out[lane] = rotl(s1 * 5, 7) * 9;
+
+			uint32_t t = s1 << 9;
+			s2 ^= s0;
+			s3 ^= s1;
+			s1 ^= s2;
+			s0 ^= s3;
+			s2 ^= t;
+			s3 = rotl(s3, 11);
+
+			_state[0][lane] = s0;
+			_state[1][lane] = s1;
+			_state[2][lane] = s2;
+			_state[3][lane] = s3;
+		}
+	}
+
+public:
+	FastRandom(int from, int to, uint64_t seed) : _from(from), _range(static_cast<uint32_t>(to - from + 1)) {
+		//0 상태가 되지 않도록 splitmix64 로 시드를 펼친다
+		for (int lane = 0; lane < LANES; lane++) {
+			for (int word = 0; word < 4; word += 2) {
+				uint64_t z = splitMix64(seed);
+				_state[word][lane] = static_cast<uint32_t>(z);
+				_state[word + 1][lane] = static_cast<uint32_t>(z >> 32);
+			}
+		}
+	}
+
+	int getValue() {
+		if (_bufferPos == LANES) {
+			next4(_buffer);
+			_bufferPos = 0;
+		}
+		return _from + static_cast<int>(toIndex(_buffer[_bufferPos++]));
+	}
+
+	//out[i] = base + getValue() / divisor 를 한꺼번에 채운다
+	void fill(FloatSpan out, float base, float divisor) {
+		float* data = out.data();
+		size_t count = out.size();
+		size_t idx = 0;
+
+		//버퍼에 남은 값부터 써서 getValue() 와 같은 순서를 유지한다
+		for (; idx < count && _bufferPos < LANES; idx++) {
+			data[idx] = base + static_cast<float>(getValue()) / divisor;
+		}
+
+#ifdef FAST_RANDOM_SSE2
+		__m128i s0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(_state[0]));
+		__m128i s1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(_state[1]));
+		__m128i s2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(_state[2]));
+		__m128i s3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(_state[3]));
+		const __m128i range = _mm_set1_epi32(static_cast<int>(_range));
+		const __m128i from = _mm_set1_epi32(_from);
+		const __m128i oddMask = _mm_set_epi32(-1, 0, -1, 0);
+		const __m128 baseV = _mm_set1_ps(base);
+		const __m128 divisorV = _mm_set1_ps(divisor);
+
+		for (; idx + LANES <= count; idx += LANES) {
+			//rotl(s1 * 5, 7) * 9 : 곱셈을 시프트와 덧셈으로 바꾼다
+			__m128i x = _mm_add_epi32(_mm_slli_epi32(s1, 2), s1);
+			x = _mm_or_si128(_mm_slli_epi32(x, 7), _mm_srli_epi32(x, 25));
+			x = _mm_add_epi32(_mm_slli_epi32(x, 3), x);
+
+			__m128i t = _mm_slli_epi32(s1, 9);
+			s2 = _mm_xor_si128(s2, s0);
+			s3 = _mm_xor_si128(s3, s1);
+			s1 = _mm_xor_si128(s1, s2);
+			s0 = _mm_xor_si128(s0, s3);
+			s2 = _mm_xor_si128(s2, t);
+			s3 = _mm_or_si128(_mm_slli_epi32(s3, 11), _mm_srli_epi32(s3, 21));
+
+			//(x * range) >> 32 : 짝수/홀수 레인을 나눠 64비트 곱을 구한다
+			__m128i even = _mm_srli_epi64(_mm_mul_epu32(x, range), 32);
+			__m128i odd = _mm_and_si128(_mm_mul_epu32(_mm_srli_epi64(x, 32), range), oddMask);
+			__m128i value = _mm_add_epi32(_mm_or_si128(even, odd), from);
+
+			__m128 result = _mm_add_ps(baseV, _mm_div_ps(_mm_cvtepi32_ps(value), divisorV));
+			_mm_storeu_ps(data + idx, result);
+		}
+
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(_state[0]), s0);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(_state[1]), s1);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(_state[2]), s2);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(_state[3]), s3);
+#endif
+
+		for (; idx < count; idx++) {
+			data[idx] = base + static_cast<float>(getValue()) / divisor;
+		}
+	}
+};
+
+
+//읽기 전용으로 메모리에 매핑한 파일
+class MappedFile {
+private:
+#ifdef _WIN32
+	HANDLE _file = INVALID_HANDLE_VALUE;
+	HANDLE _mapping = nullptr;
+#else
+	int _fd = -1;
+#endif
+	const uint8_t* _data = nullptr;
+	size_t _size = 0;
+
+public:
+	explicit MappedFile(const string& path) {
+#ifdef _WIN32
+		_file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (_file == INVALID_HANDLE_VALUE) {
+			throw runtime_error("파일을 열 수 없습니다 : " + path);
+		}
+		LARGE_INTEGER fileSize;
+		if (!GetFileSizeEx(_file, &fileSize)) {
+			CloseHandle(_file);
+			throw runtime_error("파일 크기를 읽을 수 없습니다 : " + path);
+		}
+		_size = static_cast<size_t>(fileSize.QuadPart);
+		if (_size > 0) {
+			_mapping = CreateFileMappingA(_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			if (_mapping == nullptr) {
+				CloseHandle(_file);
+				throw runtime_error("파일을 매핑할 수 없습니다 : " + path);
+			}
+			_data = static_cast<const uint8_t*>(MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0));
+			if (_data == nullptr) {
+				CloseHandle(_mapping);
+				CloseHandle(_file);
+				throw runtime_error("파일을 매핑할 수 없습니다 : " + path);
+			}
+		}
+#else
+		_fd = open(path.c_str(), O_RDONLY);
+		if (_fd < 0) {
+			throw runtime_error("파일을 열 수 없습니다 : " + path);
+		}
+		struct stat fileStat;
+		if (fstat(_fd, &fileStat) != 0) {
+			close(_fd);
+			throw runtime_error("파일 크기를 읽을 수 없습니다 : " + path);
+		}
+		_size = static_cast<size_t>(fileStat.st_size);
+		if (_size > 0) {
+			void* pMapped = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, _fd, 0);
+			if (pMapped == MAP_FAILED) {
+				close(_fd);
+				throw runtime_error("파일을 매핑할 수 없습니다 : " + path);
+			}
+			madvise(pMapped, _size, MADV_SEQUENTIAL);
+			_data = static_cast<const uint8_t*>(pMapped);
+		}
+#endif
+	}
+
+	~MappedFile() {
+#ifdef _WIN32
+		if (_data != nullptr) {
+			UnmapViewOfFile(_data);
+		}
+		if (_mapping != nullptr) {
+			CloseHandle(_mapping);
+		}
+		CloseHandle(_file);
+#else
+		if (_data != nullptr) {
+			munmap(const_cast<uint8_t*>(_data), _size);
+		}
+		close(_fd);
+#endif
+	}
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	const uint8_t* data() const {
+		return _data;
+	}
+
+	size_t size() const {
+		return _size;
+	}
+};
+
+//측정값 기록 파일 머리말
+//머리말 뒤에 SensorData 가 고정 크기로 이어진다 (기록한 장비와 같은 바이트 순서)
+struct RecordingHeader {
+	char magic[8];       //"WXREC01"
+	uint32_t version;
+	uint32_t recordSize; //sizeof(SensorData)
+	uint64_t count;      //측정값 수
+};
+
+static const char RECORDING_MAGIC[8] = { 'W', 'X', 'R', 'E', 'C', '0', '1', '\0' };
+
+//측정값을 기록 파일로 쓴다
+class SensorRecordingWriter {
+private:
+	ofstream _file;
+	uint64_t _count = 0;
+
+public:
+	explicit SensorRecordingWriter(const string& path) : _file(path, ios::binary | ios::trunc) {
+		if (!_file) {
+			throw runtime_error("파일을 만들 수 없습니다 : " + path);
+		}
+		RecordingHeader header{};
+		_file.write(reinterpret_cast<const char*>(&header), sizeof(header)); //개수는 닫을 때 채운다
+	}
+
+	~SensorRecordingWriter() {
+		close();
+	}
+
+	void write(const SensorData& sensorData) {
+		_file.write(reinterpret_cast<const char*>(&sensorData), sizeof(SensorData));
+		_count++;
+	}
+
+	void close() {
+		if (!_file.is_open()) {
+			return;
+		}
+		RecordingHeader header{};
+		memcpy(header.magic, RECORDING_MAGIC, sizeof(header.magic));
+		header.version = 1;
+		header.recordSize = sizeof(SensorData);
+		header.count = _count;
+
+		_file.seekp(0);
+		_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		_file.close();
+	}
+};
+
+//메모리에 매핑한 기록 파일 : 읽을 때 복사나 파일 입출력 호출이 없다
+class SensorRecording {
+private:
+	MappedFile _file;
+	const uint8_t* _records = nullptr;
+	size_t _count = 0;
+
+public:
+	explicit SensorRecording(const string& path) : _file(path) {
+		RecordingHeader header;
+		if (_file.size() < sizeof(header)) {
+			throw runtime_error("기록 파일이 아닙니다 : " + path);
+		}
+		memcpy(&header, _file.data(), sizeof(header));
+		if (memcmp(header.magic, RECORDING_MAGIC, sizeof(header.magic)) != 0
+			|| header.version != 1
+			|| header.recordSize != sizeof(SensorData)
+			|| header.count > (_file.size() - sizeof(header)) / sizeof(SensorData)) {
+			throw runtime_error("기록 파일 형식이 맞지 않습니다 : " + path);
+		}
+
+		_records = _file.data() + sizeof(header);
+		_count = static_cast<size_t>(header.count);
+	}
+
+	size_t size() const {
+		return _count;
+	}
+
+	SensorData at(size_t index) const {
+		SensorData sensorData;
+		memcpy(&sensorData, _records + index * sizeof(SensorData), sizeof(SensorData));
+		return sensorData;
+	}
+};
+
+class WeatherStation {
+private:
+	//getTemperature() 등은 const 이지만 난수 상태는 바뀌므로 mutable 로 둔다 (const_cast 불필요)
+	mutable FastRandom _randomTemperature; //온도 난수 객체
+	mutable FastRandom _randomHumidity; //습도 난수 객체
+	mutable FastRandom _randomPressure; //압력 난수 객체
+
+	//기록 파일에서 읽을 때 (nullptr 이면 난수로 만든다)
+	shared_ptr<const SensorRecording> _pRecording;
+	size_t _recordingPosition = 0;
+
+	static uint64_t makeSeed() {
+		random_device rd;
+		return (static_cast<uint64_t>(rd()) << 32) | rd();
+	}
+
+public :
+	//실행할 때마다 다른 값
+	WeatherStation() : WeatherStation(makeSeed()) {
+	}
+
+	//같은 시드면 항상 같은 측정값
+	explicit WeatherStation(uint64_t seed) : _randomTemperature{ -50, 50, seed }
+		, _randomHumidity{ -100, 100, seed + 1 }
+		, _randomPressure{ -100, 100, seed + 2 } {
+	}
+
+	//기록 파일의 측정값을 처음부터 순서대로 돌려준다
+	explicit WeatherStation(shared_ptr<const SensorRecording> pRecording) : WeatherStation(0) {
+		_pRecording = move(pRecording);
+	}
+
+	bool isRecording() const {
+		return _pRecording != nullptr;
+	}
+
+	//다음 측정값을 읽는다 (기록 파일이 끝나면 false)
+	bool read(SensorData& sensorData) {
+		if (_pRecording) {
+			if (_recordingPosition == _pRecording->size()) {
+				return false;
+			}
+			sensorData = _pRecording->at(_recordingPosition++);
+			return true;
+		}
+
+		sensorData.temp = getTemperature();
+		sensorData.humidity = getHumidity();
+		sensorData.pressure = getPressure();
+		sensorData.temp_top = 0.0f;
+		sensorData.temp_bottom = 0.0f;
+		return true;
+	}
+
+	float getTemperature() const {
+		return 25.0f + _randomTemperature.getValue() / 10.0f;
+	}
+	float getHumidity() const {
+		return 60.0f + _randomHumidity.getValue() / 10.0f;
+	};
+	float getPressure() const {
+		return 25.0f +  _randomPressure.getValue() / 10.0f;
+	};
+
+	//필드별로 한꺼번에 채운다 (getTemperature() 등을 차례로 부른 것과 같은 값)
+	void fillTemperatures(FloatSpan out) const {
+		_randomTemperature.fill(out, 25.0f, 10.0f);
+	}
+	void fillHumidities(FloatSpan out) const {
+		_randomHumidity.fill(out, 60.0f, 10.0f);
+	}
+	void fillPressures(FloatSpan out) const {
+		_randomPressure.fill(out, 25.0f, 10.0f);
+	}
+};
+
+
+//출력할 문장을 만드는 버퍼 : clear() 해도 용량을 유지하므로 다시 쓸 때 할당하지 않는다
+class TextBuffer {
+private:
+	vector<char> _data;
+
+public:
+	TextBuffer() {
+		_data.reserve(256);
+	}
+
+	void clear() {
+		_data.clear();
+	}
+
+	const char* data() const {
+		return _data.data();
+	}
+
+	size_t size() const {
+		return _data.size();
+	}
+
+	TextBuffer& operator<<(const char* text) {
+		_data.insert(_data.end(), text, text + strlen(text));
+		return *this;
+	}
+
+	TextBuffer& operator<<(char ch) {
+		_data.push_back(ch);
+		return *this;
+	}
+
+	//cout 의 기본 출력 형식(유효숫자 6자리)과 같게 만든다
+	TextBuffer& operator<<(float value) {
+		char text[32];
+		int length = snprintf(text, sizeof(text), "%g", value);
+		_data.insert(_data.end(), text, text + length);
+		return *this;
+	}
+};
+
+//출력 장치가 쓰는 출력 대상
+//write() 는 내용을 메모리에 복사만 하고 돌아오며, 실제 파일 출력은 별도 쓰기 스레드가 모아서 한다
+//모인 양이 flushBytes 를 넘거나 flushInterval 이 지나면 한 번에 쓰고 비운다
+class OutputSink {
+private:
+	FILE* _pFile;
+	const size_t _flushBytes;
+	const size_t _maxBytes; //쓰기 스레드가 못 따라올 때 여기까지만 쌓고 기다린다
+	const chrono::milliseconds _flushInterval;
+
+	mutex _mutex;
+	condition_variable _wake;
+	condition_variable _drained;
+	vector<char> _front; //write() 가 채우는 버퍼
+	vector<char> _back;  //쓰기 스레드가 출력 중인 버퍼
+	bool _writing = false;
+	bool _flushRequested = false;
+	bool _stop = false;
+
+	uint64_t _flushCount = 0;
+	uint64_t _stallCount = 0;
+
+	thread _writer;
+
+	void writerLoop() {
+		unique_lock<mutex> lock(_mutex);
+		while (true) {
+			_wake.wait_for(lock, _flushInterval, [this] {
+				return _stop || _flushRequested || _front.size() >= _flushBytes;
+			});
+
+			if (_front.empty()) {
+				_flushRequested = false;
+				_drained.notify_all();
+				if (_stop) {
+					break;
+				}
+				continue;
+			}
+
+			//버퍼를 바꿔 끼우고 잠금을 푼 상태에서 출력한다 (그동안 write() 는 새 버퍼에 쌓는다)
+			_front.swap(_back);
+			_writing = true;
+			lock.unlock();
+
+			fwrite(_back.data(), 1, _back.size(), _pFile);
+			fflush(_pFile);
+			_back.clear();
+
+			lock.lock();
+			_writing = false;
+			_flushCount++;
+			_drained.notify_all();
+		}
+	}
+
+public:
+	explicit OutputSink(FILE* pFile, size_t flushBytes = 64 * 1024,
+		chrono::milliseconds flushInterval = chrono::milliseconds(50), size_t maxBytes = 4 * 1024 * 1024)
+		: _pFile(pFile), _flushBytes(flushBytes), _maxBytes(max(maxBytes, flushBytes)), _flushInterval(flushInterval) {
+		_front.reserve(_maxBytes);
+		_back.reserve(_maxBytes);
+		_writer = thread(&OutputSink::writerLoop, this);
+	}
+
+	~OutputSink() {
+		{
+			lock_guard<mutex> lock(_mutex);
+			_stop = true;
+		}
+		_wake.notify_one();
+		_writer.join();
+	}
+
+	OutputSink(const OutputSink&) = delete;
+	OutputSink& operator=(const OutputSink&) = delete;
+
+	//스레드마다 하나씩 있는 문장 버퍼를 비워서 돌려준다
+	static TextBuffer& threadBuffer() {
+		thread_local TextBuffer buffer;
+		buffer.clear();
+		return buffer;
+	}
+
+	void write(const TextBuffer& text) {
+		bool wakeWriter;
+		{
+			unique_lock<mutex> lock(_mutex);
+			if (_front.size() + text.size() > _maxBytes) {
+				_stallCount++;
+				_wake.notify_one();
+				_drained.wait(lock, [this, &text] {
+					return _front.size() + text.size() <= _maxBytes || _front.empty();
+				});
+			}
+			_front.insert(_front.end(), text.data(), text.data() + text.size());
+			wakeWriter = _front.size() >= _flushBytes;
+		}
+		if (wakeWriter) {
+			_wake.notify_one();
+		}
+	}
+
+	//지금까지 쓴 내용이 모두 출력될 때까지 기다린다
+	void flush() {
+		unique_lock<mutex> lock(_mutex);
+		_flushRequested = true;
+		_wake.notify_one();
+		_drained.wait(lock, [this] {
+			return _front.empty() && !_writing;
+		});
+	}
+
+	uint64_t getFlushCount() {
+		lock_guard<mutex> lock(_mutex);
+		return _flushCount;
+	}
+
+	uint64_t getStallCount() {
+		lock_guard<mutex> lock(_mutex);
+		return _stallCount;
+	}
+};
+
+class StatisticsDisplay : public IObserver {
+private:
+	OutputSink& _sink;
+	float _maxTemp = 0.0f;
+	float _minTemp = 100.0f;
+	float _tempSum = 0.0f;
+	int _numReadings = 0;
+
+public:
+	explicit StatisticsDisplay(OutputSink& sink) : _sink(sink) {
+	}
+
+	void update(const SensorData& sensorData) override {
+		update(sensorData.temp, sensorData.humidity, sensorData.pressure);
+	}
+
+	void update(float temp, float humidity, float pressure) {
+		_tempSum += temp;
+		_numReadings++;
+
+		if (temp > _maxTemp) {
+			_maxTemp = temp;
+		}
+
+		if (temp < _minTemp) {
+			_minTemp = temp;
+		}
+
+		display();
+	}
+
+	//묶음 전체를 누적한 뒤 한 번만 출력한다
+	void updateBatch(SensorDataSpan readings) override {
+		if (readings.empty()) {
+			return;
+		}
+
+		accumulate(readings);
+		display();
+	}
+
+	//출력 없이 누적만 한다
+	void accumulate(SensorDataSpan readings) {
+		float tempSum = 0.0f;
+		float maxTemp = _maxTemp;
+		float minTemp = _minTemp;
+
+		for (const SensorData& sensorData : readings) {
+			tempSum += sensorData.temp;
+			maxTemp = max(maxTemp, sensorData.temp);
+			minTemp = min(minTemp, sensorData.temp);
+		}
+
+		_tempSum += tempSum;
+		_numReadings += static_cast<int>(readings.size());
+		_maxTemp = maxTemp;
+		_minTemp = minTemp;
+	}
+
+	void display() {
+		TextBuffer& text = OutputSink::threadBuffer();
+		text << "기상 통계 \n"
+			<< "평균 기온 : " << (_tempSum / _numReadings) << "℃\n"
+			<< "최저 기온 : " << _minTemp << "℃\n"
+			<< "최고 기온 : " << _maxTemp << "℃\n\n";
+		_sink.write(text);
+	}
+};
+
+class CurrentConditionsDisplay : public IObserver {
+private:
+	OutputSink& _sink;
+	float _temperature = 0.0f;
+	float _humidity = 0.0f;
+	float _pressure = 0.0f;
+
+public:
+	explicit CurrentConditionsDisplay(OutputSink& sink) : _sink(sink) {
+	}
+
+	void update(const SensorData& sensorData) override {
+		update(sensorData.temp, sensorData.humidity, sensorData.pressure);
+	}
+
+	void update(float temperature, float humidity, float pressure) {
+		_temperature = temperature;
+		_humidity = humidity;
+		_pressure = pressure;
+		display();
+	}
+
+	void display() {
+		TextBuffer& text = OutputSink::threadBuffer();
+		text << "현재 조건 \n"
+			<< "온도: " << _temperature << "℃\n"
+			<< "습도: " << _humidity << "%\n"
+			<< "기압: " << _pressure << "\n\n";
+		_sink.write(text);
+	}
+};
+
+class ForecastDisplay : public IObserver {
+private:
+	OutputSink& _sink;
+	float _currentPressure = 29.92f;
+	float _lastPressure = 29.92f;
+
+public:
+	explicit ForecastDisplay(OutputSink& sink) : _sink(sink) {
+	}
+
+	void update(const SensorData& sensorData) override {
+		update(sensorData.temp, sensorData.humidity, sensorData.pressure);
+	}
+
+	void update(float temp, float humidity, float pressure) {
+		_lastPressure = _currentPressure;
+		_currentPressure = pressure;
+
+		display();
+	}
+
+	//예보는 마지막 두 기압만 비교하므로 묶음의 끝부분만 보고 한 번만 출력한다
+	void updateBatch(SensorDataSpan readings) override {
+		if (readings.empty()) {
+			return;
+		}
+
+		_lastPressure = readings.size() >= 2 ? readings[readings.size() - 2].pressure : _currentPressure;
+		_currentPressure = readings.back().pressure;
+
+		display();
+	}
+
+	void display() {
+		TextBuffer& text = OutputSink::threadBuffer();
+		text << "기상 예보\n";
+		if (_currentPressure > _lastPressure) {
+			text << "가는 길에 날씨 개선\n\n";
+		}
+		else if (_currentPressure == _lastPressure) {
+			text << "전과 같음\n\n";
+		}
+		else if (_currentPressure < _lastPressure) {
+			text << "선선하고 비오는 날씨에 조심하십시오\n\n";
+		}
+		_sink.write(text);
+	}
+};
+
+
+
+class WeatherData : public ISubject {
+private:
+	WeatherStation _weatherStation;
+
+	//ISubject 구현시 사용할 멤버변수
+	//구독 토큰이 weak_ptr 로 가리킬 수 있도록 shared_ptr 로 보관한다
+	shared_ptr<ObserverRegistry> _registry = make_shared<ObserverRegistry>();
+	//subscribe() 로 등록한 콜백
+	shared_ptr<CallbackRegistry> _callbacks = make_shared<CallbackRegistry>();
+
+	SensorData _sensorData{};
+
+	//값이 의미 있게 바뀌었을 때만 알린다
+	ChangeDetector _changeDetector;
+	bool _changeDetection = false;        //setChangeDetection(true) 나 처음 setDeadBand() 를 부르면 켜진다
+	uint64_t _readingCount = 0;
+	uint64_t _suppressedCount = 0;        //바뀐 필드가 없어서 알리지 않은 측정값 수
+	uint64_t _observerCallCount = 0;      //옵저버 update() 호출 수
+
+	//readMeasurementsBatch() 에서 재사용하는 버퍼 (용량을 유지하므로 매번 할당하지 않는다)
+	vector<SensorData> _batch;
+	vector<float> _temperatures;
+	vector<float> _humidities;
+	vector<float> _pressures;
+
+public:
+	WeatherData() = default;
+
+	//같은 시드면 항상 같은 측정값이 나온다
+	explicit WeatherData(uint64_t seed) : _weatherStation(seed) {
+	}
+
+	//기록 파일을 그대로 다시 재생한다
+	explicit WeatherData(shared_ptr<const SensorRecording> pRecording) : _weatherStation(move(pRecording)) {
+	}
+
+	//옵저버 등록
+	Subscription registerObserver(shared_ptr<IObserver> pObserver) override {
+		return Subscription(_registry, _registry->insert(move(pObserver)));
+	}
+
+	//관심 있는 필드를 지정해서 등록한다 : 그 필드가 바뀐 측정값만 받는다
+	//예) fieldMask(SensorField::Temp) 이면 기온이 바뀌었을 때만 통보
+	[[nodiscard]] Subscription registerObserver(shared_ptr<IObserver> pObserver, uint32_t interestMask) {
+		return Subscription(_registry, _registry->insert(move(pObserver), interestMask));
+	}
+
+	//조건을 지정해서 등록한다 : 조건의 필드가 바뀌고 조건을 만족할 때만 받는다
+	//예) whenGreater(SensorField::Temp, 30.0f)
+	[[nodiscard]] Subscription registerObserver(shared_ptr<IObserver> pObserver, const FieldPredicate& predicate) {
+		return Subscription(_registry, _registry->insert(move(pObserver), predicate));
+	}
+
+	//false 이면 필드 색인 없이 모든 옵저버의 관심 필드를 검사한다 (비교용)
+	void setIndexedDispatch(bool enabled) {
+		_registry->setIndexedDispatch(enabled);
+	}
+
+	//호출 가능 객체를 등록한다 : 옵저버 클래스나 shared_ptr 없이 콜백만 저장한다
+	//void(const SensorData&) 로 호출할 수 있으면 되고, 캡처가 작으면 할당도 없다
+	[[nodiscard]] Subscription subscribe(SensorCallback callback) {
+		return Subscription(_callbacks, _callbacks->insert(move(callback)));
+	}
+
+	//약한 참조로 등록한다 : 옵저버가 소멸되면 자동으로 구독이 끝난다
+	//(다른 곳에서 옵저버를 놓아주면 다음 통보 때 정리된다)
+	//돌려주는 토큰으로 먼저 해제할 수도 있다. 소멸로만 끝내려면 토큰을 detach() 한다
+	[[nodiscard]] Subscription registerWeakObserver(const shared_ptr<IObserver>& pObserver, uint32_t interestMask = ALL_FIELDS) {
+		return Subscription(_registry, _registry->insertWeak(pObserver, interestMask));
+	}
+
+	//필드별 불감대를 지정한다 (변경 감지가 꺼져 있으면 켠다)
+	void setDeadBand(SensorField field, DeadBand deadBand) {
+		_changeDetector.setDeadBand(field, deadBand);
+		if (!_changeDetection) {
+			setChangeDetection(true);
+		}
+	}
+
+	//true 이면 바뀐 필드가 없는 측정값은 알리지 않는다
+	//기본은 꺼져 있어 모든 측정값을 모든 옵저버에게 알린다 (기록, 통계처럼 측정값을 빠짐없이 받아야 하는 옵저버가 있다)
+	void setChangeDetection(bool enabled) {
+		_changeDetection = enabled;
+		_changeDetector.reset();
+	}
+
+	//옵저버 제거
+	void removeObserver(Subscription& subscription) override {
+		subscription.release();
+	}
+
+	//변경 사실을 알린다 : 모든 필드가 바뀐 것으로 보고 알린다
+	void notifyObserver() override {
+		notifyChangedFields(ALL_FIELDS);
+	}
+
+	//changedFields 가 바뀐 측정값을 알린다 : 바뀐 필드에 관심 있고 조건을 만족하는 옵저버만 받는다 (콜백은 모두 받는다)
+	void notifyChangedFields(uint32_t changedFields) {
+		const SensorData& sensorData = _sensorData;
+		uint64_t callCount = 0;
+		_registry->forEachMatching(changedFields, sensorData, [&sensorData, &callCount](IObserver& observer) {
+			observer.update(sensorData);
+			callCount++;
+		});
+		_observerCallCount += callCount;
+		_callbacks->notify(sensorData);
+	}
+
+	size_t getObserverCount() const {
+		return _registry->size() + _callbacks->size();
+	}
+
+	uint64_t getReadingCount() const {
+		return _readingCount;
+	}
+
+	uint64_t getSuppressedCount() const {
+		return _suppressedCount;
+	}
+
+	uint64_t getObserverCallCount() const {
+		return _observerCallCount;
+	}
+
+	//소멸된 것을 발견해서 정리한 약한 참조 옵저버 수
+	uint64_t getPrunedObserverCount() const {
+		return _registry->getPrunedCount();
+	}
+
+	//등록할 수를 미리 알면 배열 재할당을 피한다
+	void reserveObservers(size_t count) {
+		_registry->reserve(count);
+		_callbacks->reserve(count);
+	}
+
+	//여러 측정값을 옵저버마다 한 번에 알린다 (콜백은 하나씩 받는다)
+	void notifyObserverBatch(SensorDataSpan readings) {
+		_registry->forEach([&readings](IObserver& observer) {
+			observer.updateBatch(readings);
+		});
+		for (const SensorData& sensorData : readings) {
+			_callbacks->notify(sensorData);
+		}
+	}
+
+	//이미 수집된 측정값(밀린 기록 등)을 한 번에 전달한다
+	//묶음은 변경 감지 없이 모든 옵저버에게 그대로 전달한다
+	void replayBatch(SensorDataSpan readings) {
+		if (readings.empty()) {
+			return;
+		}
+		_sensorData = readings.back();
+		notifyObserverBatch(readings);
+	}
+
+	float getTemperature() const {
+		return _weatherStation.getTemperature();
+	}
+
+	float getHumidity() const {
+		return _weatherStation.getHumidity();
+	}
+
+	float getPressure() const {
+		return _weatherStation.getPressure();
+	}
+
+	//변경 감지가 켜져 있으면 바뀐 필드가 없을 때 알리지 않는다
+	void measurementsChanged() {
+		_readingCount++;
+		uint32_t changedFields = _changeDetection ? _changeDetector.detect(_sensorData) : ALL_FIELDS;
+		if (changedFields == 0) {
+			_suppressedCount++;
+			return;
+		}
+		notifyChangedFields(changedFields);
+	}
+
+	//외부에서 받은 측정값을 알린다
+	void setMeasurements(const SensorData& sensorData) {
+		_sensorData = sensorData;
+		measurementsChanged();
+	}
+
+	//측정값을 읽어서 알린다 (기록 파일이 끝나면 false)
+	bool readMeasurements() {
+		if (!_weatherStation.read(_sensorData)) {
+			return false;
+		}
+
+		measurementsChanged();
+		return true;
+	}
+
+	//측정값이 끝날 때까지 readMeasurements() 를 반복한다
+	//readingsPerSecond 가 0 이면 최대 속도, 아니면 그 속도에 맞춰 기다린다
+	//(난수 모드는 끝이 없으므로 maxReadings 로 횟수를 제한한다)
+	size_t replay(double readingsPerSecond = 0.0, size_t maxReadings = SIZE_MAX) {
+		auto start = chrono::steady_clock::now();
+		size_t count = 0;
+
+		while (count < maxReadings) {
+			if (readingsPerSecond > 0.0) {
+				this_thread::sleep_until(start + chrono::duration_cast<chrono::steady_clock::duration>(
+					chrono::duration<double>(count / readingsPerSecond)));
+			}
+			if (!readMeasurements()) {
+				break;
+			}
+			count++;
+		}
+		return count;
+	}
+
+	//측정값 count 개를 먼저 모두 읽은 뒤 한 번만 알린다
+	//필드별로 난수를 한꺼번에 만든 뒤 측정값 구조체로 옮긴다
+	void readMeasurementsBatch(size_t count) {
+		if (_weatherStation.isRecording()) {
+			_batch.resize(count);
+			size_t readCount = 0;
+			while (readCount < count && _weatherStation.read(_batch[readCount])) {
+				readCount++;
+			}
+			_batch.resize(readCount);
+			replayBatch(_batch);
+			return;
+		}
+
+		_temperatures.resize(count);
+		_humidities.resize(count);
+		_pressures.resize(count);
+		_weatherStation.fillTemperatures(_temperatures);
+		_weatherStation.fillHumidities(_humidities);
+		_weatherStation.fillPressures(_pressures);
+
+		_batch.resize(count);
+		for (size_t idx = 0; idx < count; idx++) {
+			_batch[idx].temp = _temperatures[idx];
+			_batch[idx].humidity = _humidities[idx];
+			_batch[idx].pressure = _pressures[idx];
+			_batch[idx].temp_top = 0.0f;
+			_batch[idx].temp_bottom = 0.0f;
+		}
+
+		replayBatch(_batch);
+	}
+};
+
+//컴파일할 때 정해진 옵저버들을 값으로 보관하고 직접 호출한다
+//update(const SensorData&) 가 있는 타입이면 되고 IObserver 를 상속하지 않아도 된다
+//타입이 정해져 있으므로 가상 호출이나 shared_ptr 없이 전체 호출이 인라인될 수 있다
+template<typename... Observers>
+class StaticSubject {
+private:
+	tuple<Observers...> _observers;
+
+public:
+	explicit StaticSubject(Observers... observers) : _observers(move(observers)...) {
+	}
+
+	//등록 순서대로 알린다
+	void notifyObserver(const SensorData& sensorData) {
+		apply([&sensorData](Observers&... observers) {
+			(observers.update(sensorData), ...);
+		}, _observers);
+	}
+
+	void notifyObserverBatch(SensorDataSpan readings) {
+		apply([&readings](Observers&... observers) {
+			(observers.updateBatch(readings), ...);
+		}, _observers);
+	}
+
+	template<size_t Index>
+	auto& getObserver() {
+		return get<Index>(_observers);
+	}
+
+	static constexpr size_t getObserverCount() {
+		return sizeof...(Observers);
+	}
+};
+
+//옵저버 구성이 고정된 WeatherData
+template<typename... Observers>
+class StaticWeatherData : public StaticSubject<Observers...> {
+private:
+	WeatherStation _weatherStation;
+	SensorData _sensorData{};
+
+public:
+	explicit StaticWeatherData(Observers... observers) : StaticSubject<Observers...>(move(observers)...) {
+	}
+
+	StaticWeatherData(uint64_t seed, Observers... observers)
+		: StaticSubject<Observers...>(move(observers)...), _weatherStation(seed) {
+	}
+
+	//측정값을 읽어서 알린다 (기록 파일이 끝나면 false)
+	bool readMeasurements() {
+		if (!_weatherStation.read(_sensorData)) {
+			return false;
+		}
+
+		this->notifyObserver(_sensorData);
+		return true;
+	}
+};
+
+
+//할당 횟수 측정용 : 전역 operator new 를 교체해서 호출 횟수를 센다
+static atomic<size_t> g_allocationCount{ 0 };
+
+void* operator new(size_t size) {
+	g_allocationCount.fetch_add(1, memory_order_relaxed);
+	if (void* p = malloc(size == 0 ? 1 : size)) {
+		return p;
+	}
+	throw bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+	free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+	free(p);
+}
+
+//필드 하나만 보는 옵저버 (호출 횟수만 센다)
+class FieldCounter final : public IObserver {
+private:
+	SensorField _field;
+	double _sum = 0.0;
+	uint64_t _count = 0;
+
+public:
+	explicit FieldCounter(SensorField field) : _field(field) {
+	}
+
+	void update(const SensorData& sensorData) override {
+		_sum += getField(sensorData, _field);
+		_count++;
+	}
+
+	uint64_t getCount() const {
+		return _count;
+	}
+};
+
+//천천히 변하는 센서 : 한 번에 한 필드만 가끔씩 0.1 단위로 움직인다
+vector<SensorData> makeSlowReadings(size_t count, uint64_t seed) {
+	FastRandom random(0, 999, seed);
+	vector<SensorData> readings(count);
+	SensorData current{ 20.0f, 50.0f, 1013.0f, 0.0f, 0.0f };
+	for (SensorData& sensorData : readings) {
+		int draw = random.getValue();
+		if (draw < 50) {
+			current.temp += (draw % 2 == 0) ? 0.1f : -0.1f;
+		}
+		else if (draw < 70) {
+			current.humidity += (draw % 2 == 0) ? 0.1f : -0.1f;
+		}
+		else if (draw < 80) {
+			current.pressure += (draw % 2 == 0) ? 0.1f : -0.1f;
+		}
+		sensorData = current;
+	}
+	return readings;
+}
+
+//옵저버 10만 개 : 대부분은 거의 바뀌지 않는 상단/하단 온도만 보고,
+//기온/습도/기압은 각각 1% 만 보며 기온 구독의 절반은 조건(기온 > 20)을 건다
+void benchmarkFieldIndex(size_t observerCount, size_t readingCount) {
+	vector<SensorData> readings = makeSlowReadings(readingCount, 7);
+
+	for (int indexed = 0; indexed < 2; indexed++) {
+		WeatherData weatherData;
+		weatherData.setIndexedDispatch(indexed != 0);
+		weatherData.setChangeDetection(true);
+		weatherData.reserveObservers(observerCount);
+
+		vector<Subscription> subscriptions;
+		subscriptions.reserve(observerCount);
+		for (size_t idx = 0; idx < observerCount; idx++) {
+			size_t bucket = idx % 100;
+			if (bucket == 0) {
+				subscriptions.push_back(weatherData.registerObserver(make_shared<FieldCounter>(SensorField::Temp),
+					whenGreater(SensorField::Temp, 20.0f)));
+				continue;
+			}
+			SensorField field = bucket == 1 ? SensorField::Temp
+				: bucket == 2 ? SensorField::Humidity
+				: bucket == 3 ? SensorField::Pressure
+				: (bucket % 2 == 0 ? SensorField::TempTop : SensorField::TempBottom);
+			subscriptions.push_back(weatherData.registerObserver(make_shared<FieldCounter>(field), fieldMask(field)));
+		}
+
+		auto start = chrono::steady_clock::now();
+		for (const SensorData& sensorData : readings) {
+			weatherData.setMeasurements(sensorData);
+		}
+		auto end = chrono::steady_clock::now();
+
+		uint64_t notified = weatherData.getReadingCount() - weatherData.getSuppressedCount();
+		cout << (indexed ? "필드 색인" : "전체 검사") << " (옵저버 " << observerCount << "개) : "
+			<< "통보 " << notified << "회, update() 호출 " << weatherData.getObserverCallCount()
+			<< ", " << chrono::duration<double, micro>(end - start).count() / max<uint64_t>(notified, 1) << " us/통보" << endl;
+	}
+}
+
+int main() {
+	{
+		//콘솔 출력도 쓰기 스레드가 모아서 한다
+		OutputSink sink(stdout);
+
+		shared_ptr<WeatherData> pWeatherData = make_shared<WeatherData>();
+		pWeatherData->setChangeDetection(true);
+
+		//통계는 기온만, 예보는 기압만 보고, 현재 조건은 기온이 27도를 넘을 때만 보여준다
+		Subscription currentConditionsSubscription = pWeatherData->registerObserver(make_shared<CurrentConditionsDisplay>(sink),
+			whenGreater(SensorField::Temp, 27.0f));
+		Subscription statisticsSubscription = pWeatherData->registerObserver(make_shared<StatisticsDisplay>(sink), fieldMask(SensorField::Temp));
+		Subscription forecastSubscription = pWeatherData->registerObserver(make_shared<ForecastDisplay>(sink), fieldMask(SensorField::Pressure));
+
+		SensorData sensorData{ 25.0f, 60.0f, 30.0f, 0.0f, 0.0f };
+		pWeatherData->setMeasurements(sensorData);
+
+		//기압만 바뀌면 예보만 받는다
+		sensorData.pressure = 29.0f;
+		pWeatherData->setMeasurements(sensorData);
+
+		//기온이 27도를 넘으면 현재 조건과 통계가 받는다
+		sensorData.temp = 28.0f;
+		pWeatherData->setMeasurements(sensorData);
+
+		//cout 과 섞이지 않도록 남은 출력을 먼저 내보낸다
+		sink.flush();
+
+		cout << "update() 호출 " << pWeatherData->getObserverCallCount() << "회" << endl << endl;
+	}
+
+	benchmarkFieldIndex(100000, 100000);
+	return 0;
+}
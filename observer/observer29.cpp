@@ -0,0 +1,3841 @@
+﻿// observer.cpp : 이 파일에는 'main' 함수가 포함됩니다. 거기서 프로그램 실행이 시작되고 종료됩니다.
+//
+
+#include <iostream>
+#include <memory>
+#include <random>
+#include <ctime>
+#include <functional>
+#include <list>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <algorithm>
+#include <thread>
+#include <fstream>
+#include <string>
+#include <cstring>
+#include <stdexcept>
+#include <cstdio>
+#include <mutex>
+#include <condition_variable>
+#include <tuple>
+#include <new>
+#include <type_traits>
+#include <cstddef>
+#include <atomic>
+#include <cstdlib>
+#include <cmath>
+#include <deque>
+#include <limits>
+#include <iterator>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+struct SensorData {
+	float temp;
+	float humidity;
+	float pressure;
+	float temp_top;
+	float temp_bottom;
+};
+
+//측정값 필드 번호
+enum class SensorField {
+	Temp,
+	Humidity,
+	Pressure,
+	TempTop,
+	TempBottom,
+};
+
+static const size_t SENSOR_FIELD_COUNT = 5;
+
+//필드 집합은 비트 마스크로 나타낸다
+static const uint32_t ALL_FIELDS = (1u << SENSOR_FIELD_COUNT) - 1;
+
+inline uint32_t fieldMask(SensorField field) {
+	return 1u << static_cast<uint32_t>(field);
+}
+
+inline float getField(const SensorData& sensorData, SensorField field) {
+	switch (field) {
+	case SensorField::Temp:
+		return sensorData.temp;
+	case SensorField::Humidity:
+		return sensorData.humidity;
+	case SensorField::Pressure:
+		return sensorData.pressure;
+	case SensorField::TempTop:
+		return sensorData.temp_top;
+	default:
+		return sensorData.temp_bottom;
+	}
+}
+
+//필드 값 조건 (예: 기온 > 30)
+enum class Comparison : uint8_t {
+	Always,
+	Greater,
+	Less,
+};
+
+struct FieldPredicate {
+	SensorField field = SensorField::Temp;
+	Comparison comparison = Comparison::Always;
+	float threshold = 0.0f;
+
+	bool test(const SensorData& sensorData) const {
+		switch (comparison) {
+		case Comparison::Greater:
+			return getField(sensorData, field) > threshold;
+		case Comparison::Less:
+			return getField(sensorData, field) < threshold;
+		default:
+			return true;
+		}
+	}
+};
+
+inline FieldPredicate whenGreater(SensorField field, float threshold) {
+	return FieldPredicate{ field, Comparison::Greater, threshold };
+}
+
+inline FieldPredicate whenLess(SensorField field, float threshold) {
+	return FieldPredicate{ field, Comparison::Less, threshold };
+}
+
+//필드별 불감대 : 마지막으로 알린 값에서 이보다 크게 바뀌어야 변경으로 본다
+//absolute 와 relative(마지막 값에 대한 비율) 중 큰 쪽을 쓰고, 둘 다 0 이면 값이 조금이라도 다르면 변경이다
+struct DeadBand {
+	float absolute = 0.0f;
+	float relative = 0.0f;
+};
+
+//측정값이 의미 있게 바뀐 필드를 찾는다
+//기준값은 변경으로 판정된 필드만 갱신하므로 조금씩 움직이는 값도 누적되면 결국 알린다
+class ChangeDetector {
+private:
+	DeadBand _deadBands[SENSOR_FIELD_COUNT];
+	float _reference[SENSOR_FIELD_COUNT] = {};
+	bool _hasReference = false;
+
+public:
+	void setDeadBand(SensorField field, DeadBand deadBand) {
+		_deadBands[static_cast<size_t>(field)] = deadBand;
+	}
+
+	//다음 측정값은 모든 필드가 바뀐 것으로 본다
+	void reset() {
+		_hasReference = false;
+	}
+
+	//바뀐 필드의 마스크를 돌려준다 (0 이면 알릴 필요가 없다)
+	uint32_t detect(const SensorData& sensorData) {
+		uint32_t changedFields = 0;
+		for (size_t idx = 0; idx < SENSOR_FIELD_COUNT; idx++) {
+			float value = getField(sensorData, static_cast<SensorField>(idx));
+			float threshold = max(_deadBands[idx].absolute, _deadBands[idx].relative * fabs(_reference[idx]));
+			float difference = fabs(value - _reference[idx]);
+
+			bool changed = !_hasReference || (threshold > 0.0f ? difference > threshold : value != _reference[idx]);
+			if (changed) {
+				_reference[idx] = value;
+				changedFields |= 1u << idx;
+			}
+		}
+		_hasReference = true;
+		return changedFields;
+	}
+};
+
+//연속된 측정값 묶음을 가리키는 읽기 전용 구간 (복사하지 않는다)
+class SensorDataSpan {
+private:
+	const SensorData* _data;
+	size_t _size;
+
+public:
+	SensorDataSpan(const SensorData* data, size_t size) : _data(data), _size(size) {
+	}
+
+	SensorDataSpan(const vector<SensorData>& readings) : _data(readings.data()), _size(readings.size()) {
+	}
+
+	const SensorData* begin() const {
+		return _data;
+	}
+
+	const SensorData* end() const {
+		return _data + _size;
+	}
+
+	const SensorData& operator[](size_t idx) const {
+		return _data[idx];
+	}
+
+	const SensorData& back() const {
+		return _data[_size - 1];
+	}
+
+	size_t size() const {
+		return _size;
+	}
+
+	bool empty() const {
+		return _size == 0;
+	}
+};
+
+class IObserver {
+public:
+	virtual void update(const SensorData& sensorData) = 0;
+
+	//여러 측정값을 가상 함수 호출 한 번으로 받는다
+	//기본 구현은 하나씩 update() 를 호출하고, 한꺼번에 처리할 수 있는 옵저버는 재정의한다
+	virtual void updateBatch(SensorDataSpan readings) {
+		for (const SensorData& sensorData : readings) {
+			update(sensorData);
+		}
+	}
+};
+
+//측정값을 받는 호출 가능 객체(람다, 멤버 함수 바인딩 등)를 담는 이동 전용 래퍼
+//캡처가 INLINE_SIZE 이하이면 객체 안에 직접 저장하므로 힙 할당이 없다
+//IObserver 와 달리 shared_ptr 이 필요 없어 등록/통보 중에 참조 카운트가 바뀌지 않는다
+class SensorCallback {
+public:
+	static const size_t INLINE_SIZE = 32;
+
+private:
+	struct Operations {
+		void (*invoke)(void* pStorage, const SensorData& sensorData);
+		void (*moveTo)(void* pFrom, void* pTo) noexcept; //pTo 로 옮기고 pFrom 은 소멸시킨다
+		void (*destroy)(void* pStorage) noexcept;
+		bool isInline;
+	};
+
+	//버퍼 안에 직접 저장
+	template<typename Func>
+	struct InlineOperations {
+		static void invoke(void* pStorage, const SensorData& sensorData) {
+			(*static_cast<Func*>(pStorage))(sensorData);
+		}
+		static void moveTo(void* pFrom, void* pTo) noexcept {
+			new (pTo) Func(move(*static_cast<Func*>(pFrom)));
+			static_cast<Func*>(pFrom)->~Func();
+		}
+		static void destroy(void* pStorage) noexcept {
+			static_cast<Func*>(pStorage)->~Func();
+		}
+		static constexpr Operations operations = { &invoke, &moveTo, &destroy, true };
+	};
+
+	//캡처가 크면 힙에 두고 포인터만 저장
+	template<typename Func>
+	struct HeapOperations {
+		static void invoke(void* pStorage, const SensorData& sensorData) {
+			(**static_cast<Func**>(pStorage))(sensorData);
+		}
+		static void moveTo(void* pFrom, void* pTo) noexcept {
+			*static_cast<Func**>(pTo) = *static_cast<Func**>(pFrom);
+		}
+		static void destroy(void* pStorage) noexcept {
+			delete *static_cast<Func**>(pStorage);
+		}
+		static constexpr Operations operations = { &invoke, &moveTo, &destroy, false };
+	};
+
+	template<typename Func>
+	static constexpr bool fitsInline = sizeof(Func) <= INLINE_SIZE
+		&& alignof(Func) <= alignof(max_align_t)
+		&& is_nothrow_move_constructible_v<Func>;
+
+	alignas(max_align_t) unsigned char _storage[INLINE_SIZE];
+	const Operations* _pOperations = nullptr;
+
+public:
+	SensorCallback() = default;
+
+	template<typename Func, typename = enable_if_t<!is_same_v<decay_t<Func>, SensorCallback>>>
+	SensorCallback(Func&& func) {
+		using Stored = decay_t<Func>;
+		if constexpr (fitsInline<Stored>) {
+			new (_storage) Stored(forward<Func>(func));
+			_pOperations = &InlineOperations<Stored>::operations;
+		}
+		else {
+			*reinterpret_cast<Stored**>(_storage) = new Stored(forward<Func>(func));
+			_pOperations = &HeapOperations<Stored>::operations;
+		}
+	}
+
+	SensorCallback(const SensorCallback&) = delete;
+	SensorCallback& operator=(const SensorCallback&) = delete;
+
+	SensorCallback(SensorCallback&& r) noexcept : _pOperations(r._pOperations) {
+		if (_pOperations != nullptr) {
+			_pOperations->moveTo(r._storage, _storage);
+			r._pOperations = nullptr;
+		}
+	}
+
+	SensorCallback& operator=(SensorCallback&& r) noexcept {
+		if (this != &r) {
+			reset();
+			if (r._pOperations != nullptr) {
+				r._pOperations->moveTo(r._storage, _storage);
+				_pOperations = r._pOperations;
+				r._pOperations = nullptr;
+			}
+		}
+		return *this;
+	}
+
+	~SensorCallback() {
+		reset();
+	}
+
+	void reset() {
+		if (_pOperations != nullptr) {
+			const Operations* pOperations = _pOperations;
+			_pOperations = nullptr;
+			pOperations->destroy(_storage);
+		}
+	}
+
+	explicit operator bool() const {
+		return _pOperations != nullptr;
+	}
+
+	//힙 할당 없이 저장되었는지
+	bool isInline() const {
+		return _pOperations != nullptr && _pOperations->isInline;
+	}
+
+	void operator()(const SensorData& sensorData) {
+		_pOperations->invoke(_storage, sensorData);
+	}
+};
+
+//객체의 멤버 함수를 콜백으로 묶는다 (객체는 구독이 끝날 때까지 살아 있어야 한다)
+template<typename T, typename Method>
+SensorCallback bindMember(T& object, Method method) {
+	return SensorCallback([pObject = &object, method](const SensorData& sensorData) {
+		(pObject->*method)(sensorData);
+	});
+}
+
+//등록된 옵저버를 가리키는 핸들 (슬롯 번호 + 세대)
+//제거된 뒤 같은 슬롯이 재사용되면 세대가 달라지므로 예전 핸들은 무효가 된다
+struct ObserverHandle {
+	uint32_t index = UINT32_MAX;
+	uint32_t generation = 0;
+};
+
+//구독 토큰이 가리키는 저장소 (옵저버 저장소와 콜백 저장소가 같은 토큰을 쓴다)
+//구독을 해제할 때만 불리므로 통보 경로에는 가상 호출이 늘지 않는다
+class IRegistry {
+public:
+	virtual ~IRegistry() = default;
+	virtual bool contains(ObserverHandle handle) const = 0;
+	virtual bool erase(ObserverHandle handle) = 0;
+};
+
+//슬롯맵(slot map) 방식의 옵저버 저장소
+//제거는 핸들로 O(1) 에 처리하고 빈칸은 표시만 해 둔다
+//
+//통보 도중(update() 안)에 등록/제거가 일어나도 안전하도록 구조 변경은 미뤄 둔다
+// - 등록 : 배열 끝에 추가되므로 이번 통보에서는 보이지 않고 다음 통보부터 받는다
+// - 제거 : 빈칸으로 표시만 하고 옵저버 객체도 통보가 끝날 때까지 놓아주지 않는다
+// - 정리(compact) : 가장 바깥 통보가 끝난 뒤에 한 번만 한다
+//목록을 복사하지 않으므로 평상시 통보 경로에서는 메모리 할당이 전혀 없다
+//
+//약한 참조로 등록한 옵저버는 소멸되면 통보 중에 발견하는 즉시 빈칸으로 표시하고
+//통보가 끝날 때 정리하므로 따로 목록을 훑지 않는다 (통보 한 번에 O(1) 씩 분할 상환)
+//
+//필드 -> 관심 옵저버 핸들의 역색인을 함께 유지한다
+//바뀐 필드에 관심 있는 옵저버가 전체보다 적으면 색인만 돌고, 많으면 배열 전체를 훑는다
+//색인은 핸들(슬롯 + 세대)을 저장하므로 정리로 배열 위치가 바뀌어도 다시 만들 필요가 없다
+//(제거된 핸들은 세대가 달라져 건너뛰고, 정리할 때 함께 지운다)
+class ObserverRegistry : public IRegistry {
+private:
+	static const uint32_t INVALID_INDEX = UINT32_MAX;
+
+	struct Slot {
+		uint32_t denseIndex; //_observers 안의 위치 (INVALID_INDEX 이면 빈 슬롯)
+		uint32_t generation; //슬롯 재사용 횟수
+	};
+
+	vector<IObserver*> _observers;         //통보할 때 순회하는 연속 배열 (정리 전에는 nullptr 빈칸이 있을 수 있다)
+	vector<shared_ptr<IObserver>> _owners; //수명 유지용 (약한 참조 옵저버는 비어 있다)
+	vector<weak_ptr<IObserver>> _weakOwners; //약한 참조로 등록한 옵저버 (강한 참조 옵저버는 비어 있다)
+	vector<uint32_t> _interestMasks;       //옵저버가 관심 있는 필드 (통보할 때 함께 읽는다)
+	vector<FieldPredicate> _predicates;    //옵저버가 받을 조건
+	vector<ObserverHandle> _fieldIndex[SENSOR_FIELD_COUNT]; //필드 -> 관심 옵저버 (등록 순서)
+	vector<uint32_t> _visitStamps;         //여러 필드가 바뀐 통보에서 같은 옵저버를 두 번 부르지 않도록 슬롯별로 표시
+	uint32_t _visitSerial = 0;
+	bool _indexedDispatch = true;
+	vector<uint32_t> _denseToSlot;         //_observers 위치 -> 슬롯 번호
+	vector<Slot> _slots;                   //핸들 -> _observers 위치
+	vector<uint32_t> _freeSlots;           //재사용할 빈 슬롯 번호
+	vector<shared_ptr<IObserver>> _released; //정리 중에 놓아줄 옵저버 (용량은 재사용한다)
+	size_t _holeCount = 0;                 //정리되지 않은 빈칸 수
+	int _dispatchDepth = 0;                //진행 중인 통보 깊이 (update() 안에서 다시 통보할 수 있다)
+	size_t _weakCount = 0;                 //약한 참조 옵저버 수 (0 이면 통보 경로가 기존과 같다)
+	uint64_t _prunedCount = 0;             //소멸된 것을 발견해서 정리한 약한 참조 옵저버 수
+
+	//예외가 나도 통보 깊이가 복구되도록 한다
+	class DispatchScope {
+	private:
+		ObserverRegistry& _registry;
+
+	public:
+		DispatchScope(ObserverRegistry& registry) : _registry(registry) {
+			_registry._dispatchDepth++;
+		}
+
+		~DispatchScope() {
+			if (--_registry._dispatchDepth == 0) {
+				_registry.compact();
+			}
+		}
+	};
+
+public:
+	void reserve(size_t count) {
+		_observers.reserve(count);
+		_owners.reserve(count);
+		_weakOwners.reserve(count);
+		_interestMasks.reserve(count);
+		_predicates.reserve(count);
+		_denseToSlot.reserve(count);
+		_slots.reserve(count);
+	}
+
+	size_t size() const {
+		return _observers.size() - _holeCount;
+	}
+
+	bool isDispatching() const {
+		return _dispatchDepth > 0;
+	}
+
+	size_t getWeakCount() const {
+		return _weakCount;
+	}
+
+	uint64_t getPrunedCount() const {
+		return _prunedCount;
+	}
+
+	//false 이면 색인을 쓰지 않고 항상 배열 전체를 훑는다 (비교용)
+	void setIndexedDispatch(bool enabled) {
+		_indexedDispatch = enabled;
+	}
+
+	//배열 끝에 추가한다 : O(1)
+	//interestMask 의 필드 중 하나라도 바뀌었을 때만 통보한다
+	ObserverHandle insert(shared_ptr<IObserver> pObserver, uint32_t interestMask = ALL_FIELDS) {
+		IObserver* pRaw = pObserver.get();
+		return insertEntry(pRaw, move(pObserver), weak_ptr<IObserver>(), interestMask, FieldPredicate());
+	}
+
+	//조건을 만족하는 측정값만 받는다 (조건의 필드가 바뀌었을 때만 검사한다)
+	ObserverHandle insert(shared_ptr<IObserver> pObserver, const FieldPredicate& predicate) {
+		IObserver* pRaw = pObserver.get();
+		return insertEntry(pRaw, move(pObserver), weak_ptr<IObserver>(), fieldMask(predicate.field), predicate);
+	}
+
+	//약한 참조로 추가한다 : 옵저버의 수명은 등록과 상관없이 다른 곳에서 정해진다
+	ObserverHandle insertWeak(const shared_ptr<IObserver>& pObserver, uint32_t interestMask = ALL_FIELDS) {
+		_weakCount++;
+		return insertEntry(pObserver.get(), nullptr, pObserver, interestMask, FieldPredicate());
+	}
+
+private:
+	ObserverHandle insertEntry(IObserver* pRaw, shared_ptr<IObserver> pOwner, weak_ptr<IObserver> pWeakOwner,
+		uint32_t interestMask, const FieldPredicate& predicate) {
+		uint32_t slotIndex;
+		if (_freeSlots.empty()) {
+			slotIndex = static_cast<uint32_t>(_slots.size());
+			_slots.push_back(Slot{ INVALID_INDEX, 0 });
+			_visitStamps.push_back(0);
+		}
+		else {
+			slotIndex = _freeSlots.back();
+			_freeSlots.pop_back();
+		}
+
+		Slot& slot = _slots[slotIndex];
+		slot.denseIndex = static_cast<uint32_t>(_observers.size());
+
+		_observers.push_back(pRaw);
+		_owners.push_back(move(pOwner));
+		_weakOwners.push_back(move(pWeakOwner));
+		_interestMasks.push_back(interestMask);
+		_predicates.push_back(predicate);
+		_denseToSlot.push_back(slotIndex);
+
+		ObserverHandle handle{ slotIndex, slot.generation };
+		for (size_t field = 0; field < SENSOR_FIELD_COUNT; field++) {
+			if (interestMask & (1u << field)) {
+				_fieldIndex[field].push_back(handle);
+			}
+		}
+		return handle;
+	}
+
+	bool isLive(ObserverHandle handle) const {
+		const Slot& slot = _slots[handle.index];
+		return slot.denseIndex != INVALID_INDEX && slot.generation == handle.generation;
+	}
+
+	//옵저버 하나를 부를지 확인하고 부른다
+	template <typename Func>
+	void visit(size_t denseIndex, const SensorData& sensorData, Func& func) {
+		IObserver* pObserver = _observers[denseIndex];
+		if (pObserver == nullptr || !_predicates[denseIndex].test(sensorData)) {
+			return;
+		}
+		if (_owners[denseIndex]) {
+			func(*pObserver);
+			return;
+		}
+		//약한 참조 옵저버는 update() 가 끝날 때까지 붙잡아 둔다
+		shared_ptr<IObserver> pPinned = _weakOwners[denseIndex].lock();
+		if (!pPinned) {
+			pruneAt(denseIndex);
+			return;
+		}
+		func(*pPinned);
+	}
+
+	//소멸된 약한 참조 옵저버를 빈칸으로 표시한다
+	void pruneAt(size_t denseIndex) {
+		uint32_t slotIndex = _denseToSlot[denseIndex];
+		erase(ObserverHandle{ slotIndex, _slots[slotIndex].generation });
+		_prunedCount++;
+	}
+
+public:
+
+	bool contains(ObserverHandle handle) const override {
+		return handle.index < _slots.size()
+			&& _slots[handle.index].denseIndex != INVALID_INDEX
+			&& _slots[handle.index].generation == handle.generation;
+	}
+
+	//빈칸으로 표시만 한다 : O(1)
+	//통보 중이면 update() 가 아직 실행 중일 수 있으므로 옵저버 객체는 정리할 때 놓아준다
+	bool erase(ObserverHandle handle) override {
+		if (!contains(handle)) {
+			return false;
+		}
+
+		Slot& slot = _slots[handle.index];
+		uint32_t denseIndex = slot.denseIndex;
+		_observers[denseIndex] = nullptr;
+		_holeCount++;
+		if (!_owners[denseIndex]) {
+			_weakCount--;
+		}
+
+		slot.denseIndex = INVALID_INDEX;
+		slot.generation++;
+		_freeSlots.push_back(handle.index);
+
+		if (!isDispatching()) {
+			_owners[denseIndex].reset();
+		}
+		_weakOwners[denseIndex].reset();
+		return true;
+	}
+
+	//빈칸을 제거하고 남은 옵저버를 앞으로 당긴다 (등록 순서 유지)
+	//통보 중에는 아무 일도 하지 않고 가장 바깥 통보가 끝날 때 다시 불린다
+	void compact() {
+		if (_holeCount == 0 || isDispatching()) {
+			return;
+		}
+
+		size_t writeIndex = 0;
+		for (size_t readIndex = 0; readIndex < _observers.size(); readIndex++) {
+			if (_observers[readIndex] == nullptr) {
+				if (_owners[readIndex]) {
+					_released.push_back(move(_owners[readIndex]));
+				}
+				continue;
+			}
+			if (writeIndex != readIndex) {
+				_observers[writeIndex] = _observers[readIndex];
+				_owners[writeIndex] = move(_owners[readIndex]);
+				_weakOwners[writeIndex] = move(_weakOwners[readIndex]);
+				_interestMasks[writeIndex] = _interestMasks[readIndex];
+				_predicates[writeIndex] = _predicates[readIndex];
+				_denseToSlot[writeIndex] = _denseToSlot[readIndex];
+				_slots[_denseToSlot[writeIndex]].denseIndex = static_cast<uint32_t>(writeIndex);
+			}
+			writeIndex++;
+		}
+
+		_observers.resize(writeIndex);
+		_owners.resize(writeIndex);
+		_weakOwners.resize(writeIndex);
+		_interestMasks.resize(writeIndex);
+		_predicates.resize(writeIndex);
+		_denseToSlot.resize(writeIndex);
+		_holeCount = 0;
+
+		//제거된 옵저버의 핸들을 색인에서 지운다 (순서 유지)
+		for (vector<ObserverHandle>& handles : _fieldIndex) {
+			handles.erase(remove_if(handles.begin(), handles.end(), [this](ObserverHandle handle) {
+				return !isLive(handle);
+			}), handles.end());
+		}
+
+		//옵저버 소멸자가 다시 등록/제거를 해도 되도록 배열 정리가 끝난 뒤에 놓아준다
+		_released.clear();
+	}
+
+	//통보 시작 시점의 옵저버만 순회한다
+	//배열이 재할당될 수 있으므로 반복자 대신 위치로 접근하고, 도중에 생긴 빈칸은 건너뛴다
+	template <typename Func>
+	void forEach(Func&& func) {
+		forEachInterested(ALL_FIELDS, forward<Func>(func));
+	}
+
+	//changedFields 중 하나라도 관심 있는 옵저버만 순회한다 (조건은 보지 않는다)
+	template <typename Func>
+	void forEachInterested(uint32_t changedFields, Func&& func) {
+		compact();
+		DispatchScope scope(*this);
+
+		const size_t count = _observers.size();
+		if (_weakCount == 0) {
+			for (size_t idx = 0; idx < count; idx++) {
+				IObserver* pObserver = _observers[idx];
+				if (pObserver != nullptr && (_interestMasks[idx] & changedFields) != 0) {
+					func(*pObserver);
+				}
+			}
+			return;
+		}
+
+		//약한 참조 옵저버는 lock() 으로 붙잡은 채 부른다 : 다른 스레드나 update() 안에서 마지막 소유자가 놓아주어도
+		//update() 가 끝날 때까지 살아 있다 (참조 카운트 증감은 약한 참조 옵저버에만 든다)
+		for (size_t idx = 0; idx < count; idx++) {
+			IObserver* pObserver = _observers[idx];
+			if (pObserver == nullptr || (_interestMasks[idx] & changedFields) == 0) {
+				continue;
+			}
+			if (_owners[idx]) {
+				func(*pObserver);
+				continue;
+			}
+			shared_ptr<IObserver> pPinned = _weakOwners[idx].lock();
+			if (!pPinned) {
+				pruneAt(idx);
+				continue;
+			}
+			func(*pPinned);
+		}
+	}
+
+	//changedFields 중 하나라도 관심 있고 조건도 만족하는 옵저버만 순회한다
+	//바뀐 필드의 색인 크기 합이 전체보다 작을 때만 색인을 쓴다
+	//색인을 돌 때는 필드 순서대로 부르므로 여러 필드에 관심 있는 옵저버끼리는 등록 순서가 바뀔 수 있다
+	template <typename Func>
+	void forEachMatching(uint32_t changedFields, const SensorData& sensorData, Func&& func) {
+		compact();
+		DispatchScope scope(*this);
+
+		size_t indexedCount = 0;
+		for (size_t field = 0; field < SENSOR_FIELD_COUNT; field++) {
+			if (changedFields & (1u << field)) {
+				indexedCount += _fieldIndex[field].size();
+			}
+		}
+
+		if (!_indexedDispatch || indexedCount >= _observers.size()) {
+			const size_t count = _observers.size();
+			for (size_t idx = 0; idx < count; idx++) {
+				if ((_interestMasks[idx] & changedFields) != 0) {
+					visit(idx, sensorData, func);
+				}
+			}
+			return;
+		}
+
+		const bool multipleFields = (changedFields & (changedFields - 1)) != 0;
+		if (multipleFields && ++_visitSerial == 0) {
+			fill(_visitStamps.begin(), _visitStamps.end(), 0);
+			_visitSerial = 1;
+		}
+
+		//도중에 등록된 옵저버는 통보 시작 시점의 색인 길이 뒤에 붙으므로 이번에는 보이지 않는다
+		for (size_t field = 0; field < SENSOR_FIELD_COUNT; field++) {
+			if ((changedFields & (1u << field)) == 0) {
+				continue;
+			}
+
+			const size_t count = _fieldIndex[field].size();
+			for (size_t idx = 0; idx < count; idx++) {
+				ObserverHandle handle = _fieldIndex[field][idx];
+				if (!isLive(handle)) {
+					continue;
+				}
+				if (multipleFields) {
+					if (_visitStamps[handle.index] == _visitSerial) {
+						continue;
+					}
+					_visitStamps[handle.index] = _visitSerial;
+				}
+				visit(_slots[handle.index].denseIndex, sensorData, func);
+			}
+		}
+	}
+};
+
+//콜백을 값으로 저장하는 슬롯맵 (ObserverRegistry 와 같은 핸들/지연 정리 규칙)
+//콜백은 배열 안에서 실행되므로 통보 중에 배열이 재할당되면 안 된다
+//그래서 통보 중에 등록된 콜백은 _pending 에 모았다가 가장 바깥 통보가 끝난 뒤에 옮긴다
+class CallbackRegistry : public IRegistry {
+private:
+	static const uint32_t INVALID_INDEX = UINT32_MAX;
+
+	struct Slot {
+		uint32_t denseIndex; //_callbacks 안의 위치, _callbacks.size() 이상이면 _pending 안의 위치
+		uint32_t generation;
+	};
+
+	vector<SensorCallback> _callbacks;  //통보할 때 순회하는 연속 배열
+	vector<uint32_t> _denseToSlot;      //_callbacks 위치 -> 슬롯 번호 (INVALID_INDEX 이면 빈칸)
+	vector<SensorCallback> _pending;    //통보 중에 등록된 콜백
+	vector<uint32_t> _pendingToSlot;
+	vector<Slot> _slots;
+	vector<uint32_t> _freeSlots;
+	vector<SensorCallback> _released;   //정리 중에 소멸시킬 콜백 (용량은 재사용한다)
+	size_t _holeCount = 0;
+	int _dispatchDepth = 0;
+
+	class DispatchScope {
+	private:
+		CallbackRegistry& _registry;
+
+	public:
+		DispatchScope(CallbackRegistry& registry) : _registry(registry) {
+			_registry._dispatchDepth++;
+		}
+
+		~DispatchScope() {
+			if (--_registry._dispatchDepth == 0) {
+				_registry.compact();
+			}
+		}
+	};
+
+public:
+	void reserve(size_t count) {
+		_callbacks.reserve(count);
+		_denseToSlot.reserve(count);
+		_slots.reserve(count);
+	}
+
+	size_t size() const {
+		size_t pendingCount = 0;
+		for (uint32_t slotIndex : _pendingToSlot) {
+			if (slotIndex != INVALID_INDEX) {
+				pendingCount++;
+			}
+		}
+		return _callbacks.size() - _holeCount + pendingCount;
+	}
+
+	bool isDispatching() const {
+		return _dispatchDepth > 0;
+	}
+
+	ObserverHandle insert(SensorCallback callback) {
+		uint32_t slotIndex;
+		if (_freeSlots.empty()) {
+			slotIndex = static_cast<uint32_t>(_slots.size());
+			_slots.push_back(Slot{ INVALID_INDEX, 0 });
+		}
+		else {
+			slotIndex = _freeSlots.back();
+			_freeSlots.pop_back();
+		}
+
+		Slot& slot = _slots[slotIndex];
+		if (isDispatching()) {
+			slot.denseIndex = static_cast<uint32_t>(_callbacks.size() + _pending.size());
+			_pending.push_back(move(callback));
+			_pendingToSlot.push_back(slotIndex);
+		}
+		else {
+			slot.denseIndex = static_cast<uint32_t>(_callbacks.size());
+			_callbacks.push_back(move(callback));
+			_denseToSlot.push_back(slotIndex);
+		}
+
+		return ObserverHandle{ slotIndex, slot.generation };
+	}
+
+	bool contains(ObserverHandle handle) const override {
+		return handle.index < _slots.size()
+			&& _slots[handle.index].denseIndex != INVALID_INDEX
+			&& _slots[handle.index].generation == handle.generation;
+	}
+
+	//통보 중이면 실행 중일 수 있으므로 콜백은 정리할 때 소멸시킨다
+	bool erase(ObserverHandle handle) override {
+		if (!contains(handle)) {
+			return false;
+		}
+
+		Slot& slot = _slots[handle.index];
+		uint32_t denseIndex = slot.denseIndex;
+		if (denseIndex < _callbacks.size()) {
+			_denseToSlot[denseIndex] = INVALID_INDEX;
+			_holeCount++;
+			if (!isDispatching()) {
+				_callbacks[denseIndex].reset();
+			}
+		}
+		else {
+			_pendingToSlot[denseIndex - _callbacks.size()] = INVALID_INDEX;
+		}
+
+		slot.denseIndex = INVALID_INDEX;
+		slot.generation++;
+		_freeSlots.push_back(handle.index);
+		return true;
+	}
+
+	//빈칸을 제거하고 통보 중에 등록된 콜백을 뒤에 붙인다 (등록 순서 유지)
+	void compact() {
+		if (isDispatching() || (_holeCount == 0 && _pending.empty())) {
+			return;
+		}
+
+		size_t writeIndex = 0;
+		for (size_t readIndex = 0; readIndex < _callbacks.size(); readIndex++) {
+			if (_denseToSlot[readIndex] == INVALID_INDEX) {
+				if (_callbacks[readIndex]) {
+					_released.push_back(move(_callbacks[readIndex]));
+				}
+				continue;
+			}
+			if (writeIndex != readIndex) {
+				_callbacks[writeIndex] = move(_callbacks[readIndex]);
+				_denseToSlot[writeIndex] = _denseToSlot[readIndex];
+				_slots[_denseToSlot[writeIndex]].denseIndex = static_cast<uint32_t>(writeIndex);
+			}
+			writeIndex++;
+		}
+		_callbacks.resize(writeIndex);
+		_denseToSlot.resize(writeIndex);
+		_holeCount = 0;
+
+		for (size_t idx = 0; idx < _pending.size(); idx++) {
+			uint32_t slotIndex = _pendingToSlot[idx];
+			if (slotIndex == INVALID_INDEX) {
+				_released.push_back(move(_pending[idx]));
+				continue;
+			}
+			_slots[slotIndex].denseIndex = static_cast<uint32_t>(_callbacks.size());
+			_callbacks.push_back(move(_pending[idx]));
+			_denseToSlot.push_back(slotIndex);
+		}
+		_pending.clear();
+		_pendingToSlot.clear();
+
+		//콜백 소멸자가 다시 등록/제거를 해도 되도록 배열 정리가 끝난 뒤에 소멸시킨다
+		_released.clear();
+	}
+
+	//통보 시작 시점의 콜백만 호출한다
+	void notify(const SensorData& sensorData) {
+		compact();
+		DispatchScope scope(*this);
+
+		const size_t count = _callbacks.size();
+		for (size_t idx = 0; idx < count; idx++) {
+			if (_denseToSlot[idx] != INVALID_INDEX) {
+				_callbacks[idx](sensorData);
+			}
+		}
+	}
+};
+
+//registerObserver() 가 돌려주는 구독 토큰
+//토큰이 소멸되거나 release() 를 호출하면 O(1) 로 구독이 해제된다
+//주제 객체가 먼저 사라져도 안전하도록 저장소는 weak_ptr 로 가리킨다
+class Subscription {
+private:
+	weak_ptr<IRegistry> _registry;
+	ObserverHandle _handle;
+
+public:
+	Subscription() = default;
+
+	Subscription(weak_ptr<IRegistry> registry, ObserverHandle handle)
+		: _registry(move(registry)), _handle(handle) {
+	}
+
+	Subscription(const Subscription&) = delete;
+	Subscription& operator=(const Subscription&) = delete;
+
+	Subscription(Subscription&& r) noexcept
+		: _registry(move(r._registry)), _handle(r._handle) {
+		r._registry.reset();
+	}
+
+	Subscription& operator=(Subscription&& r) noexcept {
+		if (this != &r) {
+			release();
+			_registry = move(r._registry);
+			_handle = r._handle;
+			r._registry.reset();
+		}
+		return *this;
+	}
+
+	~Subscription() {
+		release();
+	}
+
+	//구독 해제
+	void release() {
+		if (shared_ptr<IRegistry> pRegistry = _registry.lock()) {
+			pRegistry->erase(_handle);
+		}
+		_registry.reset();
+	}
+
+	//토큰과의 연결만 끊고 구독은 주제 객체가 사라질 때까지 유지한다
+	void detach() {
+		_registry.reset();
+	}
+
+	bool isActive() const {
+		shared_ptr<IRegistry> pRegistry = _registry.lock();
+		return pRegistry && pRegistry->contains(_handle);
+	}
+};
+
+class ISubject {
+
+public:
+	//옵저버 등록 : 반환된 토큰이 살아있는 동안만 구독이 유지된다
+	[[nodiscard]] virtual Subscription registerObserver(shared_ptr<IObserver> pObserver) = 0;
+
+	//옵저버 제거
+	virtual void removeObserver(Subscription& subscription) = 0;
+
+	//변경 사실을 알린다
+	virtual void notifyObserver() = 0;
+};
+
+
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define FAST_RANDOM_SSE2 1
+#include <emmintrin.h>
+#endif
+
+//쓰기 가능한 float 연속 구간 (복사하지 않는다)
+class FloatSpan {
+private:
+	float* _data;
+	size_t _size;
+
+public:
+	FloatSpan(float* data, size_t size) : _data(data), _size(size) {
+	}
+
+	FloatSpan(vector<float>& values) : _data(values.data()), _size(values.size()) {
+	}
+
+	float* data() const {
+		return _data;
+	}
+
+	size_t size() const {
+		return _size;
+	}
+};
+
+//빠르고 작은 난수 생성기
+//xoshiro128** 4개를 나란히 돌려서 한 번에 4개씩 만든다 (상태 64바이트, mt19937 은 약 5KB)
+//같은 시드면 항상 같은 수열이 나오고, getValue() 로 하나씩 꺼내든 fill() 로 한꺼번에 채우든
+//SSE2 가 있든 없든 같은 순서로 같은 값이 나온다
+class FastRandom {
+private:
+	static const int LANES = 4;
+
+	uint32_t _state[4][LANES]; //[상태 워드][레인] : SIMD 레지스터에 바로 올릴 수 있는 배치
+	uint32_t _buffer[LANES];   //getValue() 용으로 미리 만들어 둔 값
+	int _bufferPos = LANES;
+	int _from;
+	uint32_t _range;           //to - from + 1
+
+	static uint64_t splitMix64(uint64_t& x) {
+		uint64_t z = (x += 0x9E3779B97F4A7C15ull);
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+		return z ^ (z >> 31);
+	}
+
+	static uint32_t rotl(uint32_t x, int k) {
+		return (x << k) | (x >> (32 - k));
+	}
+
+	//32비트 난수를 [0, range) 로 옮긴다 (곱셈 상위 32비트 방식, 나머지 연산 없음)
+	uint32_t toIndex(uint32_t bits) const {
+		return static_cast<uint32_t>((static_cast<uint64_t>(bits) * _range) >> 32);
+	}
+
+	//레인 4개를 한 단계씩 진행한다 (스칼라 기준 구현)
+	void next4(uint32_t out[LANES]) {
+		for (int lane = 0; lane < LANES; lane++) {
+			uint32_t s0 = _state[0][lane];
+			uint32_t s1 = _state[1][lane];
+			uint32_t s2 = _state[2][lane];
+			uint32_t s3 = _state[3][lane];
+
+			out[lane] = rotl(s1 * 5, 7) * 9;
+
+			uint32_t t = s1 << 9;
+			s2 ^= s0;
+			s3 ^= s1;
+			s1 ^= s2;
+			s0 ^= s3;
+			s2 ^= t;
+			s3 = rotl(s3, 11);
+
+			_state[0][lane] = s0;
+			_state[1][lane] = s1;
+			_state[2][lane] = s2;
+			_state[3][lane] = s3;
+		}
+	}
+
+public:
+	FastRandom(int from, int to, uint64_t seed) : _from(from), _range(static_cast<uint32_t>(to - from + 1)) {
+		//0 상태가 되지 않도록 splitmix64 로 시드를 펼친다
+		for (int lane = 0; lane < LANES; lane++) {
+			for (int word = 0; word < 4; word += 2) {
+				uint64_t z = splitMix64(seed);
+				_state[word][lane] = static_cast<uint32_t>(z);
+				_state[word + 1][lane] = static_cast<uint32_t>(z >> 32);
+			}
+		}
+	}
+
+	int getValue() {
+		if (_bufferPos == LANES) {
+			next4(_buffer);
+			_bufferPos = 0;
+		}
+		return _from + static_cast<int>(toIndex(_buffer[_bufferPos++]));
+	}
+
+	//out[i] = base + getValue() / divisor 를 한꺼번에 채운다
+	void fill(FloatSpan out, float base, float divisor) {
+		float* data = out.data();
+		size_t count = out.size();
+		size_t idx = 0;
+
+		//버퍼에 남은 값부터 써서 getValue() 와 같은 순서를 유지한다
+		for (; idx < count && _bufferPos < LANES; idx++) {
+			data[idx] = base + static_cast<float>(getValue()) / divisor;
+		}
+
+#ifdef FAST_RANDOM_SSE2
+		__m128i s0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(_state[0]));
+		__m128i s1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(_state[1]));
+		__m128i s2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(_state[2]));
+		__m128i s3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(_state[3]));
+		const __m128i range = _mm_set1_epi32(static_cast<int>(_range));
+		const __m128i from = _mm_set1_epi32(_from);
+		const __m128i oddMask = _mm_set_epi32(-1, 0, -1, 0);
+		const __m128 baseV = _mm_set1_ps(base);
+		const __m128 divisorV = _mm_set1_ps(divisor);
+
+		for (; idx + LANES <= count; idx += LANES) {
+			//rotl(s1 * 5, 7) * 9 : 곱셈을 시프트와 덧셈으로 바꾼다
+			__m128i x = _mm_add_epi32(_mm_slli_epi32(s1, 2), s1);
+			x = _mm_or_si128(_mm_slli_epi32(x, 7), _mm_srli_epi32(x, 25));
+			x = _mm_add_epi32(_mm_slli_epi32(x, 3), x);
+
+			__m128i t = _mm_slli_epi32(s1, 9);
+			s2 = _mm_xor_si128(s2, s0);
+			s3 = _mm_xor_si128(s3, s1);
+			s1 = _mm_xor_si128(s1, s2);
+			s0 = _mm_xor_si128(s0, s3);
+			s2 = _mm_xor_si128(s2, t);
+			s3 = _mm_or_si128(_mm_slli_epi32(s3, 11), _mm_srli_epi32(s3, 21));
+
+			//(x * range) >> 32 : 짝수/홀수 레인을 나눠 64비트 곱을 구한다
+			__m128i even = _mm_srli_epi64(_mm_mul_epu32(x, range), 32);
+			__m128i odd = _mm_and_si128(_mm_mul_epu32(_mm_srli_epi64(x, 32), range), oddMask);
+			__m128i value = _mm_add_epi32(_mm_or_si128(even, odd), from);
+
+			__m128 result = _mm_add_ps(baseV, _mm_div_ps(_mm_cvtepi32_ps(value), divisorV));
+			_mm_storeu_ps(data + idx, result);
+		}
+
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(_state[0]), s0);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(_state[1]), s1);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(_state[2]), s2);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(_state[3]), s3);
+#endif
+
+		for (; idx < count; idx++) {
+			data[idx] = base + static_cast<float>(getValue()) / divisor;
+		}
+	}
+};
+
+
+//읽기 전용으로 메모리에 매핑한 파일
+class MappedFile {
+private:
+#ifdef _WIN32
+	HANDLE _file = INVALID_HANDLE_VALUE;
+	HANDLE _mapping = nullptr;
+#else
+	int _fd = -1;
+#endif
+	const uint8_t* _data = nullptr;
+	size_t _size = 0;
+
+public:
+	explicit MappedFile(const string& path) {
+#ifdef _WIN32
+		_file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (_file == INVALID_HANDLE_VALUE) {
+			throw runtime_error("파일을 열 수 없습니다 : " + path);
+		}
+		LARGE_INTEGER fileSize;
+		if (!GetFileSizeEx(_file, &fileSize)) {
+			CloseHandle(_file);
+			throw runtime_error("파일 크기를 읽을 수 없습니다 : " + path);
+		}
+		_size = static_cast<size_t>(fileSize.QuadPart);
+		if (_size > 0) {
+			_mapping = CreateFileMappingA(_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			if (_mapping == nullptr) {
+				CloseHandle(_file);
+				throw runtime_error("파일을 매핑할 수 없습니다 : " + path);
+			}
+			_data = static_cast<const uint8_t*>(MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0));
+			if (_data == nullptr) {
+				CloseHandle(_mapping);
+				CloseHandle(_file);
+				throw runtime_error("파일을 매핑할 수 없습니다 : " + path);
+			}
+		}
+#else
+		_fd = open(path.c_str(), O_RDONLY);
+		if (_fd < 0) {
+			throw runtime_error("파일을 열 수 없습니다 : " + path);
+		}
+		struct stat fileStat;
+		if (fstat(_fd, &fileStat) != 0) {
+			close(_fd);
+			throw runtime_error("파일 크기를 읽을 수 없습니다 : " + path);
+		}
+		_size = static_cast<size_t>(fileStat.st_size);
+		if (_size > 0) {
+			void* pMapped = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, _fd, 0);
+			if (pMapped == MAP_FAILED) {
+				close(_fd);
+				throw runtime_error("파일을 매핑할 수 없습니다 : " + path);
+			}
+			madvise(pMapped, _size, MADV_SEQUENTIAL);
+			_data = static_cast<const uint8_t*>(pMapped);
+		}
+#endif
+	}
+
+	~MappedFile() {
+#ifdef _WIN32
+		if (_data != nullptr) {
+			UnmapViewOfFile(_data);
+		}
+		if (_mapping != nullptr) {
+			CloseHandle(_mapping);
+		}
+		CloseHandle(_file);
+#else
+		if (_data != nullptr) {
+			munmap(const_cast<uint8_t*>(_data), _size);
+		}
+		close(_fd);
+#endif
+	}
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	const uint8_t* data() const {
+		return _data;
+	}
+
+	size_t size() const {
+		return _size;
+	}
+};
+
+//측정값 기록 파일 머리말
+//머리말 뒤에 SensorData 가 고정 크기로 이어진다 (기록한 장비와 같은 바이트 순서)
+struct RecordingHeader {
+	char magic[8];       //"WXREC01"
+	uint32_t version;
+	uint32_t recordSize; //sizeof(SensorData)
+	uint64_t count;      //측정값 수
+};
+
+static const char RECORDING_MAGIC[8] = { 'W', 'X', 'R', 'E', 'C', '0', '1', '\0' };
+
+//측정값을 기록 파일로 쓴다
+class SensorRecordingWriter {
+private:
+	ofstream _file;
+	uint64_t _count = 0;
+
+public:
+	explicit SensorRecordingWriter(const string& path) : _file(path, ios::binary | ios::trunc) {
+		if (!_file) {
+			throw runtime_error("파일을 만들 수 없습니다 : " + path);
+		}
+		RecordingHeader header{};
+		_file.write(reinterpret_cast<const char*>(&header), sizeof(header)); //개수는 닫을 때 채운다
+	}
+
+	~SensorRecordingWriter() {
+		close();
+	}
+
+	void write(const SensorData& sensorData) {
+		_file.write(reinterpret_cast<const char*>(&sensorData), sizeof(SensorData));
+		_count++;
+	}
+
+	void close() {
+		if (!_file.is_open()) {
+			return;
+		}
+		RecordingHeader header{};
+		memcpy(header.magic, RECORDING_MAGIC, sizeof(header.magic));
+		header.version = 1;
+		header.recordSize = sizeof(SensorData);
+		header.count = _count;
+
+		_file.seekp(0);
+		_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		_file.close();
+	}
+};
+
+//메모리에 매핑한 기록 파일 : 읽을 때 복사나 파일 입출력 호출이 없다
+class SensorRecording {
+private:
+	MappedFile _file;
+	const uint8_t* _records = nullptr;
+	size_t _count = 0;
+
+public:
+	explicit SensorRecording(const string& path) : _file(path) {
+		RecordingHeader header;
+		if (_file.size() < sizeof(header)) {
+			throw runtime_error("기록 파일이 아닙니다 : " + path);
+		}
+		memcpy(&header, _file.data(), sizeof(header));
+		//닫히지 않은 세그먼트 기록은 파일에 있는 만큼만 읽는다
+		if (header.count == UINT64_MAX) {
+			header.count = (_file.size() - sizeof(header)) / sizeof(SensorData);
+		}
+		if (memcmp(header.magic, RECORDING_MAGIC, sizeof(header.magic)) != 0
+			|| header.version != 1
+			|| header.recordSize != sizeof(SensorData)
+			|| header.count > (_file.size() - sizeof(header)) / sizeof(SensorData)) {
+			throw runtime_error("기록 파일 형식이 맞지 않습니다 : " + path);
+		}
+
+		_records = _file.data() + sizeof(header);
+		_count = static_cast<size_t>(header.count);
+	}
+
+	size_t size() const {
+		return _count;
+	}
+
+	SensorData at(size_t index) const {
+		SensorData sensorData;
+		memcpy(&sensorData, _records + index * sizeof(SensorData), sizeof(SensorData));
+		return sensorData;
+	}
+
+	//매핑된 기록 전체 (머리말 뒤는 4바이트 정렬이므로 그대로 SensorData 배열로 본다)
+	SensorDataSpan getRecords() const {
+		return SensorDataSpan(reinterpret_cast<const SensorData*>(_records), _count);
+	}
+};
+
+//세그먼트로 나눈 추가 전용 측정값 기록
+//세그먼트 파일마다 SensorRecording 과 같은 머리말 + SensorData 형식이므로 하나씩 따로 재생할 수도 있다
+//쓰는 중인 세그먼트는 머리말의 개수를 OPEN_SEGMENT_COUNT 로 두고 닫을 때 실제 개수로 고친다
+//(비정상 종료로 닫지 못한 세그먼트는 파일 크기로 개수를 정한다)
+//작은 쓰기를 모아 큰 버퍼 단위로만 파일에 쓴다
+//같은 prefix 로 남아 있던 이전 기록은 만들 때 지운다 (더 길었던 기록의 뒤쪽 세그먼트가 이어서 읽히지 않도록)
+class SegmentedLogWriter {
+private:
+	string _prefix;
+	size_t _recordsPerSegment;
+	vector<char> _buffer;
+	size_t _bufferUsed = 0;
+
+	FILE* _pFile = nullptr;
+	uint32_t _segmentIndex = 0;
+	uint64_t _segmentRecords = 0;
+	uint64_t _totalRecords = 0;
+	uint64_t _bytesWritten = 0;
+
+	void writeHeader(uint64_t count) {
+		RecordingHeader header{};
+		memcpy(header.magic, RECORDING_MAGIC, sizeof(header.magic));
+		header.version = 1;
+		header.recordSize = sizeof(SensorData);
+		header.count = count;
+		if (fwrite(&header, sizeof(header), 1, _pFile) != 1) {
+			failSegment("파일에 쓸 수 없습니다 : ");
+		}
+	}
+
+	//열린 세그먼트를 닫고 버퍼를 버린 뒤 예외를 던진다
+	[[noreturn]] void failSegment(const char* message) {
+		string path = segmentPath(_prefix, _segmentIndex);
+		fclose(_pFile);
+		_pFile = nullptr;
+		_bufferUsed = 0;
+		throw runtime_error(message + path);
+	}
+
+	void openSegment() {
+		string path = segmentPath(_prefix, _segmentIndex);
+		_pFile = fopen(path.c_str(), "wb");
+		if (_pFile == nullptr) {
+			throw runtime_error("파일을 만들 수 없습니다 : " + path);
+		}
+		//버퍼는 직접 관리하므로 stdio 버퍼는 끈다
+		setvbuf(_pFile, nullptr, _IONBF, 0);
+		writeHeader(OPEN_SEGMENT_COUNT);
+		_segmentRecords = 0;
+	}
+
+	void flushBuffer() {
+		if (_bufferUsed == 0) {
+			return;
+		}
+		if (fwrite(_buffer.data(), 1, _bufferUsed, _pFile) != _bufferUsed) {
+			failSegment("파일에 쓸 수 없습니다 : ");
+		}
+		_bytesWritten += _bufferUsed;
+		_bufferUsed = 0;
+	}
+
+	void closeSegment() {
+		if (_pFile == nullptr) {
+			return;
+		}
+		flushBuffer();
+		if (fseek(_pFile, 0, SEEK_SET) != 0) {
+			failSegment("파일 처음으로 돌아갈 수 없습니다 : ");
+		}
+		writeHeader(_segmentRecords);
+		int result = fclose(_pFile);
+		_pFile = nullptr;
+		if (result != 0) {
+			throw runtime_error("파일을 닫을 수 없습니다 : " + segmentPath(_prefix, _segmentIndex));
+		}
+		_segmentIndex++;
+	}
+
+public:
+	static const uint64_t OPEN_SEGMENT_COUNT = UINT64_MAX;
+
+	static string segmentPath(const string& prefix, uint32_t segmentIndex) {
+		char suffix[32];
+		snprintf(suffix, sizeof(suffix), ".%06u.wxlog", segmentIndex);
+		return prefix + suffix;
+	}
+
+	explicit SegmentedLogWriter(const string& prefix, size_t recordsPerSegment = 1 << 20, size_t bufferBytes = 1 << 20)
+		: _prefix(prefix), _recordsPerSegment(max<size_t>(recordsPerSegment, 1))
+		, _buffer(max(bufferBytes, sizeof(SensorData)) / sizeof(SensorData) * sizeof(SensorData)) {
+		//SegmentedLogReader 는 처음 빠진 번호에서 멈추므로 거기까지만 지운다
+		for (uint32_t segmentIndex = 0; remove(segmentPath(_prefix, segmentIndex).c_str()) == 0; segmentIndex++) {
+		}
+	}
+
+	//소멸자에서는 예외를 던질 수 없으므로 쓰기 실패를 알려면 close() 를 먼저 부른다
+	~SegmentedLogWriter() {
+		try {
+			close();
+		}
+		catch (const exception&) {
+		}
+	}
+
+	SegmentedLogWriter(const SegmentedLogWriter&) = delete;
+	SegmentedLogWriter& operator=(const SegmentedLogWriter&) = delete;
+
+	void append(const SensorData& sensorData) {
+		append(SensorDataSpan(&sensorData, 1));
+	}
+
+	void append(SensorDataSpan readings) {
+		const SensorData* pNext = readings.begin();
+		size_t remaining = readings.size();
+		while (remaining > 0) {
+			if (_pFile == nullptr) {
+				openSegment();
+			}
+
+			size_t segmentSpace = static_cast<size_t>(_recordsPerSegment - _segmentRecords);
+			size_t bufferSpace = (_buffer.size() - _bufferUsed) / sizeof(SensorData);
+			size_t count = min(remaining, min(segmentSpace, bufferSpace));
+
+			memcpy(_buffer.data() + _bufferUsed, pNext, count * sizeof(SensorData));
+			_bufferUsed += count * sizeof(SensorData);
+			_segmentRecords += count;
+			_totalRecords += count;
+			pNext += count;
+			remaining -= count;
+
+			if (_segmentRecords == _recordsPerSegment) {
+				closeSegment();
+			}
+			else if (_bufferUsed == _buffer.size()) {
+				flushBuffer();
+			}
+		}
+	}
+
+	//버퍼에 남은 기록을 파일에 쓴다 (세그먼트는 열어 둔다)
+	void flush() {
+		if (_pFile != nullptr) {
+			flushBuffer();
+			fflush(_pFile);
+		}
+	}
+
+	void close() {
+		closeSegment();
+	}
+
+	uint64_t getRecordCount() const {
+		return _totalRecords;
+	}
+
+	uint64_t getBytesWritten() const {
+		return _bytesWritten;
+	}
+
+	uint32_t getSegmentCount() const {
+		return _segmentIndex + (_pFile != nullptr ? 1 : 0);
+	}
+};
+
+//측정값을 받는 대로 기록하는 옵저버
+//변화 감지를 켠 WeatherData 에 달면 값이 그대로인 측정값은 기록되지 않는다
+class RecordingObserver : public IObserver {
+private:
+	SegmentedLogWriter _writer;
+
+public:
+	explicit RecordingObserver(const string& prefix, size_t recordsPerSegment = 1 << 20)
+		: _writer(prefix, recordsPerSegment) {
+	}
+
+	void update(const SensorData& sensorData) override {
+		_writer.append(sensorData);
+	}
+
+	//묶음은 한 번에 버퍼로 복사한다
+	void updateBatch(SensorDataSpan readings) override {
+		_writer.append(readings);
+	}
+
+	SegmentedLogWriter& getWriter() {
+		return _writer;
+	}
+};
+
+//세그먼트 기록을 메모리에 매핑해서 처음부터 순서대로 읽는다
+class SegmentedLogReader {
+private:
+	vector<unique_ptr<SensorRecording>> _segments;
+	size_t _recordCount = 0;
+
+	static bool exists(const string& path) {
+		FILE* pFile = fopen(path.c_str(), "rb");
+		if (pFile == nullptr) {
+			return false;
+		}
+		fclose(pFile);
+		return true;
+	}
+
+public:
+	explicit SegmentedLogReader(const string& prefix) {
+		for (uint32_t segmentIndex = 0; ; segmentIndex++) {
+			string path = SegmentedLogWriter::segmentPath(prefix, segmentIndex);
+			if (!exists(path)) {
+				break;
+			}
+			_segments.push_back(make_unique<SensorRecording>(path));
+			_recordCount += _segments.back()->size();
+		}
+	}
+
+	size_t getSegmentCount() const {
+		return _segments.size();
+	}
+
+	size_t size() const {
+		return _recordCount;
+	}
+
+	//세그먼트마다 매핑된 기록을 복사 없이 넘긴다
+	template <typename Func>
+	void forEachSegment(Func&& func) const {
+		for (const unique_ptr<SensorRecording>& pSegment : _segments) {
+			func(pSegment->getRecords());
+		}
+	}
+};
+
+//시각이 붙은 측정값 (시각은 밀리초)
+struct TimedSensorData {
+	int64_t timestamp;
+	SensorData data;
+};
+
+//64비트 단어에 앞쪽 비트부터 채워 쓴다
+class BitWriter {
+private:
+	vector<uint64_t> _words;
+	uint64_t _current = 0;
+	unsigned _used = 0;	//_current 에 채운 비트 수
+
+public:
+	//value 의 아래 bitCount 비트를 쓴다 (bitCount 는 1~64)
+	void write(uint64_t value, unsigned bitCount) {
+		if (bitCount < 64) {
+			value &= (uint64_t(1) << bitCount) - 1;
+		}
+		unsigned space = 64 - _used;
+		if (bitCount < space) {
+			_current |= value << (space - bitCount);
+			_used += bitCount;
+			return;
+		}
+		unsigned rest = bitCount - space;
+		_current |= value >> rest;
+		_words.push_back(_current);
+		_current = rest == 0 ? 0 : value << (64 - rest);
+		_used = rest;
+	}
+
+	void writeBit(bool bit) {
+		write(bit ? 1 : 0, 1);
+	}
+
+	size_t getBitCount() const {
+		return _words.size() * 64 + _used;
+	}
+
+	//채우던 단어까지 붙여서 꺼낸다 (쓴 내용은 비운다)
+	vector<uint64_t> take() {
+		if (_used > 0) {
+			_words.push_back(_current);
+		}
+		vector<uint64_t> words;
+		words.swap(_words);
+		_current = 0;
+		_used = 0;
+		return words;
+	}
+};
+
+//BitWriter 로 쓴 비트를 같은 순서로 읽는다
+class BitReader {
+private:
+	const uint64_t* _pWords;
+	const uint64_t* _pEnd;
+	uint64_t _current = 0;
+	unsigned _left = 0;	//_current 에 남은 비트 수 (위쪽부터)
+
+	void load() {
+		_current = _pWords != _pEnd ? *_pWords++ : 0;
+		_left = 64;
+	}
+
+public:
+	BitReader(const uint64_t* pWords, size_t wordCount) : _pWords(pWords), _pEnd(pWords + wordCount) {
+	}
+
+	//bitCount 비트를 읽는다 (bitCount 는 1~64)
+	uint64_t read(unsigned bitCount) {
+		if (_left == 0) {
+			load();
+		}
+		if (bitCount <= _left) {
+			uint64_t value = bitCount == 64 ? _current : _current >> (64 - bitCount);
+			_current = bitCount == 64 ? 0 : _current << bitCount;
+			_left -= bitCount;
+			return value;
+		}
+		unsigned rest = bitCount - _left;
+		uint64_t value = _current >> (64 - _left);
+		load();
+		value = (value << rest) | (_current >> (64 - rest));
+		_current <<= rest;
+		_left -= rest;
+		return value;
+	}
+
+	bool readBit() {
+		if (_left == 0) {
+			load();
+		}
+		bool bit = (_current >> 63) != 0;
+		_current <<= 1;
+		_left--;
+		return bit;
+	}
+};
+
+//Gorilla 방식으로 압축한 측정값 묶음
+//첫 측정값은 그대로 쓰고, 그 뒤로는
+// - 시각 : 간격의 차이(delta-of-delta)를 쓴다. 일정한 주기로 재면 대부분 0 이므로 1비트
+// - 값 : 필드마다 앞 값과 XOR 해서 쓴다. 같으면 1비트, 다르면 앞뒤 0 을 빼고 달라진 비트만 쓴다
+//묶음마다 따로 풀 수 있으므로 필요한 구간만 풀면 된다
+struct CompressedBlock {
+	vector<uint64_t> words;
+	uint32_t count = 0;
+	int64_t firstTimestamp = 0;
+	int64_t lastTimestamp = 0;
+
+	size_t getBytes() const {
+		return words.size() * sizeof(uint64_t);
+	}
+};
+
+//측정값을 하나씩 받아 CompressedBlock 으로 압축한다
+class GorillaEncoder {
+private:
+	//필드 하나의 XOR 상태
+	struct FieldState {
+		uint32_t previous = 0;
+		unsigned leading = 33;	//앞 값을 쓸 때의 앞쪽 0 개수 (33 : 아직 없음)
+		unsigned trailing = 0;
+	};
+
+	BitWriter _writer;
+	CompressedBlock _block;
+	int64_t _previousTimestamp = 0;
+	int64_t _previousDelta = 0;
+	FieldState _fields[SENSOR_FIELD_COUNT];
+
+	static uint32_t toBits(float value) {
+		uint32_t bits;
+		memcpy(&bits, &value, sizeof(bits));
+		return bits;
+	}
+
+	void writeTimestamp(int64_t timestamp) {
+		int64_t delta = timestamp - _previousTimestamp;
+		int64_t deltaOfDelta = delta - _previousDelta;
+		_previousTimestamp = timestamp;
+		_previousDelta = delta;
+
+		if (deltaOfDelta == 0) {
+			_writer.write(0b0, 1);
+		}
+		else if (deltaOfDelta >= -63 && deltaOfDelta <= 64) {
+			_writer.write(0b10, 2);
+			_writer.write(static_cast<uint64_t>(deltaOfDelta + 63), 7);
+		}
+		else if (deltaOfDelta >= -255 && deltaOfDelta <= 256) {
+			_writer.write(0b110, 3);
+			_writer.write(static_cast<uint64_t>(deltaOfDelta + 255), 9);
+		}
+		else if (deltaOfDelta >= -2047 && deltaOfDelta <= 2048) {
+			_writer.write(0b1110, 4);
+			_writer.write(static_cast<uint64_t>(deltaOfDelta + 2047), 12);
+		}
+		else {
+			_writer.write(0b1111, 4);
+			_writer.write(static_cast<uint64_t>(deltaOfDelta), 64);
+		}
+	}
+
+	void writeValue(FieldState& field, uint32_t bits) {
+		uint32_t xorBits = bits ^ field.previous;
+		field.previous = bits;
+		if (xorBits == 0) {
+			_writer.writeBit(false);
+			return;
+		}
+		_writer.writeBit(true);
+
+		unsigned leading = 0;
+		while ((xorBits & (0x80000000u >> leading)) == 0) {
+			leading++;
+		}
+		unsigned trailing = 0;
+		while ((xorBits & (1u << trailing)) == 0) {
+			trailing++;
+		}
+
+		//앞 값의 범위 안에 들어가면 범위를 다시 쓰지 않는다
+		if (field.leading <= 32 && leading >= field.leading && trailing >= field.trailing) {
+			_writer.writeBit(false);
+			_writer.write(xorBits >> field.trailing, 32 - field.leading - field.trailing);
+			return;
+		}
+		_writer.writeBit(true);
+		unsigned significant = 32 - leading - trailing;
+		_writer.write(leading, 5);
+		_writer.write(significant - 1, 5);
+		_writer.write(xorBits >> trailing, significant);
+		field.leading = leading;
+		field.trailing = trailing;
+	}
+
+public:
+	void append(int64_t timestamp, const SensorData& sensorData) {
+		uint32_t values[SENSOR_FIELD_COUNT];
+		memcpy(values, &sensorData, sizeof(values));
+
+		if (_block.count == 0) {
+			_block.firstTimestamp = timestamp;
+			_writer.write(static_cast<uint64_t>(timestamp), 64);
+			for (size_t i = 0; i < SENSOR_FIELD_COUNT; i++) {
+				_writer.write(values[i], 32);
+				_fields[i] = FieldState();
+				_fields[i].previous = values[i];
+			}
+			_previousTimestamp = timestamp;
+			_previousDelta = 0;
+		}
+		else {
+			writeTimestamp(timestamp);
+			for (size_t i = 0; i < SENSOR_FIELD_COUNT; i++) {
+				writeValue(_fields[i], values[i]);
+			}
+		}
+		_block.lastTimestamp = timestamp;
+		_block.count++;
+	}
+
+	void append(const TimedSensorData& sample) {
+		append(sample.timestamp, sample.data);
+	}
+
+	uint32_t getCount() const {
+		return _block.count;
+	}
+
+	size_t getBitCount() const {
+		return _writer.getBitCount();
+	}
+
+	//지금까지 압축한 묶음을 꺼내고 새 묶음을 시작한다
+	CompressedBlock finish() {
+		_block.words = _writer.take();
+		CompressedBlock block = move(_block);
+		_block = CompressedBlock();
+		return block;
+	}
+};
+
+//CompressedBlock 을 측정값으로 하나씩 푼다
+class GorillaDecoder {
+private:
+	struct FieldState {
+		uint32_t previous = 0;
+		unsigned leading = 0;
+		unsigned trailing = 0;
+	};
+
+	BitReader _reader;
+	uint32_t _remaining;
+	bool _first = true;
+	int64_t _previousTimestamp = 0;
+	int64_t _previousDelta = 0;
+	FieldState _fields[SENSOR_FIELD_COUNT];
+
+	int64_t readTimestamp() {
+		int64_t deltaOfDelta;
+		if (!_reader.readBit()) {
+			deltaOfDelta = 0;
+		}
+		else if (!_reader.readBit()) {
+			deltaOfDelta = static_cast<int64_t>(_reader.read(7)) - 63;
+		}
+		else if (!_reader.readBit()) {
+			deltaOfDelta = static_cast<int64_t>(_reader.read(9)) - 255;
+		}
+		else if (!_reader.readBit()) {
+			deltaOfDelta = static_cast<int64_t>(_reader.read(12)) - 2047;
+		}
+		else {
+			deltaOfDelta = static_cast<int64_t>(_reader.read(64));
+		}
+		_previousDelta += deltaOfDelta;
+		_previousTimestamp += _previousDelta;
+		return _previousTimestamp;
+	}
+
+	uint32_t readValue(FieldState& field) {
+		if (!_reader.readBit()) {
+			return field.previous;
+		}
+		if (_reader.readBit()) {
+			field.leading = static_cast<unsigned>(_reader.read(5));
+			field.trailing = 32 - field.leading - (static_cast<unsigned>(_reader.read(5)) + 1);
+		}
+		uint32_t xorBits = static_cast<uint32_t>(_reader.read(32 - field.leading - field.trailing)) << field.trailing;
+		field.previous ^= xorBits;
+		return field.previous;
+	}
+
+public:
+	explicit GorillaDecoder(const CompressedBlock& block)
+		: _reader(block.words.data(), block.words.size()), _remaining(block.count) {
+	}
+
+	//다음 측정값을 푼다 (묶음이 끝나면 false)
+	bool next(TimedSensorData& sample) {
+		if (_remaining == 0) {
+			return false;
+		}
+		_remaining--;
+
+		uint32_t values[SENSOR_FIELD_COUNT];
+		if (_first) {
+			_first = false;
+			_previousTimestamp = static_cast<int64_t>(_reader.read(64));
+			for (size_t i = 0; i < SENSOR_FIELD_COUNT; i++) {
+				_fields[i].previous = static_cast<uint32_t>(_reader.read(32));
+				values[i] = _fields[i].previous;
+			}
+		}
+		else {
+			readTimestamp();
+			for (size_t i = 0; i < SENSOR_FIELD_COUNT; i++) {
+				values[i] = readValue(_fields[i]);
+			}
+		}
+		sample.timestamp = _previousTimestamp;
+		memcpy(&sample.data, values, sizeof(values));
+		return true;
+	}
+};
+
+//측정값을 받을 때의 시각과 함께 압축해서 보관하는 옵저버
+//묶음 하나에 samplesPerBlock 개씩 모으고, 다 찬 묶음은 다시 건드리지 않는다
+class CompressedRecordingObserver : public IObserver {
+private:
+	size_t _samplesPerBlock;
+	GorillaEncoder _encoder;
+	vector<CompressedBlock> _blocks;
+	uint64_t _sampleCount = 0;
+
+	static int64_t now() {
+		return chrono::duration_cast<chrono::milliseconds>(chrono::system_clock::now().time_since_epoch()).count();
+	}
+
+public:
+	explicit CompressedRecordingObserver(size_t samplesPerBlock = 4096) : _samplesPerBlock(max<size_t>(samplesPerBlock, 1)) {
+	}
+
+	void update(const SensorData& sensorData) override {
+		append(now(), sensorData);
+	}
+
+	//시각을 직접 정해서 넣는다 (과거 기록을 옮길 때)
+	void append(int64_t timestamp, const SensorData& sensorData) {
+		_encoder.append(timestamp, sensorData);
+		_sampleCount++;
+		if (_encoder.getCount() == _samplesPerBlock) {
+			_blocks.push_back(_encoder.finish());
+		}
+	}
+
+	//채우던 묶음을 닫는다
+	void flush() {
+		if (_encoder.getCount() > 0) {
+			_blocks.push_back(_encoder.finish());
+		}
+	}
+
+	uint64_t getSampleCount() const {
+		return _sampleCount;
+	}
+
+	//닫힌 묶음의 크기 (채우는 중인 묶음은 비트 수로 센다)
+	size_t getCompressedBytes() const {
+		size_t bytes = (_encoder.getBitCount() + 7) / 8;
+		for (const CompressedBlock& block : _blocks) {
+			bytes += block.getBytes();
+		}
+		return bytes;
+	}
+
+	const vector<CompressedBlock>& getBlocks() const {
+		return _blocks;
+	}
+
+	//닫힌 묶음을 순서대로 풀어서 넘긴다 (flush() 뒤에 부르면 전체)
+	template <typename Func>
+	void forEach(Func&& func) const {
+		TimedSensorData sample;
+		for (const CompressedBlock& block : _blocks) {
+			GorillaDecoder decoder(block);
+			while (decoder.next(sample)) {
+				func(sample);
+			}
+		}
+	}
+};
+
+class WeatherStation {
+private:
+	//getTemperature() 등은 const 이지만 난수 상태는 바뀌므로 mutable 로 둔다 (const_cast 불필요)
+	mutable FastRandom _randomTemperature; //온도 난수 객체
+	mutable FastRandom _randomHumidity; //습도 난수 객체
+	mutable FastRandom _randomPressure; //압력 난수 객체
+
+	//기록 파일에서 읽을 때 (nullptr 이면 난수로 만든다)
+	shared_ptr<const SensorRecording> _pRecording;
+	size_t _recordingPosition = 0;
+
+	static uint64_t makeSeed() {
+		random_device rd;
+		return (static_cast<uint64_t>(rd()) << 32) | rd();
+	}
+
+public :
+	//실행할 때마다 다른 값
+	WeatherStation() : WeatherStation(makeSeed()) {
+	}
+
+	//같은 시드면 항상 같은 측정값
+	explicit WeatherStation(uint64_t seed) : _randomTemperature{ -50, 50, seed }
+		, _randomHumidity{ -100, 100, seed + 1 }
+		, _randomPressure{ -100, 100, seed + 2 } {
+	}
+
+	//기록 파일의 측정값을 처음부터 순서대로 돌려준다
+	explicit WeatherStation(shared_ptr<const SensorRecording> pRecording) : WeatherStation(0) {
+		_pRecording = move(pRecording);
+	}
+
+	bool isRecording() const {
+		return _pRecording != nullptr;
+	}
+
+	//다음 측정값을 읽는다 (기록 파일이 끝나면 false)
+	bool read(SensorData& sensorData) {
+		if (_pRecording) {
+			if (_recordingPosition == _pRecording->size()) {
+				return false;
+			}
+			sensorData = _pRecording->at(_recordingPosition++);
+			return true;
+		}
+
+		sensorData.temp = getTemperature();
+		sensorData.humidity = getHumidity();
+		sensorData.pressure = getPressure();
+		sensorData.temp_top = 0.0f;
+		sensorData.temp_bottom = 0.0f;
+		return true;
+	}
+
+	float getTemperature() const {
+		return 25.0f + _randomTemperature.getValue() / 10.0f;
+	}
+	float getHumidity() const {
+		return 60.0f + _randomHumidity.getValue() / 10.0f;
+	};
+	float getPressure() const {
+		return 25.0f +  _randomPressure.getValue() / 10.0f;
+	};
+
+	//필드별로 한꺼번에 채운다 (getTemperature() 등을 차례로 부른 것과 같은 값)
+	void fillTemperatures(FloatSpan out) const {
+		_randomTemperature.fill(out, 25.0f, 10.0f);
+	}
+	void fillHumidities(FloatSpan out) const {
+		_randomHumidity.fill(out, 60.0f, 10.0f);
+	}
+	void fillPressures(FloatSpan out) const {
+		_randomPressure.fill(out, 25.0f, 10.0f);
+	}
+};
+
+
+//출력할 문장을 만드는 버퍼 : clear() 해도 용량을 유지하므로 다시 쓸 때 할당하지 않는다
+class TextBuffer {
+private:
+	vector<char> _data;
+
+public:
+	TextBuffer() {
+		_data.reserve(256);
+	}
+
+	void clear() {
+		_data.clear();
+	}
+
+	const char* data() const {
+		return _data.data();
+	}
+
+	size_t size() const {
+		return _data.size();
+	}
+
+	TextBuffer& operator<<(const char* text) {
+		_data.insert(_data.end(), text, text + strlen(text));
+		return *this;
+	}
+
+	TextBuffer& operator<<(char ch) {
+		_data.push_back(ch);
+		return *this;
+	}
+
+	//cout 의 기본 출력 형식(유효숫자 6자리)과 같게 만든다
+	TextBuffer& operator<<(float value) {
+		return *this << static_cast<double>(value);
+	}
+
+	TextBuffer& operator<<(double value) {
+		char text[32];
+		int length = snprintf(text, sizeof(text), "%g", value);
+		_data.insert(_data.end(), text, text + length);
+		return *this;
+	}
+
+	TextBuffer& operator<<(uint64_t value) {
+		char text[32];
+		int length = snprintf(text, sizeof(text), "%llu", static_cast<unsigned long long>(value));
+		_data.insert(_data.end(), text, text + length);
+		return *this;
+	}
+};
+
+//출력 장치가 쓰는 출력 대상
+//write() 는 내용을 메모리에 복사만 하고 돌아오며, 실제 파일 출력은 별도 쓰기 스레드가 모아서 한다
+//모인 양이 flushBytes 를 넘거나 flushInterval 이 지나면 한 번에 쓰고 비운다
+class OutputSink {
+private:
+	FILE* _pFile;
+	const size_t _flushBytes;
+	const size_t _maxBytes; //쓰기 스레드가 못 따라올 때 여기까지만 쌓고 기다린다
+	const chrono::milliseconds _flushInterval;
+
+	mutex _mutex;
+	condition_variable _wake;
+	condition_variable _drained;
+	vector<char> _front; //write() 가 채우는 버퍼
+	vector<char> _back;  //쓰기 스레드가 출력 중인 버퍼
+	bool _writing = false;
+	bool _flushRequested = false;
+	bool _stop = false;
+
+	uint64_t _flushCount = 0;
+	uint64_t _stallCount = 0;
+
+	thread _writer;
+
+	void writerLoop() {
+		unique_lock<mutex> lock(_mutex);
+		while (true) {
+			_wake.wait_for(lock, _flushInterval, [this] {
+				return _stop || _flushRequested || _front.size() >= _flushBytes;
+			});
+
+			if (_front.empty()) {
+				_flushRequested = false;
+				_drained.notify_all();
+				if (_stop) {
+					break;
+				}
+				continue;
+			}
+
+			//버퍼를 바꿔 끼우고 잠금을 푼 상태에서 출력한다 (그동안 write() 는 새 버퍼에 쌓는다)
+			_front.swap(_back);
+			_writing = true;
+			lock.unlock();
+
+			fwrite(_back.data(), 1, _back.size(), _pFile);
+			fflush(_pFile);
+			_back.clear();
+
+			lock.lock();
+			_writing = false;
+			_flushCount++;
+			_drained.notify_all();
+		}
+	}
+
+public:
+	explicit OutputSink(FILE* pFile, size_t flushBytes = 64 * 1024,
+		chrono::milliseconds flushInterval = chrono::milliseconds(50), size_t maxBytes = 4 * 1024 * 1024)
+		: _pFile(pFile), _flushBytes(flushBytes), _maxBytes(max(maxBytes, flushBytes)), _flushInterval(flushInterval) {
+		_front.reserve(_maxBytes);
+		_back.reserve(_maxBytes);
+		_writer = thread(&OutputSink::writerLoop, this);
+	}
+
+	~OutputSink() {
+		{
+			lock_guard<mutex> lock(_mutex);
+			_stop = true;
+		}
+		_wake.notify_one();
+		_writer.join();
+	}
+
+	OutputSink(const OutputSink&) = delete;
+	OutputSink& operator=(const OutputSink&) = delete;
+
+	//스레드마다 하나씩 있는 문장 버퍼를 비워서 돌려준다
+	static TextBuffer& threadBuffer() {
+		thread_local TextBuffer buffer;
+		buffer.clear();
+		return buffer;
+	}
+
+	void write(const TextBuffer& text) {
+		bool wakeWriter;
+		{
+			unique_lock<mutex> lock(_mutex);
+			if (_front.size() + text.size() > _maxBytes) {
+				_stallCount++;
+				_wake.notify_one();
+				_drained.wait(lock, [this, &text] {
+					return _front.size() + text.size() <= _maxBytes || _front.empty();
+				});
+			}
+			_front.insert(_front.end(), text.data(), text.data() + text.size());
+			wakeWriter = _front.size() >= _flushBytes;
+		}
+		if (wakeWriter) {
+			_wake.notify_one();
+		}
+	}
+
+	//지금까지 쓴 내용이 모두 출력될 때까지 기다린다
+	void flush() {
+		unique_lock<mutex> lock(_mutex);
+		_flushRequested = true;
+		_wake.notify_one();
+		_drained.wait(lock, [this] {
+			return _front.empty() && !_writing;
+		});
+	}
+
+	uint64_t getFlushCount() {
+		lock_guard<mutex> lock(_mutex);
+		return _flushCount;
+	}
+
+	uint64_t getStallCount() {
+		lock_guard<mutex> lock(_mutex);
+		return _stallCount;
+	}
+};
+
+//누적 통계 (Welford 방식)
+//합을 float 로 모으면 측정값이 수백만 개를 넘으면서 작은 값이 더해지지 않고,
+//int 개수는 넘칠 수 있으므로 평균/분산은 double 로 갱신하고 개수는 64비트로 센다
+//최저/최고는 첫 값부터 잡으므로 범위를 미리 가정하지 않는다
+class RunningStatistics {
+private:
+	uint64_t _count = 0;
+	double _mean = 0.0;
+	double _m2 = 0.0; //평균과의 차 제곱의 합
+	double _min = numeric_limits<double>::infinity();
+	double _max = -numeric_limits<double>::infinity();
+
+public:
+	void add(double value) {
+		_count++;
+		double delta = value - _mean;
+		_mean += delta / static_cast<double>(_count);
+		_m2 += delta * (value - _mean);
+		_min = min(_min, value);
+		_max = max(_max, value);
+	}
+
+	//다른 스레드/관측소에서 모은 통계를 합친다
+	void merge(const RunningStatistics& r) {
+		if (r._count == 0) {
+			return;
+		}
+		if (_count == 0) {
+			*this = r;
+			return;
+		}
+
+		uint64_t count = _count + r._count;
+		double delta = r._mean - _mean;
+		_mean += delta * static_cast<double>(r._count) / static_cast<double>(count);
+		_m2 += r._m2 + delta * delta * static_cast<double>(_count) * static_cast<double>(r._count) / static_cast<double>(count);
+		_count = count;
+		_min = min(_min, r._min);
+		_max = max(_max, r._max);
+	}
+
+	uint64_t getCount() const {
+		return _count;
+	}
+
+	double getMean() const {
+		return _mean;
+	}
+
+	//모분산
+	double getVariance() const {
+		return _count > 0 ? _m2 / static_cast<double>(_count) : 0.0;
+	}
+
+	double getStandardDeviation() const {
+		return sqrt(getVariance());
+	}
+
+	double getMin() const {
+		return _min;
+	}
+
+	double getMax() const {
+		return _max;
+	}
+};
+
+//최근 N 개 또는 최근 T 시간 동안의 통계
+//창에서 빠지는 값은 Welford 갱신을 거꾸로 적용해서 평균/분산에서 뺀다
+//최저/최고는 단조 큐로 구한다 : 새 값보다 크지 않은(작지 않은) 값은 다시 최고(최저)가 될 수 없으므로 버린다
+//값마다 큐에 한 번 들어가고 한 번 나오므로 갱신은 분할 상환 O(1) 이다
+class SlidingWindowStatistics {
+private:
+	struct Entry {
+		uint64_t sequence;
+		int64_t time; //steady_clock 나노초
+		double value;
+	};
+
+	size_t _maxCount;            //0 이면 개수 제한 없음
+	chrono::nanoseconds _maxAge; //0 이면 시간 제한 없음
+
+	deque<Entry> _values;
+	deque<Entry> _minQueue; //값이 커지는 순서
+	deque<Entry> _maxQueue; //값이 작아지는 순서
+	uint64_t _sequence = 0;
+	double _mean = 0.0;
+	double _m2 = 0.0;
+	size_t _removedCount = 0; //마지막으로 다시 구한 뒤에 뺀 값 수
+
+	SlidingWindowStatistics(size_t maxCount, chrono::nanoseconds maxAge) : _maxCount(maxCount), _maxAge(maxAge) {
+	}
+
+	void removeFront() {
+		const Entry& entry = _values.front();
+		size_t count = _values.size();
+		if (count == 1) {
+			_mean = 0.0;
+			_m2 = 0.0;
+		}
+		else {
+			//Welford 갱신을 거꾸로 한다 (합을 다시 만들지 않으므로 큰 값끼리 빼는 상쇄가 없다)
+			double oldMean = _mean;
+			_mean -= (entry.value - oldMean) / static_cast<double>(count - 1);
+			_m2 = max(0.0, _m2 - (entry.value - oldMean) * (entry.value - _mean));
+		}
+
+		if (_minQueue.front().sequence == entry.sequence) {
+			_minQueue.pop_front();
+		}
+		if (_maxQueue.front().sequence == entry.sequence) {
+			_maxQueue.pop_front();
+		}
+		_values.pop_front();
+
+		//더하고 빼기를 끝없이 되풀이하면 오차가 쌓이므로 창 크기만큼 뺄 때마다 창에서 다시 구한다 (분할 상환 O(1))
+		if (++_removedCount >= _values.size()) {
+			recompute();
+		}
+	}
+
+	void recompute() {
+		_mean = 0.0;
+		_m2 = 0.0;
+		size_t count = 0;
+		for (const Entry& entry : _values) {
+			count++;
+			double delta = entry.value - _mean;
+			_mean += delta / static_cast<double>(count);
+			_m2 += delta * (entry.value - _mean);
+		}
+		_removedCount = 0;
+	}
+
+	void expire(int64_t now) {
+		while (!_values.empty() && _maxAge.count() > 0 && _values.front().time <= now - _maxAge.count()) {
+			removeFront();
+		}
+	}
+
+public:
+	//최근 count 개
+	static SlidingWindowStatistics lastCount(size_t count) {
+		return SlidingWindowStatistics(max<size_t>(count, 1), chrono::nanoseconds(0));
+	}
+
+	//최근 duration 동안
+	static SlidingWindowStatistics lastDuration(chrono::nanoseconds duration) {
+		return SlidingWindowStatistics(0, duration);
+	}
+
+	void add(double value) {
+		add(value, _maxAge.count() > 0 ? chrono::steady_clock::now() : chrono::steady_clock::time_point());
+	}
+
+	void add(double value, chrono::steady_clock::time_point time) {
+		int64_t now = chrono::duration_cast<chrono::nanoseconds>(time.time_since_epoch()).count();
+		expire(now);
+
+		Entry entry{ _sequence++, now, value };
+		_values.push_back(entry);
+		double delta = value - _mean;
+		_mean += delta / static_cast<double>(_values.size());
+		_m2 += delta * (value - _mean);
+
+		while (!_minQueue.empty() && _minQueue.back().value >= value) {
+			_minQueue.pop_back();
+		}
+		_minQueue.push_back(entry);
+		while (!_maxQueue.empty() && _maxQueue.back().value <= value) {
+			_maxQueue.pop_back();
+		}
+		_maxQueue.push_back(entry);
+
+		if (_maxCount > 0 && _values.size() > _maxCount) {
+			removeFront();
+		}
+	}
+
+	//시간 창은 새 값이 없어도 시간이 지나면 비워진다
+	void advanceTo(chrono::steady_clock::time_point time) {
+		expire(chrono::duration_cast<chrono::nanoseconds>(time.time_since_epoch()).count());
+	}
+
+	uint64_t getCount() const {
+		return _values.size();
+	}
+
+	double getMean() const {
+		return _mean;
+	}
+
+	double getVariance() const {
+		return _values.empty() ? 0.0 : _m2 / static_cast<double>(_values.size());
+	}
+
+	double getMin() const {
+		return _minQueue.empty() ? numeric_limits<double>::quiet_NaN() : _minQueue.front().value;
+	}
+
+	double getMax() const {
+		return _maxQueue.empty() ? numeric_limits<double>::quiet_NaN() : _maxQueue.front().value;
+	}
+};
+
+//스트림 분위수 스케치 (병합형 t-digest)
+//값을 모두 보관하지 않고 가중 중심점(centroid) 목록만 유지한다
+//양 끝(0%, 100% 근처)의 중심점은 작게, 가운데는 크게 묶으므로 p99 같은 꼬리 분위수가 정확하다
+//중심점 수는 compression 에 비례하는 상한이 있어 측정값이 아무리 많아도 메모리가 일정하다
+//새 값은 버퍼에 모았다가 버퍼가 차면 정렬해서 한꺼번에 합친다
+class TDigest {
+private:
+	struct Centroid {
+		double mean;
+		double weight;
+	};
+
+	static constexpr double PI = 3.14159265358979323846;
+
+	double _compression;
+	size_t _bufferLimit;
+	vector<Centroid> _centroids; //평균 순으로 정렬되어 있다
+	vector<Centroid> _buffer;    //아직 합치지 않은 값
+	vector<Centroid> _merged;    //합칠 때 쓰는 작업 공간 (용량을 재사용한다)
+	double _totalWeight = 0.0;
+	double _min = numeric_limits<double>::infinity();
+	double _max = -numeric_limits<double>::infinity();
+
+	//분위수 q 를 눈금 k 로 바꾸는 함수 : 양 끝에서 기울기가 커져 중심점이 작아진다
+	double toScale(double q) const {
+		return _compression / (2.0 * PI) * asin(2.0 * q - 1.0);
+	}
+
+	double fromScale(double k) const {
+		return (sin(k * 2.0 * PI / _compression) + 1.0) / 2.0;
+	}
+
+	void flush() {
+		if (_buffer.empty()) {
+			return;
+		}
+
+		//새 값만 정렬한 뒤 이미 정렬된 중심점과 병합한다
+		auto byMean = [](const Centroid& a, const Centroid& b) {
+			return a.mean < b.mean;
+		};
+		sort(_buffer.begin(), _buffer.end(), byMean);
+		_merged.clear();
+		std::merge(_buffer.begin(), _buffer.end(), _centroids.begin(), _centroids.end(), back_inserter(_merged), byMean);
+
+		double total = 0.0;
+		for (const Centroid& centroid : _merged) {
+			total += centroid.weight;
+		}
+
+		//눈금 k 가 1 늘어나는 구간마다 중심점 하나로 합친다
+		_buffer.clear();
+		Centroid current = _merged.front();
+		double weightSoFar = 0.0;
+		double qLimit = fromScale(toScale(0.0) + 1.0);
+		for (size_t idx = 1; idx < _merged.size(); idx++) {
+			const Centroid& next = _merged[idx];
+			double q = (weightSoFar + current.weight + next.weight) / total;
+			if (q <= qLimit) {
+				current.weight += next.weight;
+				current.mean += (next.mean - current.mean) * next.weight / current.weight;
+			}
+			else {
+				_buffer.push_back(current);
+				weightSoFar += current.weight;
+				qLimit = fromScale(toScale(weightSoFar / total) + 1.0);
+				current = next;
+			}
+		}
+		_buffer.push_back(current);
+
+		_centroids.swap(_buffer);
+		_buffer.clear();
+		_totalWeight = total;
+	}
+
+public:
+	explicit TDigest(double compression = 100.0)
+		: _compression(compression), _bufferLimit(static_cast<size_t>(compression) * 5) {
+		_buffer.reserve(_bufferLimit + static_cast<size_t>(compression) * 2);
+	}
+
+	void add(double value) {
+		_buffer.push_back(Centroid{ value, 1.0 });
+		_min = min(_min, value);
+		_max = max(_max, value);
+		if (_buffer.size() >= _bufferLimit) {
+			flush();
+		}
+	}
+
+	//다른 관측소/스레드의 스케치를 합친다
+	void merge(const TDigest& r) {
+		if (&r == this) {
+			//자기 자신을 합치면 원본을 읽으면서 _buffer 에 넣게 되므로 복사본으로 합친다
+			TDigest copy(r);
+			merge(copy);
+			return;
+		}
+		if (r._centroids.empty() && r._buffer.empty()) {
+			return;
+		}
+		_buffer.insert(_buffer.end(), r._centroids.begin(), r._centroids.end());
+		_buffer.insert(_buffer.end(), r._buffer.begin(), r._buffer.end());
+		_min = min(_min, r._min);
+		_max = max(_max, r._max);
+		flush();
+	}
+
+	//q (0~1) 분위수의 추정값
+	double getQuantile(double q) {
+		flush();
+		if (_centroids.empty()) {
+			return numeric_limits<double>::quiet_NaN();
+		}
+		if (_centroids.size() == 1) {
+			return _centroids.front().mean;
+		}
+
+		//중심점의 가운데를 누적 가중치 위의 점으로 보고 그 사이를 선형 보간한다
+		double target = min(max(q, 0.0), 1.0) * _totalWeight;
+		const Centroid& first = _centroids.front();
+		if (target < first.weight / 2.0) {
+			return _min + (first.mean - _min) * target / (first.weight / 2.0);
+		}
+
+		double center = first.weight / 2.0;
+		for (size_t idx = 1; idx < _centroids.size(); idx++) {
+			const Centroid& previous = _centroids[idx - 1];
+			const Centroid& next = _centroids[idx];
+			double nextCenter = center + (previous.weight + next.weight) / 2.0;
+			if (target < nextCenter) {
+				return previous.mean + (next.mean - previous.mean) * (target - center) / (nextCenter - center);
+			}
+			center = nextCenter;
+		}
+
+		const Centroid& last = _centroids.back();
+		double remaining = _totalWeight - center;
+		return remaining > 0.0 ? last.mean + (_max - last.mean) * (target - center) / remaining : _max;
+	}
+
+	double getCount() {
+		flush();
+		return _totalWeight;
+	}
+
+	size_t getCentroidCount() {
+		flush();
+		return _centroids.size();
+	}
+
+	//보관 중인 바이트 수 (측정값 수와 상관없이 일정하다)
+	size_t getMemoryBytes() const {
+		return (_centroids.capacity() + _buffer.capacity() + _merged.capacity()) * sizeof(Centroid);
+	}
+};
+
+class StatisticsDisplay : public IObserver {
+private:
+	OutputSink& _sink;
+	RunningStatistics _temperature;
+	SlidingWindowStatistics _recentTemperature = SlidingWindowStatistics::lastCount(100);
+
+public:
+	explicit StatisticsDisplay(OutputSink& sink) : _sink(sink) {
+	}
+
+	void update(const SensorData& sensorData) override {
+		update(sensorData.temp, sensorData.humidity, sensorData.pressure);
+	}
+
+	void update(float temp, float humidity, float pressure) {
+		_temperature.add(temp);
+		_recentTemperature.add(temp);
+
+		display();
+	}
+
+	//묶음 전체를 누적한 뒤 한 번만 출력한다
+	void updateBatch(SensorDataSpan readings) override {
+		if (readings.empty()) {
+			return;
+		}
+
+		accumulate(readings);
+		display();
+	}
+
+	//출력 없이 누적만 한다
+	void accumulate(SensorDataSpan readings) {
+		for (const SensorData& sensorData : readings) {
+			_temperature.add(sensorData.temp);
+			_recentTemperature.add(sensorData.temp);
+		}
+	}
+
+	const RunningStatistics& getTemperatureStatistics() const {
+		return _temperature;
+	}
+
+	void display() {
+		TextBuffer& text = OutputSink::threadBuffer();
+		text << "기상 통계 \n"
+			<< "평균 기온 : " << _temperature.getMean() << "℃\n"
+			<< "최저 기온 : " << _temperature.getMin() << "℃\n"
+			<< "최고 기온 : " << _temperature.getMax() << "℃\n"
+			<< "기온 표준편차 : " << _temperature.getStandardDeviation() << "℃\n"
+			<< "최근 " << _recentTemperature.getCount() << "개 평균 기온 : " << _recentTemperature.getMean() << "℃\n\n";
+		_sink.write(text);
+	}
+};
+
+//최근 최고 기온만 보여준다 (개수 창과 시간 창)
+class StatisticsDisplay2 : public IObserver {
+private:
+	OutputSink& _sink;
+	SlidingWindowStatistics _lastReadings;
+	SlidingWindowStatistics _lastSeconds;
+
+public:
+	StatisticsDisplay2(OutputSink& sink, size_t windowCount = 10, chrono::seconds windowDuration = chrono::seconds(60))
+		: _sink(sink)
+		, _lastReadings(SlidingWindowStatistics::lastCount(windowCount))
+		, _lastSeconds(SlidingWindowStatistics::lastDuration(windowDuration)) {
+	}
+
+	void update(const SensorData& sensorData) override {
+		update(sensorData.temp);
+	}
+
+	void update(float temp) {
+		_lastReadings.add(temp);
+		_lastSeconds.add(temp);
+
+		display();
+	}
+
+	void display() {
+		TextBuffer& text = OutputSink::threadBuffer();
+		text << "기상 통계2 \n"
+			<< "최고 기온 (최근 " << _lastReadings.getCount() << "개) : " << _lastReadings.getMax() << "℃\n"
+			<< "최고 기온 (최근 " << _lastSeconds.getCount() << "개, 시간 창) : " << _lastSeconds.getMax() << "℃\n\n";
+		_sink.write(text);
+	}
+};
+
+//기온, 습도, 기압의 p50/p95/p99 를 보여준다
+class QuantileDisplay : public IObserver {
+private:
+	OutputSink& _sink;
+	TDigest _temperature;
+	TDigest _humidity;
+	TDigest _pressure;
+
+	void writeQuantiles(TextBuffer& text, const char* name, TDigest& digest, const char* unit) {
+		text << name << " p50 " << digest.getQuantile(0.50) << unit
+			<< ", p95 " << digest.getQuantile(0.95) << unit
+			<< ", p99 " << digest.getQuantile(0.99) << unit << "\n";
+	}
+
+public:
+	explicit QuantileDisplay(OutputSink& sink, double compression = 100.0)
+		: _sink(sink), _temperature(compression), _humidity(compression), _pressure(compression) {
+	}
+
+	void update(const SensorData& sensorData) override {
+		accumulate(sensorData);
+	}
+
+	void updateBatch(SensorDataSpan readings) override {
+		for (const SensorData& sensorData : readings) {
+			accumulate(sensorData);
+		}
+	}
+
+	void accumulate(const SensorData& sensorData) {
+		_temperature.add(sensorData.temp);
+		_humidity.add(sensorData.humidity);
+		_pressure.add(sensorData.pressure);
+	}
+
+	//다른 관측소/스레드에서 모은 결과를 합친다
+	void merge(const QuantileDisplay& r) {
+		_temperature.merge(r._temperature);
+		_humidity.merge(r._humidity);
+		_pressure.merge(r._pressure);
+	}
+
+	TDigest& getTemperatureSketch() {
+		return _temperature;
+	}
+
+	//분위수는 매번 출력하지 않고 필요할 때 보여준다
+	void display() {
+		TextBuffer& text = OutputSink::threadBuffer();
+		text << "분위수 (측정값 " << static_cast<uint64_t>(_temperature.getCount()) << "개) \n";
+		writeQuantiles(text, "기온", _temperature, "℃");
+		writeQuantiles(text, "습도", _humidity, "%");
+		writeQuantiles(text, "기압", _pressure, "");
+		text << "\n";
+		_sink.write(text);
+	}
+};
+
+class CurrentConditionsDisplay : public IObserver {
+private:
+	OutputSink& _sink;
+	float _temperature = 0.0f;
+	float _humidity = 0.0f;
+	float _pressure = 0.0f;
+
+public:
+	explicit CurrentConditionsDisplay(OutputSink& sink) : _sink(sink) {
+	}
+
+	void update(const SensorData& sensorData) override {
+		update(sensorData.temp, sensorData.humidity, sensorData.pressure);
+	}
+
+	void update(float temperature, float humidity, float pressure) {
+		_temperature = temperature;
+		_humidity = humidity;
+		_pressure = pressure;
+		display();
+	}
+
+	void display() {
+		TextBuffer& text = OutputSink::threadBuffer();
+		text << "현재 조건 \n"
+			<< "온도: " << _temperature << "℃\n"
+			<< "습도: " << _humidity << "%\n"
+			<< "기압: " << _pressure << "\n\n";
+		_sink.write(text);
+	}
+};
+
+class ForecastDisplay : public IObserver {
+private:
+	OutputSink& _sink;
+	float _currentPressure = 29.92f;
+	float _lastPressure = 29.92f;
+
+public:
+	explicit ForecastDisplay(OutputSink& sink) : _sink(sink) {
+	}
+
+	void update(const SensorData& sensorData) override {
+		update(sensorData.temp, sensorData.humidity, sensorData.pressure);
+	}
+
+	void update(float temp, float humidity, float pressure) {
+		_lastPressure = _currentPressure;
+		_currentPressure = pressure;
+
+		display();
+	}
+
+	//예보는 마지막 두 기압만 비교하므로 묶음의 끝부분만 보고 한 번만 출력한다
+	void updateBatch(SensorDataSpan readings) override {
+		if (readings.empty()) {
+			return;
+		}
+
+		_lastPressure = readings.size() >= 2 ? readings[readings.size() - 2].pressure : _currentPressure;
+		_currentPressure = readings.back().pressure;
+
+		display();
+	}
+
+	void display() {
+		TextBuffer& text = OutputSink::threadBuffer();
+		text << "기상 예보\n";
+		if (_currentPressure > _lastPressure) {
+			text << "가는 길에 날씨 개선\n\n";
+		}
+		else if (_currentPressure == _lastPressure) {
+			text << "전과 같음\n\n";
+		}
+		else if (_currentPressure < _lastPressure) {
+			text << "선선하고 비오는 날씨에 조심하십시오\n\n";
+		}
+		_sink.write(text);
+	}
+};
+
+
+
+//여러 스레드가 잠금 없이 최신 측정값을 읽어 가는 시퀀스 잠금(seqlock) 스냅숏
+//쓰기 쪽은 한 스레드(측정 스레드)만 쓴다
+// - 쓰기 : 번호를 홀수로 올리고 값을 쓴 뒤 다시 짝수로 올린다 (읽는 쪽을 기다리지 않는다)
+// - 읽기 : 읽기 전후의 번호가 같고 짝수이면 한 번에 쓰인 값이다 (겹치면 다시 읽는다)
+//읽는 쪽은 잠금도 쓰기도 하지 않으므로 읽는 스레드가 많아도 쓰기 쪽이 느려지지 않는다
+//값은 원자적 단어로 나눠 저장해서 쓰는 중에 읽어도 데이터 경쟁이 아니다
+class SensorSnapshot {
+private:
+	static const size_t WORD_COUNT = sizeof(SensorData) / sizeof(uint32_t);
+	static_assert(sizeof(SensorData) % sizeof(uint32_t) == 0, "SensorData 는 4바이트 단위여야 한다");
+
+	alignas(64) atomic<uint64_t> _sequence{ 0 };
+	atomic<uint32_t> _words[WORD_COUNT];
+
+public:
+	SensorSnapshot() {
+		for (atomic<uint32_t>& word : _words) {
+			word.store(0, memory_order_relaxed);
+		}
+	}
+
+	//측정 스레드만 부른다
+	void store(const SensorData& sensorData) {
+		uint32_t words[WORD_COUNT];
+		memcpy(words, &sensorData, sizeof(SensorData));
+
+		uint64_t sequence = _sequence.load(memory_order_relaxed);
+		_sequence.store(sequence + 1, memory_order_relaxed);
+		atomic_thread_fence(memory_order_release);
+		for (size_t idx = 0; idx < WORD_COUNT; idx++) {
+			_words[idx].store(words[idx], memory_order_relaxed);
+		}
+		_sequence.store(sequence + 2, memory_order_release);
+	}
+
+	//한 번만 시도한다 : 쓰는 중이었으면 false
+	bool tryLoad(SensorData& sensorData, uint64_t& version) const {
+		uint64_t before = _sequence.load(memory_order_acquire);
+		if (before & 1) {
+			return false;
+		}
+
+		uint32_t words[WORD_COUNT];
+		for (size_t idx = 0; idx < WORD_COUNT; idx++) {
+			words[idx] = _words[idx].load(memory_order_relaxed);
+		}
+		atomic_thread_fence(memory_order_acquire);
+		if (_sequence.load(memory_order_relaxed) != before) {
+			return false;
+		}
+
+		memcpy(&sensorData, words, sizeof(SensorData));
+		version = before / 2;
+		return true;
+	}
+
+	//쓰기와 겹치지 않은 값을 읽을 때까지 다시 시도한다
+	SensorData load(uint64_t* pVersion = nullptr) const {
+		SensorData sensorData;
+		uint64_t version;
+		while (!tryLoad(sensorData, version)) {
+			this_thread::yield();
+		}
+		if (pVersion != nullptr) {
+			*pVersion = version;
+		}
+		return sensorData;
+	}
+
+	//지금까지 쓴 횟수 : 마지막으로 읽은 버전과 비교하면 새 값이 있는지 바로 알 수 있다
+	uint64_t getVersion() const {
+		return _sequence.load(memory_order_acquire) / 2;
+	}
+};
+
+class WeatherData : public ISubject {
+private:
+	WeatherStation _weatherStation;
+
+	//ISubject 구현시 사용할 멤버변수
+	//구독 토큰이 weak_ptr 로 가리킬 수 있도록 shared_ptr 로 보관한다
+	shared_ptr<ObserverRegistry> _registry = make_shared<ObserverRegistry>();
+	//subscribe() 로 등록한 콜백
+	shared_ptr<CallbackRegistry> _callbacks = make_shared<CallbackRegistry>();
+
+	SensorData _sensorData{};
+
+	//다른 스레드의 풀(pull) 옵저버가 읽어 가는 최신 측정값
+	SensorSnapshot _snapshot;
+
+	//값이 의미 있게 바뀌었을 때만 알린다
+	ChangeDetector _changeDetector;
+	bool _changeDetection = false;        //setChangeDetection(true) 나 처음 setDeadBand() 를 부르면 켜진다
+	uint64_t _readingCount = 0;
+	uint64_t _suppressedCount = 0;        //바뀐 필드가 없어서 알리지 않은 측정값 수
+	uint64_t _observerCallCount = 0;      //옵저버 update() 호출 수
+
+	//readMeasurementsBatch() 에서 재사용하는 버퍼 (용량을 유지하므로 매번 할당하지 않는다)
+	vector<SensorData> _batch;
+	vector<float> _temperatures;
+	vector<float> _humidities;
+	vector<float> _pressures;
+
+public:
+	WeatherData() = default;
+
+	//같은 시드면 항상 같은 측정값이 나온다
+	explicit WeatherData(uint64_t seed) : _weatherStation(seed) {
+	}
+
+	//기록 파일을 그대로 다시 재생한다
+	explicit WeatherData(shared_ptr<const SensorRecording> pRecording) : _weatherStation(move(pRecording)) {
+	}
+
+	//최신 측정값 (어느 스레드에서 불러도 한 번에 쓰인 값을 복사해서 돌려준다)
+	//observer6 처럼 참조를 돌려주면 측정 스레드가 고치는 도중의 값을 읽을 수 있다
+	SensorData getSensorData() const {
+		return _snapshot.load();
+	}
+
+	//측정값과 그 버전을 함께 읽는다
+	SensorData getSensorData(uint64_t& version) const {
+		return _snapshot.load(&version);
+	}
+
+	//측정값이 바뀔 때마다 1 씩 늘어난다
+	uint64_t getSensorDataVersion() const {
+		return _snapshot.getVersion();
+	}
+
+	//옵저버 등록
+	Subscription registerObserver(shared_ptr<IObserver> pObserver) override {
+		return Subscription(_registry, _registry->insert(move(pObserver)));
+	}
+
+	//관심 있는 필드를 지정해서 등록한다 : 그 필드가 바뀐 측정값만 받는다
+	//예) fieldMask(SensorField::Temp) 이면 기온이 바뀌었을 때만 통보
+	[[nodiscard]] Subscription registerObserver(shared_ptr<IObserver> pObserver, uint32_t interestMask) {
+		return Subscription(_registry, _registry->insert(move(pObserver), interestMask));
+	}
+
+	//조건을 지정해서 등록한다 : 조건의 필드가 바뀌고 조건을 만족할 때만 받는다
+	//예) whenGreater(SensorField::Temp, 30.0f)
+	[[nodiscard]] Subscription registerObserver(shared_ptr<IObserver> pObserver, const FieldPredicate& predicate) {
+		return Subscription(_registry, _registry->insert(move(pObserver), predicate));
+	}
+
+	//false 이면 필드 색인 없이 모든 옵저버의 관심 필드를 검사한다 (비교용)
+	void setIndexedDispatch(bool enabled) {
+		_registry->setIndexedDispatch(enabled);
+	}
+
+	//호출 가능 객체를 등록한다 : 옵저버 클래스나 shared_ptr 없이 콜백만 저장한다
+	//void(const SensorData&) 로 호출할 수 있으면 되고, 캡처가 작으면 할당도 없다
+	[[nodiscard]] Subscription subscribe(SensorCallback callback) {
+		return Subscription(_callbacks, _callbacks->insert(move(callback)));
+	}
+
+	//약한 참조로 등록한다 : 옵저버가 소멸되면 자동으로 구독이 끝난다
+	//(다른 곳에서 옵저버를 놓아주면 다음 통보 때 정리된다)
+	//돌려주는 토큰으로 먼저 해제할 수도 있다. 소멸로만 끝내려면 토큰을 detach() 한다
+	[[nodiscard]] Subscription registerWeakObserver(const shared_ptr<IObserver>& pObserver, uint32_t interestMask = ALL_FIELDS) {
+		return Subscription(_registry, _registry->insertWeak(pObserver, interestMask));
+	}
+
+	//필드별 불감대를 지정한다 (변경 감지가 꺼져 있으면 켠다)
+	void setDeadBand(SensorField field, DeadBand deadBand) {
+		_changeDetector.setDeadBand(field, deadBand);
+		if (!_changeDetection) {
+			setChangeDetection(true);
+		}
+	}
+
+	//true 이면 바뀐 필드가 없는 측정값은 알리지 않는다
+	//기본은 꺼져 있어 모든 측정값을 모든 옵저버에게 알린다 (기록, 통계처럼 측정값을 빠짐없이 받아야 하는 옵저버가 있다)
+	void setChangeDetection(bool enabled) {
+		_changeDetection = enabled;
+		_changeDetector.reset();
+	}
+
+	//옵저버 제거
+	void removeObserver(Subscription& subscription) override {
+		subscription.release();
+	}
+
+	//변경 사실을 알린다 : 모든 필드가 바뀐 것으로 보고 알린다
+	void notifyObserver() override {
+		notifyChangedFields(ALL_FIELDS);
+	}
+
+	//changedFields 가 바뀐 측정값을 알린다 : 바뀐 필드에 관심 있고 조건을 만족하는 옵저버만 받는다 (콜백은 모두 받는다)
+	void notifyChangedFields(uint32_t changedFields) {
+		const SensorData& sensorData = _sensorData;
+		uint64_t callCount = 0;
+		_registry->forEachMatching(changedFields, sensorData, [&sensorData, &callCount](IObserver& observer) {
+			observer.update(sensorData);
+			callCount++;
+		});
+		_observerCallCount += callCount;
+		_callbacks->notify(sensorData);
+	}
+
+	size_t getObserverCount() const {
+		return _registry->size() + _callbacks->size();
+	}
+
+	uint64_t getReadingCount() const {
+		return _readingCount;
+	}
+
+	uint64_t getSuppressedCount() const {
+		return _suppressedCount;
+	}
+
+	uint64_t getObserverCallCount() const {
+		return _observerCallCount;
+	}
+
+	//소멸된 것을 발견해서 정리한 약한 참조 옵저버 수
+	uint64_t getPrunedObserverCount() const {
+		return _registry->getPrunedCount();
+	}
+
+	//등록할 수를 미리 알면 배열 재할당을 피한다
+	void reserveObservers(size_t count) {
+		_registry->reserve(count);
+		_callbacks->reserve(count);
+	}
+
+	//여러 측정값을 옵저버마다 한 번에 알린다 (콜백은 하나씩 받는다)
+	void notifyObserverBatch(SensorDataSpan readings) {
+		_registry->forEach([&readings](IObserver& observer) {
+			observer.updateBatch(readings);
+		});
+		for (const SensorData& sensorData : readings) {
+			_callbacks->notify(sensorData);
+		}
+	}
+
+	//이미 수집된 측정값(밀린 기록 등)을 한 번에 전달한다
+	//묶음은 변경 감지 없이 모든 옵저버에게 그대로 전달한다
+	void replayBatch(SensorDataSpan readings) {
+		if (readings.empty()) {
+			return;
+		}
+		_sensorData = readings.back();
+		_snapshot.store(_sensorData);
+		notifyObserverBatch(readings);
+	}
+
+	float getTemperature() const {
+		return _weatherStation.getTemperature();
+	}
+
+	float getHumidity() const {
+		return _weatherStation.getHumidity();
+	}
+
+	float getPressure() const {
+		return _weatherStation.getPressure();
+	}
+
+	//변경 감지가 켜져 있으면 바뀐 필드가 없을 때 알리지 않는다
+	void measurementsChanged() {
+		_snapshot.store(_sensorData);
+		_readingCount++;
+		uint32_t changedFields = _changeDetection ? _changeDetector.detect(_sensorData) : ALL_FIELDS;
+		if (changedFields == 0) {
+			_suppressedCount++;
+			return;
+		}
+		notifyChangedFields(changedFields);
+	}
+
+	//외부에서 받은 측정값을 알린다
+	void setMeasurements(const SensorData& sensorData) {
+		_sensorData = sensorData;
+		measurementsChanged();
+	}
+
+	//측정값을 읽어서 알린다 (기록 파일이 끝나면 false)
+	bool readMeasurements() {
+		if (!_weatherStation.read(_sensorData)) {
+			return false;
+		}
+
+		measurementsChanged();
+		return true;
+	}
+
+	//측정값이 끝날 때까지 readMeasurements() 를 반복한다
+	//readingsPerSecond 가 0 이면 최대 속도, 아니면 그 속도에 맞춰 기다린다
+	//(난수 모드는 끝이 없으므로 maxReadings 로 횟수를 제한한다)
+	size_t replay(double readingsPerSecond = 0.0, size_t maxReadings = SIZE_MAX) {
+		auto start = chrono::steady_clock::now();
+		size_t count = 0;
+
+		while (count < maxReadings) {
+			if (readingsPerSecond > 0.0) {
+				this_thread::sleep_until(start + chrono::duration_cast<chrono::steady_clock::duration>(
+					chrono::duration<double>(count / readingsPerSecond)));
+			}
+			if (!readMeasurements()) {
+				break;
+			}
+			count++;
+		}
+		return count;
+	}
+
+	//측정값 count 개를 먼저 모두 읽은 뒤 한 번만 알린다
+	//필드별로 난수를 한꺼번에 만든 뒤 측정값 구조체로 옮긴다
+	void readMeasurementsBatch(size_t count) {
+		if (_weatherStation.isRecording()) {
+			_batch.resize(count);
+			size_t readCount = 0;
+			while (readCount < count && _weatherStation.read(_batch[readCount])) {
+				readCount++;
+			}
+			_batch.resize(readCount);
+			replayBatch(_batch);
+			return;
+		}
+
+		_temperatures.resize(count);
+		_humidities.resize(count);
+		_pressures.resize(count);
+		_weatherStation.fillTemperatures(_temperatures);
+		_weatherStation.fillHumidities(_humidities);
+		_weatherStation.fillPressures(_pressures);
+
+		_batch.resize(count);
+		for (size_t idx = 0; idx < count; idx++) {
+			_batch[idx].temp = _temperatures[idx];
+			_batch[idx].humidity = _humidities[idx];
+			_batch[idx].pressure = _pressures[idx];
+			_batch[idx].temp_top = 0.0f;
+			_batch[idx].temp_bottom = 0.0f;
+		}
+
+		replayBatch(_batch);
+	}
+};
+
+//시간 구간별 요약 값 (필드마다 최저, 최고, 평균, 마지막 값)
+struct RollupBucket {
+	int64_t start = 0;	//구간 시작 시각 (밀리초, 구간 폭의 배수)
+	uint32_t count = 0;
+	SensorData min{};
+	SensorData max{};
+	SensorData mean{};
+	SensorData last{};
+};
+
+//하위 옵저버가 받을 요약 값
+enum class RollupValue {
+	Mean,
+	Min,
+	Max,
+	Last,
+};
+
+//WeatherData 와 화면 옵저버 사이에 두는 시간 구간 요약 단계
+//측정값을 받은 시각으로 구간(시각을 구간 폭으로 나눈 몫)을 정하고, 다음 구간의 측정값이 오면 앞 구간을 닫아서
+//구간마다 한 번만 하위 옵저버에게 알린다 (옵저버마다 등록할 때 고른 요약 값 하나)
+// - 구간은 시계 기준으로 나뉘므로 한꺼번에 몰려 온 측정값도 같은 구간이면 한 번에 요약된다
+// - 측정값이 없던 구간은 알리지 않는다
+// - 이미 닫은 구간의 시각으로 늦게 온 측정값은 버리고 개수만 센다
+//측정값 하나를 더할 때는 할당이나 하위 옵저버 호출이 없다
+//요약은 모든 측정값을 받아야 맞으므로 변화 감지를 켠 WeatherData 에 달면 같은 값이 되풀이된 측정값이 빠진다
+class RollupStage : public IObserver, public ISubject {
+private:
+	static const size_t ROLLUP_VALUE_COUNT = 4;
+
+	int64_t _bucketWidth;
+	//요약 값 종류별 하위 옵저버
+	shared_ptr<ObserverRegistry> _registries[ROLLUP_VALUE_COUNT];
+
+	//채우는 중인 구간
+	int64_t _bucketStart = 0;
+	uint32_t _count = 0;
+	float _min[SENSOR_FIELD_COUNT];
+	float _max[SENSOR_FIELD_COUNT];
+	double _sum[SENSOR_FIELD_COUNT];
+	SensorData _last{};
+
+	RollupBucket _closed;	//마지막으로 닫은 구간
+	uint64_t _bucketCount = 0;
+	uint64_t _readingCount = 0;
+	uint64_t _lateCount = 0;
+
+	static int64_t now() {
+		return chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	int64_t bucketOf(int64_t timestamp) const {
+		int64_t quotient = timestamp / _bucketWidth;
+		if (timestamp % _bucketWidth < 0) {
+			quotient--;
+		}
+		return quotient * _bucketWidth;
+	}
+
+	void closeBucket() {
+		_closed.start = _bucketStart;
+		_closed.count = _count;
+		float mean[SENSOR_FIELD_COUNT];
+		for (size_t i = 0; i < SENSOR_FIELD_COUNT; i++) {
+			mean[i] = static_cast<float>(_sum[i] / _count);
+		}
+		memcpy(&_closed.min, _min, sizeof(_closed.min));
+		memcpy(&_closed.max, _max, sizeof(_closed.max));
+		memcpy(&_closed.mean, mean, sizeof(_closed.mean));
+		_closed.last = _last;
+		_count = 0;
+		_bucketCount++;
+		notifyObserver();
+	}
+
+public:
+	explicit RollupStage(chrono::milliseconds bucketWidth) : _bucketWidth(max<int64_t>(bucketWidth.count(), 1)) {
+		for (shared_ptr<ObserverRegistry>& pRegistry : _registries) {
+			pRegistry = make_shared<ObserverRegistry>();
+		}
+	}
+
+	//받은 시각으로 구간을 정한다
+	void update(const SensorData& sensorData) override {
+		add(now(), sensorData);
+	}
+
+	//한꺼번에 온 측정값은 모두 같은 시각으로 본다
+	void updateBatch(SensorDataSpan readings) override {
+		int64_t timestamp = now();
+		for (const SensorData& sensorData : readings) {
+			add(timestamp, sensorData);
+		}
+	}
+
+	//시각을 지정해서 더한다 (밀리초, 기록을 다시 요약할 때)
+	void add(int64_t timestamp, const SensorData& sensorData) {
+		int64_t bucketStart = bucketOf(timestamp);
+		if (_count > 0 && bucketStart != _bucketStart) {
+			if (bucketStart < _bucketStart) {
+				_lateCount++;
+				return;
+			}
+			closeBucket();
+		}
+		else if (_count == 0 && _bucketCount > 0 && bucketStart <= _closed.start) {
+			_lateCount++;
+			return;
+		}
+
+		float values[SENSOR_FIELD_COUNT];
+		memcpy(values, &sensorData, sizeof(values));
+		if (_count == 0) {
+			_bucketStart = bucketStart;
+			for (size_t i = 0; i < SENSOR_FIELD_COUNT; i++) {
+				_min[i] = values[i];
+				_max[i] = values[i];
+				_sum[i] = values[i];
+			}
+		}
+		else {
+			for (size_t i = 0; i < SENSOR_FIELD_COUNT; i++) {
+				_min[i] = min(_min[i], values[i]);
+				_max[i] = max(_max[i], values[i]);
+				_sum[i] += values[i];
+			}
+		}
+		_last = sensorData;
+		_count++;
+		_readingCount++;
+	}
+
+	//시각이 timestamp 까지 지났으면 채우던 구간을 닫는다 (측정값이 뜸할 때 주기적으로 부른다)
+	void advanceTo(int64_t timestamp) {
+		if (_count > 0 && bucketOf(timestamp) > _bucketStart) {
+			closeBucket();
+		}
+	}
+
+	void advance() {
+		advanceTo(now());
+	}
+
+	//시각과 관계없이 채우던 구간을 닫는다 (끝낼 때)
+	void flush() {
+		if (_count > 0) {
+			closeBucket();
+		}
+	}
+
+	//평균을 받는 옵저버로 등록한다
+	Subscription registerObserver(shared_ptr<IObserver> pObserver) override {
+		return registerObserver(move(pObserver), RollupValue::Mean);
+	}
+
+	//받을 요약 값을 골라서 등록한다
+	[[nodiscard]] Subscription registerObserver(shared_ptr<IObserver> pObserver, RollupValue value) {
+		shared_ptr<ObserverRegistry>& pRegistry = _registries[static_cast<size_t>(value)];
+		return Subscription(pRegistry, pRegistry->insert(move(pObserver)));
+	}
+
+	void removeObserver(Subscription& subscription) override {
+		subscription.release();
+	}
+
+	//마지막으로 닫은 구간을 알린다
+	void notifyObserver() override {
+		const SensorData* values[ROLLUP_VALUE_COUNT] = { &_closed.mean, &_closed.min, &_closed.max, &_closed.last };
+		for (size_t i = 0; i < ROLLUP_VALUE_COUNT; i++) {
+			const SensorData& sensorData = *values[i];
+			_registries[i]->forEach([&sensorData](IObserver& observer) {
+				observer.update(sensorData);
+			});
+		}
+	}
+
+	const RollupBucket& getLastBucket() const {
+		return _closed;
+	}
+
+	uint64_t getBucketCount() const {
+		return _bucketCount;
+	}
+
+	uint64_t getReadingCount() const {
+		return _readingCount;
+	}
+
+	uint64_t getLateCount() const {
+		return _lateCount;
+	}
+};
+
+//컴파일할 때 정해진 옵저버들을 값으로 보관하고 직접 호출한다
+//update(const SensorData&) 가 있는 타입이면 되고 IObserver 를 상속하지 않아도 된다
+//타입이 정해져 있으므로 가상 호출이나 shared_ptr 없이 전체 호출이 인라인될 수 있다
+template<typename... Observers>
+class StaticSubject {
+private:
+	tuple<Observers...> _observers;
+
+public:
+	explicit StaticSubject(Observers... observers) : _observers(move(observers)...) {
+	}
+
+	//등록 순서대로 알린다
+	void notifyObserver(const SensorData& sensorData) {
+		apply([&sensorData](Observers&... observers) {
+			(observers.update(sensorData), ...);
+		}, _observers);
+	}
+
+	void notifyObserverBatch(SensorDataSpan readings) {
+		apply([&readings](Observers&... observers) {
+			(observers.updateBatch(readings), ...);
+		}, _observers);
+	}
+
+	template<size_t Index>
+	auto& getObserver() {
+		return get<Index>(_observers);
+	}
+
+	static constexpr size_t getObserverCount() {
+		return sizeof...(Observers);
+	}
+};
+
+//옵저버 구성이 고정된 WeatherData
+template<typename... Observers>
+class StaticWeatherData : public StaticSubject<Observers...> {
+private:
+	WeatherStation _weatherStation;
+	SensorData _sensorData{};
+
+public:
+	explicit StaticWeatherData(Observers... observers) : StaticSubject<Observers...>(move(observers)...) {
+	}
+
+	StaticWeatherData(uint64_t seed, Observers... observers)
+		: StaticSubject<Observers...>(move(observers)...), _weatherStation(seed) {
+	}
+
+	//측정값을 읽어서 알린다 (기록 파일이 끝나면 false)
+	bool readMeasurements() {
+		if (!_weatherStation.read(_sensorData)) {
+			return false;
+		}
+
+		this->notifyObserver(_sensorData);
+		return true;
+	}
+};
+
+
+//여러 관측소 허브
+
+typedef uint32_t StationId;
+
+//허브의 옵저버 : 어느 관측소의 측정값인지 함께 받는다
+class IStationObserver {
+public:
+	virtual ~IStationObserver() = default;
+	virtual void update(StationId stationId, const SensorData& sensorData) = 0;
+};
+
+//관측소 수천 개를 샤드(작업 스레드 하나가 맡는 묶음)로 나눠 가진 허브
+//관측소 id 를 샤드 수로 나눈 나머지가 샤드 번호이고, 한 관측소는 항상 같은 샤드 스레드에서만 측정/통보된다
+//샤드마다 관측소, 옵저버 목록, 카운터를 따로 가지므로 측정/통보 중에는 샤드끼리 공유하는 쓰기가 없다
+//
+//옵저버는 자기 샤드 스레드에서만 불린다
+//여러 샤드에 걸친 구독(관측소 집합, 전체)은 샤드마다 팩토리로 옵저버를 따로 만들어서 공유 상태가 생기지 않게 하고,
+//결과는 run() 이 끝난 뒤 구독 토큰의 getObservers() 로 모아서 합친다
+//구독은 run() 밖에서만 한다 (run() 중에 해제한 구독은 run() 이 끝날 때 지워진다)
+class WeatherHub : public enable_shared_from_this<WeatherHub> {
+public:
+	typedef function<shared_ptr<IStationObserver>()> ObserverFactory;
+
+private:
+	static constexpr uint32_t INVALID_INDEX = UINT32_MAX;
+
+	struct alignas(64) Shard {
+		vector<WeatherStation> stations;             //이 샤드의 관측소 (id = local * 샤드 수 + 샤드 번호)
+		vector<shared_ptr<IStationObserver>> owners; //옵저버 수명 유지 (해제된 자리는 비어 있다)
+		vector<IStationObserver*> observers;         //통보할 때 읽는 포인터
+		vector<uint32_t> freeObservers;
+		vector<vector<uint32_t>> stationObservers;   //관측소별 옵저버 번호
+		vector<uint32_t> allObservers;               //모든 관측소를 받는 옵저버 번호
+		uint64_t readingCount = 0;
+
+		uint32_t addObserver(shared_ptr<IStationObserver> pObserver) {
+			uint32_t index;
+			if (freeObservers.empty()) {
+				index = static_cast<uint32_t>(observers.size());
+				observers.push_back(pObserver.get());
+				owners.push_back(move(pObserver));
+			}
+			else {
+				index = freeObservers.back();
+				freeObservers.pop_back();
+				observers[index] = pObserver.get();
+				owners[index] = move(pObserver);
+			}
+			return index;
+		}
+
+		//더 이상 어디에도 등록되어 있지 않으면 옵저버를 꺼내 돌려준다 (소멸은 부른 쪽이 잠금 밖에서)
+		shared_ptr<IStationObserver> removeObserver(uint32_t index, uint32_t localStation) {
+			vector<uint32_t>& list = localStation == INVALID_INDEX ? allObservers : stationObservers[localStation];
+			list.erase(remove(list.begin(), list.end(), index), list.end());
+
+			//같은 옵저버가 이 샤드의 다른 관측소에도 등록되어 있으면 남겨 둔다
+			if (find(allObservers.begin(), allObservers.end(), index) != allObservers.end()) {
+				return nullptr;
+			}
+			for (const vector<uint32_t>& stationList : stationObservers) {
+				if (find(stationList.begin(), stationList.end(), index) != stationList.end()) {
+					return nullptr;
+				}
+			}
+			observers[index] = nullptr;
+			freeObservers.push_back(index);
+			return move(owners[index]);
+		}
+
+		//모든 관측소를 rounds 번씩 측정해서 알린다
+		void run(size_t rounds, StationId firstId, StationId idStride) {
+			SensorData sensorData{};
+			for (size_t round = 0; round < rounds; round++) {
+				StationId stationId = firstId;
+				for (size_t local = 0; local < stations.size(); local++, stationId += idStride) {
+					stations[local].read(sensorData);
+					for (uint32_t index : stationObservers[local]) {
+						observers[index]->update(stationId, sensorData);
+					}
+					for (uint32_t index : allObservers) {
+						observers[index]->update(stationId, sensorData);
+					}
+				}
+				readingCount += stations.size();
+			}
+		}
+	};
+
+	//샤드 하나에 등록한 항목
+	struct Entry {
+		uint32_t shard;
+		uint32_t observer;
+		uint32_t localStation; //INVALID_INDEX 이면 전체 구독
+	};
+
+	size_t _stationCount;
+	vector<Shard> _shards;
+
+	//구독을 바꾸는 스레드와 run() 을 부른 스레드 사이의 상태
+	mutex _stateMutex;
+	bool _running = false;
+	vector<Entry> _deferredRemovals; //run() 중에 해제된 항목 (run() 이 끝날 때 지운다)
+
+	//_stateMutex 를 잡고 호출한다
+	void checkNotRunning() const {
+		if (_running) {
+			throw runtime_error("측정 중에는 구독을 바꿀 수 없습니다");
+		}
+	}
+
+	void checkStation(StationId stationId) const {
+		if (stationId >= _stationCount) {
+			throw out_of_range("관측소 id 가 범위를 벗어났습니다 : " + to_string(stationId));
+		}
+	}
+
+	//_stateMutex 를 잡고 호출한다 : 꺼낸 옵저버는 released 로 옮긴다
+	void removeEntries(const vector<Entry>& entries, vector<shared_ptr<IStationObserver>>& released) {
+		for (const Entry& entry : entries) {
+			shared_ptr<IStationObserver> pObserver = _shards[entry.shard].removeObserver(entry.observer, entry.localStation);
+			if (pObserver) {
+				released.push_back(move(pObserver));
+			}
+		}
+	}
+
+	//구독 해제 : 측정 중이면 샤드 스레드가 목록을 읽고 있으므로 run() 이 끝날 때까지 미룬다
+	//예외를 던지지 않으므로 run() 중에 토큰이 소멸되어도 된다 (옵저버는 run() 이 끝날 때까지 불릴 수 있다)
+	void unregister(vector<Entry>& entries) {
+		vector<shared_ptr<IStationObserver>> released;
+		{
+			lock_guard<mutex> lock(_stateMutex);
+			if (_running) {
+				_deferredRemovals.insert(_deferredRemovals.end(), entries.begin(), entries.end());
+				return;
+			}
+			removeEntries(entries, released);
+		}
+		//옵저버 소멸자가 다른 토큰을 해제할 수 있으므로 잠금 밖에서 놓아준다
+	}
+
+public:
+	//구독 토큰 : 소멸되거나 release() 를 호출하면 모든 샤드에서 해제된다
+	class Subscription {
+	private:
+		weak_ptr<WeatherHub> _hub;
+		vector<Entry> _entries;
+		vector<shared_ptr<IStationObserver>> _observers; //샤드별로 만든 옵저버 (결과를 모을 때 쓴다)
+
+		friend class WeatherHub;
+
+	public:
+		Subscription() = default;
+		Subscription(const Subscription&) = delete;
+		Subscription& operator=(const Subscription&) = delete;
+		Subscription(Subscription&&) = default;
+
+		Subscription& operator=(Subscription&& r) noexcept {
+			if (this != &r) {
+				release();
+				_hub = move(r._hub);
+				_entries = move(r._entries);
+				_observers = move(r._observers);
+			}
+			return *this;
+		}
+
+		~Subscription() {
+			release();
+		}
+
+		void release() {
+			if (shared_ptr<WeatherHub> pHub = _hub.lock()) {
+				pHub->unregister(_entries);
+			}
+			_hub.reset();
+			_entries.clear();
+		}
+
+		const vector<shared_ptr<IStationObserver>>& getObservers() const {
+			return _observers;
+		}
+	};
+
+	//관측소 id 는 0 ~ stationCount-1, 관측소마다 seed + id 로 측정값을 만든다
+	WeatherHub(size_t stationCount, size_t shardCount, uint64_t seed) : _stationCount(stationCount), _shards(max<size_t>(shardCount, 1)) {
+		for (StationId stationId = 0; stationId < stationCount; stationId++) {
+			Shard& shard = _shards[stationId % _shards.size()];
+			shard.stations.emplace_back(seed + stationId);
+		}
+		for (Shard& shard : _shards) {
+			shard.stationObservers.resize(shard.stations.size());
+		}
+	}
+
+	size_t getStationCount() const {
+		return _stationCount;
+	}
+
+	size_t getShardCount() const {
+		return _shards.size();
+	}
+
+	//관측소 하나를 구독한다 : 옵저버는 그 관측소의 샤드 스레드에서만 불린다
+	[[nodiscard]] Subscription subscribe(StationId stationId, shared_ptr<IStationObserver> pObserver) {
+		checkStation(stationId);
+		Subscription subscription;
+		subscription._entries.reserve(1);
+		subscription._observers.reserve(1);
+		vector<shared_ptr<IStationObserver>> released;
+		{
+			lock_guard<mutex> lock(_stateMutex);
+			checkNotRunning();
+			try {
+				uint32_t shardIndex = static_cast<uint32_t>(stationId % _shards.size());
+				uint32_t localStation = static_cast<uint32_t>(stationId / _shards.size());
+				Shard& shard = _shards[shardIndex];
+				uint32_t observerIndex = shard.addObserver(pObserver);
+				subscription._observers.push_back(move(pObserver));
+				subscription._entries.push_back({ shardIndex, observerIndex, localStation });
+				shard.stationObservers[localStation].push_back(observerIndex);
+			}
+			catch (...) {
+				removeEntries(subscription._entries, released);
+				throw;
+			}
+		}
+		//허브는 잠금을 놓은 뒤에 연결한다 (등록 중에 예외가 나도 토큰 소멸자가 _stateMutex 를 다시 잡지 않는다)
+		subscription._hub = weak_from_this();
+		return subscription;
+	}
+
+	//관측소 집합을 구독한다 : 집합이 걸친 샤드마다 옵저버를 하나씩 만든다
+	//같은 id 가 여러 번 있어도 한 번만 등록한다
+	[[nodiscard]] Subscription subscribe(const vector<StationId>& stationIds, const ObserverFactory& factory) {
+		vector<StationId> uniqueIds(stationIds);
+		sort(uniqueIds.begin(), uniqueIds.end());
+		uniqueIds.erase(unique(uniqueIds.begin(), uniqueIds.end()), uniqueIds.end());
+		for (StationId stationId : uniqueIds) {
+			checkStation(stationId);
+		}
+
+		Subscription subscription;
+		subscription._entries.reserve(uniqueIds.size());
+		subscription._observers.reserve(min(uniqueIds.size(), _shards.size()));
+		vector<shared_ptr<IStationObserver>> released;
+		{
+			lock_guard<mutex> lock(_stateMutex);
+			checkNotRunning();
+			try {
+				vector<uint32_t> shardObservers(_shards.size(), INVALID_INDEX);
+				for (StationId stationId : uniqueIds) {
+					uint32_t shardIndex = static_cast<uint32_t>(stationId % _shards.size());
+					uint32_t localStation = static_cast<uint32_t>(stationId / _shards.size());
+					Shard& shard = _shards[shardIndex];
+					if (shardObservers[shardIndex] == INVALID_INDEX) {
+						shared_ptr<IStationObserver> pObserver = factory();
+						shardObservers[shardIndex] = shard.addObserver(pObserver);
+						subscription._observers.push_back(move(pObserver));
+					}
+					//목록에 넣기 전에 항목부터 남겨서 실패하면 되돌릴 수 있게 한다
+					subscription._entries.push_back({ shardIndex, shardObservers[shardIndex], localStation });
+					shard.stationObservers[localStation].push_back(shardObservers[shardIndex]);
+				}
+			}
+			catch (...) {
+				//factory() 가 던지면 앞서 등록한 항목을 잠금 안에서 되돌린다
+				removeEntries(subscription._entries, released);
+				throw;
+			}
+		}
+		subscription._hub = weak_from_this();
+		return subscription;
+	}
+
+	//모든 관측소를 구독한다 : 샤드마다 옵저버를 하나씩 만든다
+	[[nodiscard]] Subscription subscribeAll(const ObserverFactory& factory) {
+		Subscription subscription;
+		subscription._entries.reserve(_shards.size());
+		subscription._observers.reserve(_shards.size());
+		vector<shared_ptr<IStationObserver>> released;
+		{
+			lock_guard<mutex> lock(_stateMutex);
+			checkNotRunning();
+			try {
+				for (uint32_t shardIndex = 0; shardIndex < _shards.size(); shardIndex++) {
+					shared_ptr<IStationObserver> pObserver = factory();
+					uint32_t observerIndex = _shards[shardIndex].addObserver(pObserver);
+					subscription._observers.push_back(move(pObserver));
+					subscription._entries.push_back({ shardIndex, observerIndex, INVALID_INDEX });
+					_shards[shardIndex].allObservers.push_back(observerIndex);
+				}
+			}
+			catch (...) {
+				removeEntries(subscription._entries, released);
+				throw;
+			}
+		}
+		subscription._hub = weak_from_this();
+		return subscription;
+	}
+
+	//샤드마다 스레드 하나로 모든 관측소를 rounds 번씩 측정하고 끝날 때까지 기다린다
+	void run(size_t rounds) {
+		{
+			lock_guard<mutex> lock(_stateMutex);
+			checkNotRunning();
+			_running = true;
+		}
+
+		vector<thread> workers;
+		for (size_t shardIndex = 1; shardIndex < _shards.size(); shardIndex++) {
+			workers.emplace_back([this, shardIndex, rounds] {
+				_shards[shardIndex].run(rounds, static_cast<StationId>(shardIndex), static_cast<StationId>(_shards.size()));
+			});
+		}
+		//첫 번째 샤드는 부른 스레드에서 처리한다
+		_shards[0].run(rounds, 0, static_cast<StationId>(_shards.size()));
+		for (thread& worker : workers) {
+			worker.join();
+		}
+
+		//측정 중에 해제된 구독을 지운다
+		vector<shared_ptr<IStationObserver>> released;
+		{
+			lock_guard<mutex> lock(_stateMutex);
+			_running = false;
+			removeEntries(_deferredRemovals, released);
+			_deferredRemovals.clear();
+		}
+	}
+
+	uint64_t getReadingCount() const {
+		uint64_t total = 0;
+		for (const Shard& shard : _shards) {
+			total += shard.readingCount;
+		}
+		return total;
+	}
+};
+
+//받은 측정값의 기온을 더하기만 하는 옵저버 (통보 비용을 재기 위한 것)
+class TemperatureSumObserver : public IObserver {
+private:
+	double _sum = 0.0;
+	uint64_t _count = 0;
+
+public:
+	void update(const SensorData& sensorData) override {
+		_sum += sensorData.temp;
+		_count++;
+	}
+
+	uint64_t getCount() const {
+		return _count;
+	}
+};
+
+//평균 1kHz 로 들어오되 가끔 수백 개가 같은 밀리초에 몰려 오는 측정값
+vector<TimedSensorData> makeBurstyReadings(size_t count) {
+	vector<TimedSensorData> samples(count);
+	WeatherStation weatherStation(42);
+	FastRandom burst{ 0, 999, 11 };
+	int64_t timestamp = 0;
+	size_t burstLeft = 0;
+	for (size_t i = 0; i < count; i++) {
+		if (burstLeft > 0) {
+			burstLeft--;
+		}
+		else if (burst.getValue() == 0) {
+			burstLeft = 500;
+			timestamp += 500;
+		}
+		else {
+			timestamp += 1;
+		}
+		samples[i].timestamp = timestamp;
+		weatherStation.read(samples[i].data);
+	}
+	return samples;
+}
+
+//옵저버 수백 개에게 측정값마다 알릴 때와 1초 요약만 알릴 때를 비교한다
+void benchmarkRollup(size_t count, int observerCount) {
+	vector<TimedSensorData> samples = makeBurstyReadings(count);
+
+	WeatherData weatherData(42);
+	weatherData.setChangeDetection(false);
+	vector<shared_ptr<TemperatureSumObserver>> observers;
+	vector<Subscription> subscriptions;
+	for (int i = 0; i < observerCount; i++) {
+		observers.push_back(make_shared<TemperatureSumObserver>());
+		subscriptions.push_back(weatherData.registerObserver(observers.back()));
+	}
+
+	auto start = chrono::steady_clock::now();
+	for (const TimedSensorData& sample : samples) {
+		weatherData.setMeasurements(sample.data);
+	}
+	auto end = chrono::steady_clock::now();
+	double directSeconds = chrono::duration<double>(end - start).count();
+	uint64_t directCalls = weatherData.getObserverCallCount();
+
+	//같은 옵저버를 요약 단계 뒤로 옮긴다 (기록의 시각으로 구간을 정한다)
+	subscriptions.clear();
+	shared_ptr<RollupStage> pRollup = make_shared<RollupStage>(chrono::milliseconds(1000));
+	for (int i = 0; i < observerCount; i++) {
+		subscriptions.push_back(pRollup->registerObserver(observers[i], static_cast<RollupValue>(i % 4)));
+	}
+	int64_t timestamp = 0;
+	Subscription rollupSubscription = weatherData.subscribe([&pRollup, &timestamp](const SensorData& sensorData) {
+		pRollup->add(timestamp, sensorData);
+	});
+
+	start = chrono::steady_clock::now();
+	for (const TimedSensorData& sample : samples) {
+		timestamp = sample.timestamp;
+		weatherData.setMeasurements(sample.data);
+	}
+	pRollup->flush();
+	end = chrono::steady_clock::now();
+	double rollupSeconds = chrono::duration<double>(end - start).count();
+
+	//구간 수는 측정값 시각이 걸친 서로 다른 초의 수와 같아야 한다
+	uint64_t expectedBuckets = 0;
+	for (size_t i = 0; i < samples.size(); i++) {
+		if (i == 0 || samples[i].timestamp / 1000 != samples[i - 1].timestamp / 1000) {
+			expectedBuckets++;
+		}
+	}
+
+	cout << "측정값 " << count << "개, 옵저버 " << observerCount << "개" << endl;
+	cout << "측정값마다 통보 : 옵저버 호출 " << directCalls << "번, " << directSeconds * 1000.0 << "ms" << endl;
+	cout << "1초 요약 통보 : 구간 " << pRollup->getBucketCount() << "개 (예상 " << expectedBuckets << "), 옵저버 호출 "
+		<< pRollup->getBucketCount() * observerCount << "번, " << rollupSeconds * 1000.0 << "ms" << endl;
+}
+
+int main() {
+	{
+		//콘솔 출력도 쓰기 스레드가 모아서 한다
+		OutputSink sink(stdout);
+
+		shared_ptr<WeatherData> pWeatherData = make_shared<WeatherData>(42);
+		pWeatherData->setChangeDetection(false);
+
+		//측정값은 100ms 구간으로 요약되어 화면에 간다 (현재 조건은 평균, 통계는 구간 최고값)
+		shared_ptr<RollupStage> pRollup = make_shared<RollupStage>(chrono::milliseconds(100));
+		Subscription rollupSubscription = pWeatherData->registerObserver(pRollup);
+		Subscription currentConditionsSubscription = pRollup->registerObserver(make_shared<CurrentConditionsDisplay>(sink));
+		Subscription statisticsSubscription = pRollup->registerObserver(make_shared<StatisticsDisplay>(sink), RollupValue::Max);
+
+		for (int i = 0; i < 8; i++) {
+			pWeatherData->readMeasurements();
+			this_thread::sleep_for(chrono::milliseconds(40));
+		}
+		pRollup->flush();
+
+		//cout 과 섞이지 않도록 남은 출력을 먼저 내보낸다
+		sink.flush();
+
+		cout << "측정값 " << pRollup->getReadingCount() << "개 -> 구간 " << pRollup->getBucketCount() << "개" << endl << endl;
+	}
+
+	benchmarkRollup(2000000, 100);
+	return 0;
+}
@@ -0,0 +1,435 @@
+﻿// observer.cpp : 이 파일에는 'main' 함수가 포함됩니다. 거기서 프로그램 실행이 시작되고 종료됩니다.
+//
+
+#include <iostream>
+#include <memory>
+#include <random>
+#include <ctime>
+#include <functional>
+#include <list>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+
+using namespace std;
+
+struct SensorData {
+	float temp;
+	float humidity;
+	float pressure;
+	float temp_top;
+	float temp_bottom;
+};
+
+class IObserver {
+public:
+	virtual void update(const SensorData& sensorData) = 0;
+};
+
+class ISubject {
+
+public:
+	//옵저버 등록
+	virtual void registerObserver(shared_ptr<IObserver> pObserver) = 0;
+
+	//옵저버 제거
+	virtual void removeObserver(shared_ptr<IObserver> pObserver) = 0;
+
+	//변경 사실을 알린다
+	virtual void notifyObserver() = 0;
+};
+
+//등록된 옵저버를 가리키는 핸들 (슬롯 번호 + 세대)
+//제거된 뒤 같은 슬롯이 재사용되면 세대가 달라지므로 예전 핸들은 무효가 된다
+struct ObserverHandle {
+	uint32_t index = UINT32_MAX;
+	uint32_t generation = 0;
+};
+
+//슬롯맵(slot map) 방식의 옵저버 저장소
+//옵저버 포인터는 빈칸 없이 연속된 배열(_observers)에 저장되므로
+//통보 시에는 메모리를 앞에서부터 순서대로 읽기만 한다 (list 노드 추적, shared_ptr 참조 없음)
+class ObserverRegistry {
+private:
+	static const uint32_t INVALID_INDEX = UINT32_MAX;
+
+	struct Slot {
+		uint32_t denseIndex; //_observers 안의 위치 (INVALID_INDEX 이면 빈 슬롯)
+		uint32_t generation; //슬롯 재사용 횟수
+	};
+
+	vector<IObserver*> _observers;         //통보할 때 순회하는 연속 배열
+	vector<shared_ptr<IObserver>> _owners; //수명 유지용 (통보할 때는 읽지 않는다)
+	vector<uint32_t> _denseToSlot;         //_observers 위치 -> 슬롯 번호
+	vector<Slot> _slots;                   //핸들 -> _observers 위치
+	vector<uint32_t> _freeSlots;           //재사용할 빈 슬롯 번호
+
+public:
+	void reserve(size_t count) {
+		_observers.reserve(count);
+		_owners.reserve(count);
+		_denseToSlot.reserve(count);
+		_slots.reserve(count);
+	}
+
+	size_t size() const {
+		return _observers.size();
+	}
+
+	//배열 끝에 추가한다 : O(1)
+	ObserverHandle insert(shared_ptr<IObserver> pObserver) {
+		uint32_t slotIndex;
+		if (_freeSlots.empty()) {
+			slotIndex = static_cast<uint32_t>(_slots.size());
+			_slots.push_back(Slot{ INVALID_INDEX, 0 });
+		}
+		else {
+			slotIndex = _freeSlots.back();
+			_freeSlots.pop_back();
+		}
+
+		Slot& slot = _slots[slotIndex];
+		slot.denseIndex = static_cast<uint32_t>(_observers.size());
+
+		_observers.push_back(pObserver.get());
+		_owners.push_back(move(pObserver));
+		_denseToSlot.push_back(slotIndex);
+
+		return ObserverHandle{ slotIndex, slot.generation };
+	}
+
+	bool contains(ObserverHandle handle) const {
+		return handle.index < _slots.size()
+			&& _slots[handle.index].denseIndex != INVALID_INDEX
+			&& _slots[handle.index].generation == handle.generation;
+	}
+
+	//마지막 원소를 지운 자리로 옮기고(swap and pop) 배열을 줄인다 : O(1)
+	//그래서 제거 후에는 통보 순서가 등록 순서와 달라질 수 있다
+	bool erase(ObserverHandle handle) {
+		if (!contains(handle)) {
+			return false;
+		}
+
+		Slot& slot = _slots[handle.index];
+		uint32_t denseIndex = slot.denseIndex;
+		uint32_t lastIndex = static_cast<uint32_t>(_observers.size() - 1);
+
+		if (denseIndex != lastIndex) {
+			_observers[denseIndex] = _observers[lastIndex];
+			_owners[denseIndex] = move(_owners[lastIndex]);
+			_denseToSlot[denseIndex] = _denseToSlot[lastIndex];
+			_slots[_denseToSlot[denseIndex]].denseIndex = denseIndex;
+		}
+
+		_observers.pop_back();
+		_owners.pop_back();
+		_denseToSlot.pop_back();
+
+		slot.denseIndex = INVALID_INDEX;
+		slot.generation++;
+		_freeSlots.push_back(handle.index);
+		return true;
+	}
+
+	//옵저버 객체로 핸들을 찾는다 (연속 배열을 선형 탐색)
+	ObserverHandle find(const shared_ptr<IObserver>& pObserver) const {
+		for (size_t idx = 0; idx < _observers.size(); idx++) {
+			if (_observers[idx] == pObserver.get()) {
+				uint32_t slotIndex = _denseToSlot[idx];
+				return ObserverHandle{ slotIndex, _slots[slotIndex].generation };
+			}
+		}
+		return ObserverHandle{};
+	}
+
+	template <typename Func>
+	void forEach(Func&& func) const {
+		for (IObserver* pObserver : _observers) {
+			func(*pObserver);
+		}
+	}
+};
+
+class Random {
+private:
+	// 시드값을 얻기 위한 random_device 생성.
+	random_device _rd;
+
+	// random_device 를 통해 난수 생성 엔진을 초기화 한다.
+	// getValue() const 에서 상태를 바꾸므로 mutable 로 선언한다
+	mutable mt19937 _generator;
+
+	// 예 :  0 부터 99 까지 균등하게 나타나는 난수열을 생성하기 위해 균등 분포 정의.
+	mutable uniform_int_distribution<int> _distribution;
+
+public:
+	Random(int from, int to) : _generator{ _rd() },
+		_distribution{from, to} {
+
+	}
+
+	int getValue() const {
+		return _distribution(_generator);
+	}
+};
+
+class WeatherStation {
+private:
+	Random _randomTemperature; //온도 난수 객체
+	Random _randomHumidity; //습도 난수 객체
+	Random _randomPressure; //압력 난수 객체
+
+public :
+	WeatherStation() : _randomTemperature{ -50, 50 }
+		, _randomHumidity{ -100, 100 }
+		, _randomPressure{ -100, 100 } {
+	}
+
+	float getTemperature() const {
+		return 25.0f + _randomTemperature.getValue() / 10.0f;
+	}
+	float getHumidity() const {
+		return 60.0f + _randomHumidity.getValue() / 10.0f;
+	};
+	float getPressure() const {
+		return 25.0f +  _randomPressure.getValue() / 10.0f;
+	};
+
+};
+
+class StatisticsDisplay : public IObserver {
+private:
+	float _maxTemp = 0.0f;
+	float _minTemp = 100.0f;
+	float _tempSum = 0.0f;
+	int _numReadings = 0;
+
+public:
+	void update(const SensorData& sensorData) override {
+		update(sensorData.temp, sensorData.humidity, sensorData.pressure);
+	}
+
+	void update(float temp, float humidity, float pressure) {
+		_tempSum += temp;
+		_numReadings++;
+
+		if (temp > _maxTemp) {
+			_maxTemp = temp;
+		}
+
+		if (temp < _minTemp) {
+			_minTemp = temp;
+		}
+
+		display();
+	}
+
+	void display() {
+		cout << "기상 통계 " << endl
+			<< "평균 기온 : " << (_tempSum / _numReadings) << "℃" << endl
+			<< "최저 기온 : " << _minTemp << "℃" << endl
+			<< "최고 기온 : " << _maxTemp << "℃" << endl << endl;
+	}
+};
+
+class CurrentConditionsDisplay : public IObserver {
+private:
+	float _temperature;
+	float _humidity;
+	float _pressure;
+
+public:
+	void update(const SensorData& sensorData) override {
+		update(sensorData.temp, sensorData.humidity, sensorData.pressure);
+	}
+
+	void update(float temperature, float humidity, float pressure) {
+		_temperature = temperature;
+		_humidity = humidity;
+		_pressure = pressure;
+		display();
+	}
+
+	void display() {
+		cout << "현재 조건 " << endl
+			<< "온도: " << _temperature << "℃" << endl
+			<< "습도: " << _humidity << "%" << endl
+			<< "기압: " << _pressure << endl << endl;
+
+	}
+};
+
+class ForecastDisplay : public IObserver {
+private:
+	float _currentPressure = 29.92f;
+	float _lastPressure;
+
+public:
+	void update(const SensorData& sensorData) override {
+		update(sensorData.temp, sensorData.humidity, sensorData.pressure);
+	}
+
+	void update(float temp, float humidity, float pressure) {
+		_lastPressure = _currentPressure;
+		_currentPressure = pressure;
+
+		display();
+	}
+
+	void display() {
+		cout << "기상 예보" << endl;
+		if (_currentPressure > _lastPressure) {
+			cout << "가는 길에 날씨 개선" << endl << endl;
+		}
+		else if (_currentPressure == _lastPressure) {
+			cout << "전과 같음" << endl << endl;
+		}
+		else if (_currentPressure < _lastPressure) {
+			cout << "선선하고 비오는 날씨에 조심하십시오" << endl << endl;
+		}
+	}
+};
+
+class WeatherData : public ISubject {
+private:
+	WeatherStation _weatherStation;
+
+	//ISubject 구현시 사용할 멤버변수 (list 대신 연속 배열 기반 저장소)
+	ObserverRegistry _registry;
+
+	SensorData _sensorData;
+
+public:
+
+	//옵저버 등록
+	void registerObserver(shared_ptr<IObserver> pObserver) {
+		_registry.insert(move(pObserver));
+	}
+
+	//옵저버 제거
+	void removeObserver(shared_ptr<IObserver> pObserver) {
+		_registry.erase(_registry.find(pObserver));
+	}
+
+	//변경 사실을 알린다
+	void notifyObserver() {
+		const SensorData& sensorData = _sensorData;
+		_registry.forEach([&sensorData](IObserver& observer) {
+			observer.update(sensorData);
+		});
+	}
+
+	float getTemperature() const {
+		return _weatherStation.getTemperature();
+	}
+
+	float getHumidity() const {
+		return _weatherStation.getHumidity();
+	}
+
+	float getPressure() const {
+		return _weatherStation.getPressure();
+	}
+
+	void measurementsChanged() {
+		notifyObserver();
+	}
+
+	void readMeasurements() {
+		_sensorData.temp = _weatherStation.getTemperature();
+		_sensorData.humidity = _weatherStation.getHumidity();
+		_sensorData.pressure = _weatherStation.getPressure();
+
+		measurementsChanged();
+	}
+};
+
+//벤치마크용 옵저버 : 화면 출력 없이 값만 누적한다
+class CountingObserver : public IObserver {
+private:
+	float _sum = 0.0f;
+
+public:
+	void update(const SensorData& sensorData) override {
+		_sum += sensorData.temp;
+	}
+
+	float getSum() const {
+		return _sum;
+	}
+};
+
+//옵저버 1개당 통보 비용(ns)을 list 와 ObserverRegistry 로 각각 측정한다
+void benchmarkNotify(size_t count) {
+	const size_t totalCalls = 20000000;
+	const size_t rounds = totalCalls / count;
+
+	SensorData sensorData{ 25.0f, 60.0f, 25.0f, 0.0f, 0.0f };
+
+	list<shared_ptr<IObserver>> observerList;
+	ObserverRegistry registry;
+	registry.reserve(count);
+
+	for (size_t idx = 0; idx < count; idx++) {
+		shared_ptr<IObserver> pObserver = make_shared<CountingObserver>();
+		observerList.push_back(pObserver);
+		registry.insert(pObserver);
+	}
+
+	auto start = chrono::steady_clock::now();
+	for (size_t round = 0; round < rounds; round++) {
+		for (auto& pObserver : observerList) {
+			pObserver->update(sensorData);
+		}
+	}
+	auto middle = chrono::steady_clock::now();
+	for (size_t round = 0; round < rounds; round++) {
+		registry.forEach([&sensorData](IObserver& observer) {
+			observer.update(sensorData);
+		});
+	}
+	auto end = chrono::steady_clock::now();
+
+	double calls = static_cast<double>(rounds * count);
+	double listNs = chrono::duration<double, nano>(middle - start).count() / calls;
+	double registryNs = chrono::duration<double, nano>(end - middle).count() / calls;
+
+	cout << "옵저버 " << count << "개 : "
+		<< "list " << listNs << " ns/옵저버, "
+		<< "registry " << registryNs << " ns/옵저버" << endl;
+}
+
+int main(int argc, char** argv) {
+
+	shared_ptr<WeatherData> pWeatherData = make_shared<WeatherData>();
+	//출력 장치 객체 생성
+	shared_ptr<StatisticsDisplay> pStatisticsDisplay = make_shared<StatisticsDisplay>();
+	shared_ptr<CurrentConditionsDisplay> pCurrentConditionsDisplay = make_shared<CurrentConditionsDisplay>();
+	shared_ptr<ForecastDisplay> pForecastDisplay = make_shared<ForecastDisplay>();
+
+	//출력 장치를 등록한다
+	pWeatherData->registerObserver(pStatisticsDisplay);
+	pWeatherData->registerObserver(pCurrentConditionsDisplay);
+	pWeatherData->registerObserver(pForecastDisplay);
+
+	//측정값을 읽는다
+	pWeatherData->readMeasurements(); //등록된 3개의 출력 장치에 값을 출력한다
+	pWeatherData->readMeasurements();
+	pWeatherData->readMeasurements();
+
+	//출력 장치를 제거한다
+	pWeatherData->removeObserver(pForecastDisplay);
+
+	//측정값을 읽는다
+	pWeatherData->readMeasurements(); //등록된 2개의 출력 장치에 값을 출력한다
+	pWeatherData->readMeasurements();
+	pWeatherData->readMeasurements();
+
+	//통보 비용 측정
+	benchmarkNotify(10);
+	benchmarkNotify(1000);
+	benchmarkNotify(100000);
+
+	return 0;
+}